@@ -0,0 +1,136 @@
+// Teste de carga do servidor do solucionador. Mantém C conexões em laço
+// fechado, cada uma enviando a mesma instância repetidamente, e informa a
+// vazão e as latências de cauda observadas pelos clientes. Com -m, cada
+// conexão é uma vaga da fila em memória compartilhada, na qual a instância é
+// copiada a cada requisição, permitindo comparar os dois caminhos.
+
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "compartilhada.hpp"
+#include "lote.hpp"
+#include "protocolo.hpp"
+
+int main(int argc, char **argv) {
+  const char *destino = nullptr, *caminho_entrada = nullptr;
+  int num_conexoes = 1, num_requisicoes = 1000;
+  bool compartilhada = false;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-m") == 0) {
+      compartilhada = true;
+    } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+      num_conexoes = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      num_requisicoes = atoi(argv[++i]);
+    } else if (destino == nullptr) {
+      destino = argv[i];
+    } else {
+      caminho_entrada = argv[i];
+    }
+  }
+
+  if (caminho_entrada == nullptr || num_conexoes < 1 || num_requisicoes < 1) {
+    fprintf(stderr,
+            "Uso: %s [-m] SOCKET|MEMORIA ENTRADA [-c CONEXOES] "
+            "[-n REQUISICOES]\n",
+            argv[0]);
+    return 1;
+  }
+
+  FILE *arquivo = fopen(caminho_entrada, "rb");
+  if (arquivo == nullptr) {
+    fprintf(stderr, "Não foi possível ler %s\n", caminho_entrada);
+    return 1;
+  }
+  vector<char> requisicao;
+  char bloco[1 << 16];
+  size_t lidos;
+  while ((lidos = fread(bloco, 1, sizeof(bloco), arquivo)) > 0) {
+    requisicao.insert(requisicao.end(), bloco, bloco + lidos);
+  }
+  fclose(arquivo);
+
+  FilaCompartilhada fila;
+  if (compartilhada &&
+      (!fila.Abre(destino) || requisicao.size() > fila.GetTamanhoVaga())) {
+    fprintf(stderr, "Não foi possível usar a memória compartilhada %s\n",
+            destino);
+    return 1;
+  }
+
+  // Cada conexão envia a sua parte das requisições e guarda as latências em um
+  // vetor próprio, juntado ao final
+  vector<vector<double>> latencias(num_conexoes);
+  vector<int> falhas(num_conexoes, 0);
+  vector<std::thread> threads;
+  auto inicio = std::chrono::steady_clock::now();
+  for (int k = 0; k < num_conexoes; k++) {
+    threads.emplace_back([&, k]() {
+      int fd = -1, vaga = -1;
+      if (compartilhada ? (vaga = fila.ReservaVaga()) < 0
+                        : (fd = ConectaServidor(destino)) < 0) {
+        falhas[k] = 1;
+        return;
+      }
+
+      int parte = num_requisicoes / num_conexoes +
+                  (k < num_requisicoes % num_conexoes ? 1 : 0);
+      vector<char> resposta;
+      for (int r = 0; r < parte; r++) {
+        auto antes = std::chrono::steady_clock::now();
+        bool ok;
+        if (compartilhada) {
+          const char *resultado;
+          size_t tamanho;
+          memcpy(fila.GetVaga(vaga), requisicao.data(), requisicao.size());
+          ok = fila.Submete(vaga, requisicao.size()) &&
+               fila.Aguarda(vaga, resultado, tamanho);
+        } else {
+          uint32_t status;
+          ok = EnviaQuadro(fd, kQuadroOk, requisicao.data(),
+                           requisicao.size()) &&
+               RecebeQuadro(fd, status, resposta) && status == kQuadroOk;
+        }
+        if (!ok) {
+          falhas[k] = 1;
+          break;
+        }
+        latencias[k].push_back(std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - antes)
+                                   .count());
+      }
+      if (compartilhada) {
+        fila.LiberaVaga(vaga);
+      } else {
+        close(fd);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  double segundos = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - inicio)
+                        .count();
+
+  vector<double> todas;
+  int conexoes_com_falha = 0;
+  for (int k = 0; k < num_conexoes; k++) {
+    todas.insert(todas.end(), latencias[k].begin(), latencias[k].end());
+    conexoes_com_falha += falhas[k];
+  }
+
+  printf("conexões: %d\n", num_conexoes);
+  printf("vazão: %.1f requisições/s\n", todas.size() / segundos);
+  ImprimeLatencias(stdout, todas);
+  if (conexoes_com_falha > 0) {
+    printf("conexões com falha: %d\n", conexoes_com_falha);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,129 @@
+// Cliente mínimo do servidor do solucionador. Envia cada arquivo de entrada
+// (ou a entrada padrão) como uma requisição e escreve as soluções na saída
+// padrão. Com -m, usa a fila em memória compartilhada em vez do socket, e as
+// soluções são escritas no formato binário.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+#include "compartilhada.hpp"
+#include "protocolo.hpp"
+
+/// @brief Lê todo o conteúdo de um arquivo.
+/// @param caminho O caminho do arquivo, ou `nullptr` para a entrada padrão
+/// @param dados Recebe o conteúdo do arquivo
+/// @return Se a leitura foi bem sucedida
+static bool LeArquivo(const char *caminho, vector<char> &dados) {
+  FILE *arquivo = caminho == nullptr ? stdin : fopen(caminho, "rb");
+  if (arquivo == nullptr) {
+    return false;
+  }
+
+  dados.clear();
+  char bloco[1 << 16];
+  size_t lidos;
+  while ((lidos = fread(bloco, 1, sizeof(bloco), arquivo)) > 0) {
+    dados.insert(dados.end(), bloco, bloco + lidos);
+  }
+
+  bool ok = !ferror(arquivo);
+  if (arquivo != stdin) {
+    fclose(arquivo);
+  }
+  return ok;
+}
+
+/// @brief Um canal até o servidor: um socket ou uma vaga da memória
+/// compartilhada.
+struct Canal {
+  int fd = -1;
+  FilaCompartilhada fila;
+  int vaga = -1;
+  vector<char> resposta;
+
+  /// @brief Envia uma requisição e espera a resposta.
+  /// @return -1 se o canal falhou, 0 se a resposta é um erro e 1 se é uma
+  /// solução.
+  int Resolve(const vector<char> &requisicao, const char *&resultado,
+              size_t &tamanho) {
+    if (vaga >= 0) {
+      if (requisicao.size() > fila.GetTamanhoVaga()) {
+        resultado = "caixa maior que a vaga";
+        tamanho = strlen(resultado);
+        return 0;
+      }
+      memcpy(fila.GetVaga(vaga), requisicao.data(), requisicao.size());
+      if (!fila.Submete(vaga, requisicao.size())) {
+        return -1;
+      }
+      return fila.Aguarda(vaga, resultado, tamanho) ? 1 : 0;
+    }
+
+    uint32_t status;
+    if (!EnviaQuadro(fd, kQuadroOk, requisicao.data(), requisicao.size()) ||
+        !RecebeQuadro(fd, status, resposta)) {
+      return -1;
+    }
+    resultado = resposta.data();
+    tamanho = resposta.size();
+    return status == kQuadroOk ? 1 : 0;
+  }
+};
+
+int main(int argc, char **argv) {
+  bool compartilhada = argc > 1 && strcmp(argv[1], "-m") == 0;
+  int primeiro = compartilhada ? 2 : 1;
+  if (argc <= primeiro || strcmp(argv[1], "-h") == 0) {
+    fprintf(stderr, "Uso: %s [-m] SOCKET|MEMORIA [ENTRADA...]\n", argv[0]);
+    return argc <= primeiro ? 1 : 0;
+  }
+
+  const char *destino = argv[primeiro];
+  Canal canal;
+  if (compartilhada ? !canal.fila.Abre(destino) ||
+                          (canal.vaga = canal.fila.ReservaVaga()) < 0
+                    : (canal.fd = ConectaServidor(destino)) < 0) {
+    fprintf(stderr, "Não foi possível conectar a %s\n", destino);
+    return 1;
+  }
+
+  int num_arquivos = argc > primeiro + 1 ? argc - primeiro - 1 : 1;
+  vector<char> requisicao;
+  int codigo = 0;
+  for (int i = 0; i < num_arquivos; i++) {
+    const char *caminho =
+        argc > primeiro + 1 ? argv[primeiro + 1 + i] : nullptr;
+    if (!LeArquivo(caminho, requisicao)) {
+      fprintf(stderr, "Não foi possível ler %s\n", caminho);
+      codigo = 1;
+      continue;
+    }
+
+    const char *resultado;
+    size_t tamanho;
+    int situacao = canal.Resolve(requisicao, resultado, tamanho);
+    if (situacao < 0) {
+      fprintf(stderr, "Conexão com o servidor perdida\n");
+      codigo = 1;
+      break;
+    }
+
+    if (situacao > 0) {
+      fwrite(resultado, 1, tamanho, stdout);
+    } else {
+      fprintf(stderr, "%s: %.*s\n", caminho == nullptr ? "-" : caminho,
+              static_cast<int>(tamanho), resultado);
+      codigo = 1;
+    }
+  }
+
+  if (canal.fd >= 0) {
+    close(canal.fd);
+  }
+  if (canal.vaga >= 0) {
+    canal.fila.LiberaVaga(canal.vaga);
+  }
+  return codigo;
+}
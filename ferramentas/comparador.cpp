@@ -0,0 +1,325 @@
+// Comparador de desempenho entre dois binários do solucionador, usado por
+// `make perfcheck` (scripts/perfcheck.sh). Executa os dois binários em cada
+// caso de um corpus, intercalando as execuções para que as variações da
+// máquina afetem ambos por igual, e compara os tempos de parede com o teste
+// de Mann-Whitney e com um intervalo de confiança bootstrap para a
+// aceleração (a razão entre as medianas). Falha se algum caso ficar mais
+// lento do que o limiar com significância estatística, se o binário atual
+// falhar em algum caso ou se nenhum caso puder ser comparado.
+//
+// Cada linha do arquivo de casos tem o nome do caso, o arquivo da caixa, que
+// é passado aos dois binários pela entrada padrão, e os argumentos, separados
+// por espaços. Linhas vazias e começadas por # são ignoradas.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/// @brief Um caso do corpus.
+struct Caso {
+  string nome, entrada;
+  vector<string> argumentos;
+};
+
+/// @brief Opções do comparador.
+struct Opcoes {
+  const char *base = nullptr, *atual = nullptr, *casos = nullptr;
+  int repeticoes = 10;
+
+  // Perda de desempenho tolerada, como fração do tempo da base.
+  double limiar = 0.05;
+
+  // Nível de significância do teste de Mann-Whitney, e confiança do
+  // intervalo bootstrap (1 - alfa).
+  double alfa = 0.01;
+
+  int reamostragens = 2000;
+};
+
+/// @brief Lê os casos de um arquivo.
+/// @return Se o arquivo pôde ser lido
+static bool LeCasos(const char *caminho, vector<Caso> &casos) {
+  FILE *arquivo = fopen(caminho, "r");
+  if (arquivo == nullptr) {
+    return false;
+  }
+
+  char linha[4096];
+  while (fgets(linha, sizeof(linha), arquivo) != nullptr) {
+    std::istringstream campos(linha);
+    Caso caso;
+    if (!(campos >> caso.nome) || caso.nome[0] == '#' ||
+        !(campos >> caso.entrada)) {
+      continue;
+    }
+    for (string argumento; campos >> argumento;) {
+      caso.argumentos.push_back(argumento);
+    }
+    casos.push_back(caso);
+  }
+  fclose(arquivo);
+  return true;
+}
+
+/// @brief Executa um binário com a caixa do caso na entrada padrão e a saída
+/// descartada. A entrada padrão vale tanto para as versões que só a leem
+/// quanto para as que também aceitam o caminho como argumento.
+/// @param segundos Recebe o tempo de parede da execução
+/// @return Se o binário terminou normalmente com código 0
+static bool Executa(const char *programa, const Caso &caso,
+                    double &segundos) {
+  vector<char *> argv = {const_cast<char *>(programa)};
+  for (const string &argumento : caso.argumentos) {
+    argv.push_back(const_cast<char *>(argumento.c_str()));
+  }
+  argv.push_back(nullptr);
+
+  auto inicio = std::chrono::steady_clock::now();
+  pid_t pid = fork();
+  if (pid < 0) {
+    return false;
+  }
+  if (pid == 0) {
+    int entrada = open(caso.entrada.c_str(), O_RDONLY);
+    if (entrada < 0) {
+      _exit(127);
+    }
+    dup2(entrada, STDIN_FILENO);
+    int nulo = open("/dev/null", O_WRONLY);
+    dup2(nulo, STDOUT_FILENO);
+    dup2(nulo, STDERR_FILENO);
+    execv(programa, argv.data());
+    _exit(127);
+  }
+
+  int situacao;
+  while (waitpid(pid, &situacao, 0) < 0) {
+    if (errno != EINTR) {
+      return false;
+    }
+  }
+  segundos = std::chrono::duration<double>(
+                 std::chrono::steady_clock::now() - inicio)
+                 .count();
+  return WIFEXITED(situacao) && WEXITSTATUS(situacao) == 0;
+}
+
+static double Mediana(vector<double> valores) {
+  std::sort(valores.begin(), valores.end());
+  size_t n = valores.size();
+  return n % 2 == 1 ? valores[n / 2]
+                    : (valores[n / 2 - 1] + valores[n / 2]) / 2;
+}
+
+/// @brief Teste de Mann-Whitney bilateral, com a aproximação normal e a
+/// correção para empates.
+/// @return O valor-p de que as duas amostras vêm da mesma distribuição
+static double MannWhitney(const vector<double> &a, const vector<double> &b) {
+  // Ordena as duas amostras juntas, guardando de qual amostra é cada valor
+  vector<std::pair<double, int>> todos;
+  for (double v : a) {
+    todos.push_back({v, 0});
+  }
+  for (double v : b) {
+    todos.push_back({v, 1});
+  }
+  std::sort(todos.begin(), todos.end());
+
+  // Valores empatados recebem a média dos seus postos
+  const double n = todos.size(), na = a.size(), nb = b.size();
+  double soma_postos_a = 0, correcao_empates = 0;
+  for (size_t i = 0; i < todos.size();) {
+    size_t fim = i;
+    while (fim < todos.size() && todos[fim].first == todos[i].first) {
+      fim++;
+    }
+    double posto = (i + 1 + fim) / 2.0, empatados = fim - i;
+    for (size_t k = i; k < fim; k++) {
+      soma_postos_a += todos[k].second == 0 ? posto : 0;
+    }
+    correcao_empates += empatados * empatados * empatados - empatados;
+    i = fim;
+  }
+
+  double u = soma_postos_a - na * (na + 1) / 2;
+  double media = na * nb / 2;
+  double variancia =
+      na * nb / 12 * ((n + 1) - correcao_empates / (n * (n - 1)));
+  if (variancia <= 0) {
+    return 1;
+  }
+  double z = (std::fabs(u - media) - 0.5) / std::sqrt(variancia);
+  return std::erfc(std::max(0.0, z) / std::sqrt(2.0));
+}
+
+/// @brief Gerador splitmix64 das reamostragens, com semente fixa para que o
+/// intervalo seja reprodutível.
+static uint64_t Sorteia(uint64_t &estado) {
+  uint64_t z = (estado += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/// @brief Intervalo de confiança bootstrap por percentis para a aceleração,
+/// a razão entre a mediana da base e a mediana da versão atual.
+static void IntervaloAceleracao(const vector<double> &base,
+                                const vector<double> &atual,
+                                const Opcoes &opcoes, double &inferior,
+                                double &superior) {
+  uint64_t estado = 1;
+  vector<double> razoes, amostra_base(base.size()), amostra_atual(atual.size());
+  for (int r = 0; r < opcoes.reamostragens; r++) {
+    for (double &v : amostra_base) {
+      v = base[Sorteia(estado) % base.size()];
+    }
+    for (double &v : amostra_atual) {
+      v = atual[Sorteia(estado) % atual.size()];
+    }
+    razoes.push_back(Mediana(amostra_base) / Mediana(amostra_atual));
+  }
+  std::sort(razoes.begin(), razoes.end());
+
+  size_t cauda = (size_t)(opcoes.alfa / 2 * razoes.size());
+  inferior = razoes[cauda];
+  superior = razoes[razoes.size() - 1 - cauda];
+}
+
+int main(int argc, char **argv) {
+  Opcoes opcoes;
+  for (int i = 1; i < argc; i++) {
+    bool tem_valor = i + 1 < argc;
+    if (strcmp(argv[i], "-r") == 0 && tem_valor) {
+      opcoes.repeticoes = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-l") == 0 && tem_valor) {
+      opcoes.limiar = atof(argv[++i]) / 100;
+    } else if (strcmp(argv[i], "-a") == 0 && tem_valor) {
+      opcoes.alfa = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-n") == 0 && tem_valor) {
+      opcoes.reamostragens = atoi(argv[++i]);
+    } else if (opcoes.base == nullptr) {
+      opcoes.base = argv[i];
+    } else if (opcoes.atual == nullptr) {
+      opcoes.atual = argv[i];
+    } else if (opcoes.casos == nullptr) {
+      opcoes.casos = argv[i];
+    } else {
+      opcoes.casos = nullptr;
+      break;
+    }
+  }
+
+  vector<Caso> casos;
+  if (opcoes.casos == nullptr || opcoes.repeticoes < 2 ||
+      opcoes.reamostragens < 1 || opcoes.alfa <= 0 || opcoes.alfa >= 1) {
+    fprintf(stderr,
+            "Uso: %s BASE ATUAL CASOS [-r REPETICOES] [-l LIMIAR]\n"
+            "          [-a ALFA] [-n REAMOSTRAGENS]\n"
+            "\n"
+            "Executa os binários BASE e ATUAL, intercalados, REPETICOES\n"
+            "vezes (padrão: 10) em cada caso do arquivo CASOS. Falha se\n"
+            "algum caso ficar mais de LIMIAR%% (padrão: 5) mais lento, com\n"
+            "significância ALFA (padrão: 0.01) no teste de Mann-Whitney e\n"
+            "no intervalo bootstrap de REAMOSTRAGENS (padrão: 2000)\n"
+            "reamostragens, se ATUAL falhar em algum caso ou se nenhum\n"
+            "caso puder ser comparado. Cada linha de CASOS tem o nome, o\n"
+            "arquivo da caixa, lido pela entrada padrão, e os argumentos.\n",
+            argv[0]);
+    return 2;
+  }
+  if (!LeCasos(opcoes.casos, casos)) {
+    fprintf(stderr, "Não foi possível ler %s\n", opcoes.casos);
+    return 2;
+  }
+
+  printf("%-28s %10s %10s %8s %17s %8s  %s\n", "caso", "base (s)",
+         "atual (s)", "acel.", "IC", "p", "veredito");
+  int regressoes = 0, falhas = 0, sem_base = 0, comparados = 0;
+  for (const Caso &caso : casos) {
+    const char *programas[2] = {opcoes.base, opcoes.atual};
+    vector<double> tempos[2];
+
+    // Uma execução de aquecimento de cada, descartada, e depois as
+    // repetições em ordem alternada (ABBA), para que nenhum dos binários
+    // seja sempre o primeiro depois do outro
+    bool ok[2];
+    double segundos;
+    for (int p = 0; p < 2; p++) {
+      ok[p] = Executa(programas[p], caso, segundos);
+    }
+    for (int r = 0; r < opcoes.repeticoes && ok[0] && ok[1]; r++) {
+      for (int k = 0; k < 2; k++) {
+        int p = (r + k) % 2;
+        ok[p] = Executa(programas[p], caso, segundos);
+        if (!ok[p]) {
+          break;
+        }
+        tempos[p].push_back(segundos);
+      }
+    }
+
+    // Uma falha do binário atual reprova a verificação. Uma base que não
+    // aceita o caso (por exemplo, anterior a uma opção) apenas o deixa de
+    // fora da comparação.
+    if (!ok[1] || !ok[0]) {
+      printf("%-28s %10s %10s %8s %17s %8s  %s\n", caso.nome.c_str(), "-",
+             "-", "-", "-", "-", !ok[1] ? "FALHOU" : "sem base");
+      if (!ok[1]) {
+        falhas++;
+      } else {
+        sem_base++;
+      }
+      fflush(stdout);
+      continue;
+    }
+    comparados++;
+
+    double mediana_base = Mediana(tempos[0]);
+    double mediana_atual = Mediana(tempos[1]);
+    double inferior, superior;
+    IntervaloAceleracao(tempos[0], tempos[1], opcoes, inferior, superior);
+    double p = MannWhitney(tempos[0], tempos[1]);
+
+    // Regressão: a versão atual é significativamente mais lenta, e mesmo o
+    // extremo otimista do intervalo está além do limiar
+    const char *veredito = "ok";
+    if (p < opcoes.alfa && superior < 1 / (1 + opcoes.limiar)) {
+      veredito = "REGRESSAO";
+      regressoes++;
+    } else if (p < opcoes.alfa && inferior > 1) {
+      veredito = "melhora";
+    }
+
+    char intervalo[32];
+    snprintf(intervalo, sizeof(intervalo), "[%.3f, %.3f]", inferior,
+             superior);
+    printf("%-28s %10.4f %10.4f %7.3fx %17s %8.4f  %s\n", caso.nome.c_str(),
+           mediana_base, mediana_atual, mediana_base / mediana_atual,
+           intervalo, p, veredito);
+    fflush(stdout);
+  }
+
+  printf("\n%zu casos, %d comparados, %d regressões acima de %.1f%%, "
+         "%d falhas, %d sem base (IC de %.0f%%)\n",
+         casos.size(), comparados, regressoes, opcoes.limiar * 100, falhas,
+         sem_base, (1 - opcoes.alfa) * 100);
+  if (comparados == 0) {
+    fprintf(stderr, "Nenhum caso pôde ser comparado\n");
+  }
+  return regressoes > 0 || falhas > 0 || comparados == 0 ? 1 : 0;
+}
@@ -0,0 +1,409 @@
+// Suíte de desempenho de ponta a ponta (`make bench`). Resolve uma matriz fixa
+// de caixas do gerador de instâncias (de 4 a 20 colunas, de 10 a 10**6 linhas
+// e densidades variadas) com cada motor, repetindo cada caso depois de um
+// aquecimento, e registra o tempo de parede (mediana e percentis), o pico de
+// memória residente, os estados calculados e o tamanho da memoização. Casos
+// que não caberiam no limite de memória ou de operações, pela estimativa do
+// próprio solucionador, são registrados como ignorados. Os resultados são
+// escritos em CSV e/ou JSON.
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+#include "cifra.hpp"
+#include "gerador.hpp"
+
+/// @brief Largura e sementes da busca em feixe medida pela suíte.
+static const int kLarguraFeixe = 4, kSementesFeixe = 2;
+
+/// @brief Motores medidos pela suíte.
+enum MotorSuite { kSuiteMemoizacao, kSuiteProdutos, kSuiteAutomatico,
+                  kSuiteFeixe, kNumMotoresSuite };
+
+static const char *const kNomesMotores[kNumMotoresSuite] = {
+    "memoizacao", "produtos", "automatico", "feixe"};
+
+/// @brief Uma caixa da matriz de casos.
+struct Caso {
+  FamiliaGerador familia;
+  int L, C;
+  double densidade;
+};
+
+/// @brief Opções da suíte.
+struct Opcoes {
+  int aquecimento = 1, repeticoes = 5;
+
+  // Tempo máximo, em segundos, das repetições de um caso. Casos lentos são
+  // repetidos menos vezes, mas sempre ao menos `kMinRepeticoes`.
+  double orcamento = 10;
+
+  // Limites acima dos quais um caso é ignorado.
+  double limite_bytes = 1024.0 * 1024 * 1024, limite_operacoes = 2e9;
+
+  // Indica que apenas a matriz reduzida deve ser usada.
+  bool rapida = false;
+
+  const char *csv = nullptr, *json = nullptr;
+};
+
+/// @brief Número mínimo de repetições de um caso medido.
+static const int kMinRepeticoes = 3;
+
+/// @brief Resultado das medições de um caso com um motor.
+struct Medicao {
+  Caso caso;
+  int motor;
+
+  // Indica que o caso foi ignorado, por exceder os limites.
+  bool ignorado = false;
+
+  // Tempos de cada repetição, em segundos, em ordem crescente.
+  vector<double> tempos;
+
+  // Pico de memória residente, em KiB, e se ele é do caso (ou do processo
+  // inteiro, quando o pico não pode ser reiniciado).
+  long rss_pico = 0;
+  bool rss_do_caso = true;
+
+  long long estados = 0, valor = 0;
+  size_t bytes_memo = 0;
+};
+
+/// @brief Monta a matriz de casos: caixas uniformes de duas densidades e
+/// caixas de faixas, para cada número de colunas e de linhas.
+static vector<Caso> MontaCasos(bool rapida) {
+  vector<int> colunas = {4, 8, 12, 16, 20}, linhas = {10, 1000, 1000000};
+  if (rapida) {
+    colunas = {4, 8, 12};
+    linhas = {10, 1000};
+  }
+
+  vector<Caso> casos;
+  for (int C : colunas) {
+    for (int L : linhas) {
+      casos.push_back({kFamiliaUniforme, L, C, 0.5});
+      casos.push_back({kFamiliaUniforme, L, C, 0.9});
+      casos.push_back({kFamiliaFaixas, L, C, 0.9});
+    }
+  }
+  return casos;
+}
+
+/// @brief Reinicia o pico de memória residente do processo.
+/// @return Se o pico pôde ser reiniciado
+static bool ReiniciaPicoRss() {
+  FILE *arquivo = fopen("/proc/self/clear_refs", "w");
+  if (arquivo == nullptr) {
+    return false;
+  }
+  bool ok = fputs("5", arquivo) >= 0;
+  return fclose(arquivo) == 0 && ok;
+}
+
+/// @brief Retorna o pico de memória residente do processo, em KiB.
+static long PicoRss() {
+  FILE *arquivo = fopen("/proc/self/status", "r");
+  long pico = -1;
+  if (arquivo != nullptr) {
+    char linha[256];
+    while (fgets(linha, sizeof(linha), arquivo) != nullptr) {
+      if (strncmp(linha, "VmHWM:", 6) == 0) {
+        sscanf(linha + 6, "%ld", &pico);
+      }
+    }
+    fclose(arquivo);
+  }
+  if (pico < 0) {
+    struct rusage uso;
+    getrusage(RUSAGE_SELF, &uso);
+    pico = uso.ru_maxrss;
+  }
+  return pico;
+}
+
+/// @brief Verifica se um caso cabe nos limites, pela estimativa de custo.
+static bool CabeNosLimites(Cifra &modelo, int motor, const Opcoes &opcoes) {
+  const Caixa &caixa = modelo.GetCaixa();
+
+  // Os valores das soluções são `int`, então a soma dos brilhos da caixa
+  // também precisa caber em um
+  long long soma = 0;
+  for (int i = 0; i < caixa.GetL(); i++) {
+    for (int j = 0; j < caixa.GetC(); j++) {
+      soma += std::max(0, caixa.Brilho(i, j));
+    }
+  }
+  if (soma > INT_MAX) {
+    return false;
+  }
+
+  if (motor == kSuiteFeixe) {
+    double operacoes = 2.0 * caixa.GetL() * caixa.GetC() * kLarguraFeixe *
+                       (kSementesFeixe + 1);
+    return operacoes <= opcoes.limite_operacoes;
+  }
+
+  // A estimativa monta o plano de topologia, que sozinho pode não caber na
+  // memória em caixas enormes sem linhas repetidas
+  CustoResolucao custo;
+  try {
+    custo = modelo.EstimaCusto();
+  } catch (const std::bad_alloc &) {
+    return false;
+  }
+  bool memoizacao = custo.bytes_memoizacao <= opcoes.limite_bytes &&
+                    custo.memoizacao <= opcoes.limite_operacoes;
+  bool produtos = custo.cabem_produtos &&
+                  custo.produtos <= opcoes.limite_operacoes;
+  switch (motor) {
+    case kSuiteMemoizacao:
+      return memoizacao;
+    case kSuiteProdutos:
+      return produtos;
+    default:
+      return custo.cabem_produtos && custo.produtos < custo.memoizacao
+                 ? produtos
+                 : memoizacao;
+  }
+}
+
+/// @brief Resolve a caixa do modelo uma vez com um motor, com um problema
+/// novo que aponta para a caixa do modelo.
+/// @return O tempo de parede da resolução, em segundos
+static double Executa(Cifra &modelo, int motor, Medicao &medicao) {
+  const Caixa &caixa = modelo.GetCaixa();
+  Cifra cifra;
+  auto inicio = std::chrono::steady_clock::now();
+  cifra.Associa(caixa.GetL(), caixa.GetC(), modelo.GetNumCristais(),
+                caixa.GetBrilhos(), caixa.GetConexoes());
+  switch (motor) {
+    case kSuiteMemoizacao:
+      cifra.Resolve(kMotorMemoizacao);
+      break;
+    case kSuiteProdutos:
+      cifra.Resolve(kMotorProdutos);
+      break;
+    case kSuiteAutomatico:
+      cifra.Resolve(kMotorAutomatico);
+      break;
+    default:
+      cifra.ResolveFeixe(kLarguraFeixe, kSementesFeixe);
+      break;
+  }
+  double segundos = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - inicio)
+                        .count();
+
+  medicao.estados = cifra.GetEstadosCalculados();
+  medicao.bytes_memo = cifra.GetBytesMemoizacao();
+  medicao.valor = cifra.GetValoresSolucao().second;
+  return segundos;
+}
+
+/// @brief Mede um caso com um motor: aquecimento seguido das repetições.
+static Medicao Mede(Cifra &modelo, const Caso &caso, int motor,
+                    const Opcoes &opcoes) {
+  Medicao medicao;
+  medicao.caso = caso;
+  medicao.motor = motor;
+  if (!CabeNosLimites(modelo, motor, opcoes)) {
+    medicao.ignorado = true;
+    return medicao;
+  }
+
+  double aquecimento = 0;
+  for (int r = 0; r < opcoes.aquecimento; r++) {
+    aquecimento = Executa(modelo, motor, medicao);
+  }
+
+  int repeticoes = opcoes.repeticoes;
+  if (aquecimento > 0 && aquecimento * repeticoes > opcoes.orcamento) {
+    repeticoes = std::max(kMinRepeticoes, (int)(opcoes.orcamento /
+                                                aquecimento));
+    repeticoes = std::min(repeticoes, opcoes.repeticoes);
+  }
+
+  for (int r = 0; r < repeticoes; r++) {
+    medicao.rss_do_caso = ReiniciaPicoRss() && medicao.rss_do_caso;
+    medicao.tempos.push_back(Executa(modelo, motor, medicao));
+    medicao.rss_pico = std::max(medicao.rss_pico, PicoRss());
+  }
+  std::sort(medicao.tempos.begin(), medicao.tempos.end());
+  return medicao;
+}
+
+/// @brief Retorna o percentil `p` (entre 0 e 1) de tempos ordenados, pelo
+/// posto mais próximo.
+static double Percentil(const vector<double> &tempos, double p) {
+  size_t posicao = (size_t)(p * (tempos.size() - 1) + 0.5);
+  return tempos[std::min(posicao, tempos.size() - 1)];
+}
+
+/// @brief Nomes das colunas do CSV, que também são as chaves do JSON.
+static const char *const kCampos[] = {
+    "familia",   "L",          "C",          "densidade",    "motor",
+    "situacao",  "repeticoes", "mediana_s",  "p10_s",        "p90_s",
+    "minimo_s",  "maximo_s",   "rss_pico_kib", "rss_do_caso", "estados",
+    "bytes_memo", "valor"};
+static const int kNumCampos = sizeof(kCampos) / sizeof(kCampos[0]);
+
+/// @brief Formata os campos de uma medição, na ordem de `kCampos`. Os campos
+/// numéricos de casos ignorados ficam vazios.
+static vector<std::string> Campos(const Medicao &medicao) {
+  char texto[64];
+  auto numero = [&](const char *formato, auto valor) {
+    snprintf(texto, sizeof(texto), formato, valor);
+    return std::string(texto);
+  };
+
+  vector<std::string> campos = {
+      NomeFamilia(medicao.caso.familia),
+      numero("%d", medicao.caso.L),
+      numero("%d", medicao.caso.C),
+      numero("%.2f", medicao.caso.densidade),
+      kNomesMotores[medicao.motor],
+      medicao.ignorado ? "ignorado" : "medido"};
+  if (medicao.ignorado) {
+    campos.resize(kNumCampos);
+    return campos;
+  }
+
+  const vector<double> &tempos = medicao.tempos;
+  campos.push_back(numero("%zu", tempos.size()));
+  campos.push_back(numero("%.6f", Percentil(tempos, 0.5)));
+  campos.push_back(numero("%.6f", Percentil(tempos, 0.1)));
+  campos.push_back(numero("%.6f", Percentil(tempos, 0.9)));
+  campos.push_back(numero("%.6f", tempos.front()));
+  campos.push_back(numero("%.6f", tempos.back()));
+  campos.push_back(numero("%ld", medicao.rss_pico));
+  campos.push_back(medicao.rss_do_caso ? "1" : "0");
+  campos.push_back(numero("%lld", medicao.estados));
+  campos.push_back(numero("%zu", medicao.bytes_memo));
+  campos.push_back(numero("%lld", medicao.valor));
+  return campos;
+}
+
+static void EscreveCsv(FILE *arquivo, const vector<Medicao> &medicoes) {
+  for (int c = 0; c < kNumCampos; c++) {
+    fprintf(arquivo, "%s%c", kCampos[c], c + 1 < kNumCampos ? ',' : '\n');
+  }
+  for (const Medicao &medicao : medicoes) {
+    vector<std::string> campos = Campos(medicao);
+    for (int c = 0; c < kNumCampos; c++) {
+      fprintf(arquivo, "%s%c", campos[c].c_str(),
+              c + 1 < kNumCampos ? ',' : '\n');
+    }
+  }
+}
+
+static void EscreveJson(FILE *arquivo, const vector<Medicao> &medicoes) {
+  // Os campos de texto são as cinco primeiras colunas e a situação; os
+  // demais são números, ou `null` em casos ignorados
+  fprintf(arquivo, "{\"casos\": [\n");
+  for (size_t m = 0; m < medicoes.size(); m++) {
+    vector<std::string> campos = Campos(medicoes[m]);
+    fprintf(arquivo, "  {");
+    for (int c = 0; c < kNumCampos; c++) {
+      bool texto = c == 0 || c == 4 || c == 5;
+      const char *valor = campos[c].empty() ? "null" : campos[c].c_str();
+      fprintf(arquivo, "\"%s\": %s%s%s%s", kCampos[c], texto ? "\"" : "",
+              valor, texto ? "\"" : "", c + 1 < kNumCampos ? ", " : "");
+    }
+    fprintf(arquivo, "}%s\n", m + 1 < medicoes.size() ? "," : "");
+  }
+  fprintf(arquivo, "]}\n");
+}
+
+/// @brief Escreve os resultados em um arquivo, no formato escolhido.
+static bool EscreveResultados(const char *caminho, bool json,
+                              const vector<Medicao> &medicoes) {
+  FILE *arquivo = strcmp(caminho, "-") == 0 ? stdout : fopen(caminho, "w");
+  if (arquivo == nullptr) {
+    fprintf(stderr, "Não foi possível escrever %s\n", caminho);
+    return false;
+  }
+  json ? EscreveJson(arquivo, medicoes) : EscreveCsv(arquivo, medicoes);
+  return arquivo == stdout ? fflush(arquivo) == 0 : fclose(arquivo) == 0;
+}
+
+int main(int argc, char **argv) {
+  Opcoes opcoes;
+  for (int i = 1; i < argc; i++) {
+    bool tem_valor = i + 1 < argc;
+    if (strcmp(argv[i], "-r") == 0 && tem_valor) {
+      opcoes.repeticoes = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "-a") == 0 && tem_valor) {
+      opcoes.aquecimento = std::max(0, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "-t") == 0 && tem_valor) {
+      opcoes.orcamento = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--limite-memoria") == 0 && tem_valor) {
+      opcoes.limite_bytes = atof(argv[++i]) * 1024 * 1024;
+    } else if (strcmp(argv[i], "--limite-operacoes") == 0 && tem_valor) {
+      opcoes.limite_operacoes = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-q") == 0) {
+      opcoes.rapida = true;
+    } else if (strcmp(argv[i], "--csv") == 0 && tem_valor) {
+      opcoes.csv = argv[++i];
+    } else if (strcmp(argv[i], "--json") == 0 && tem_valor) {
+      opcoes.json = argv[++i];
+    } else {
+      fprintf(stderr,
+              "Uso: %s [-q] [-r REPETICOES] [-a AQUECIMENTO] [-t SEGUNDOS]\n"
+              "          [--limite-memoria MIB] [--limite-operacoes N]\n"
+              "          [--csv ARQ] [--json ARQ]\n"
+              "\n"
+              "-q usa a matriz reduzida. Cada caso é repetido até que as\n"
+              "repetições somem SEGUNDOS (padrão: 10), com ao menos %d\n"
+              "repetições. Sem --csv nem --json, escreve o CSV na saída\n"
+              "padrão.\n",
+              argv[0], kMinRepeticoes);
+      return 1;
+    }
+  }
+  if (opcoes.csv == nullptr && opcoes.json == nullptr) {
+    opcoes.csv = "-";
+  }
+
+  vector<Medicao> medicoes;
+  for (const Caso &caso : MontaCasos(opcoes.rapida)) {
+    ParametrosGerador parametros;
+    parametros.familia = caso.familia;
+    parametros.L = caso.L;
+    parametros.C = caso.C;
+    parametros.densidade = caso.densidade;
+    Cifra modelo;
+    GeraCaixa(parametros, modelo);
+
+    for (int motor = 0; motor < kNumMotoresSuite; motor++) {
+      medicoes.push_back(Mede(modelo, caso, motor, opcoes));
+      const Medicao &medicao = medicoes.back();
+      fprintf(stderr, "%-11s L=%-7d C=%-2d d=%.1f %-10s ",
+              NomeFamilia(caso.familia), caso.L, caso.C, caso.densidade,
+              kNomesMotores[motor]);
+      if (medicao.ignorado) {
+        fprintf(stderr, "ignorado\n");
+      } else {
+        fprintf(stderr, "mediana %.6f s, %zu repetições\n",
+                Percentil(medicao.tempos, 0.5), medicao.tempos.size());
+      }
+    }
+  }
+
+  bool escrito = true;
+  if (opcoes.csv != nullptr) {
+    escrito = EscreveResultados(opcoes.csv, false, medicoes) && escrito;
+  }
+  if (opcoes.json != nullptr) {
+    escrito = EscreveResultados(opcoes.json, true, medicoes) && escrito;
+  }
+  return escrito ? 0 : 1;
+}
@@ -0,0 +1,907 @@
+// Teste diferencial dos motores do solucionador. Gera caixas pequenas
+// aleatórias (dimensões, densidades e padrões de conexão variados, incluindo
+// caixas vazias, de uma linha ou coluna e com linhas repetidas), resolve cada
+// uma com todos os motores disponíveis e compara os ótimos com a recursão de
+// referência (`Cifra::f`, pela memoização) e com uma força bruta independente.
+// Toda solução também passa pelo verificador, cujo veredito é comparado com o
+// de uma verificação independente. Cada divergência é minimizada e salva como
+// uma caixa no formato texto, que pode ser passada de volta à ferramenta (ou
+// ao programa principal) para reproduzi-la.
+//
+// Com -e, testa a leitura em vez dos motores: cada caixa gerada é escrita nos
+// formatos texto e binário, e as escritas são mutadas (bits e bytes trocados,
+// inseridos ou removidos, inteiros substituídos por valores extremos) e lidas
+// pelo `Leitor` e por `LeCaixa`. Cada entrada deve ser rejeitada ou lida como
+// uma caixa que, escrita de volta em qualquer dos dois formatos, é relida
+// igual, com o N declarado igual ao número de cristais lidos. As entradas
+// divergentes são salvas como foram lidas.
+//
+// Compilada com -DCIFRA_LIBFUZZER (`make fuzz`), a ferramenta vira um alvo do
+// libFuzzer, que passa cada entrada do fuzzer pela mesma conferência da
+// leitura e depois a decodifica como uma caixa.
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+#include "binario.hpp"
+#include "cache.hpp"
+#include "cifra.hpp"
+#include "entrada.hpp"
+#include "leitor.hpp"
+#include "processos.hpp"
+#include "simetria.hpp"
+#include "topologia.hpp"
+
+/// @brief Maior número de cristais de uma caixa resolvida pela força bruta.
+static const int kMaxCristaisForcaBruta = 20;
+
+/// @brief Maior número de posições de uma entrada lida na conferência da
+/// leitura. Entradas maiores (por exemplo, com uma dimensão mutada para um
+/// valor extremo) são ignoradas, pois a caixa vazia já ocuparia gigabytes.
+static const long long kMaxPosicoesEntrada = 1 << 16;
+
+/// @brief Uma caixa gerada, como matrizes densas: o brilho de cada posição
+/// (-1 se vazia) e as conexões à direita (bit 0) e acima (bit 1).
+struct Instancia {
+  int L = 0, C = 0;
+  vector<int> brilhos, conexoes;
+
+  int Indice(int i, int j) const { return i * C + j; }
+
+  int NumCristais() const {
+    int n = 0;
+    for (int brilho : brilhos) {
+      n += brilho != -1;
+    }
+    return n;
+  }
+};
+
+/// @brief Opções que valem para todas as comparações.
+struct Opcoes {
+  // Indica que a resolução em processos também deve ser comparada.
+  bool processos = false;
+};
+
+/// @brief Preenche um problema com a caixa de uma instância.
+static void Preenche(const Instancia &instancia, Cifra &cifra) {
+  cifra.Reinicia(instancia.L, instancia.C, instancia.NumCristais());
+  for (int i = 0; i < instancia.L; i++) {
+    for (int j = 0; j < instancia.C; j++) {
+      int k = instancia.Indice(i, j);
+      if (instancia.brilhos[k] != -1) {
+        cifra.EditaCaixa().Define(
+            i, j, {instancia.brilhos[k], instancia.conexoes[k]});
+      }
+    }
+  }
+}
+
+/// @brief Converte a caixa de um problema em uma instância.
+static Instancia Converte(const Caixa &caixa) {
+  Instancia instancia;
+  instancia.L = caixa.GetL();
+  instancia.C = caixa.GetC();
+  for (int i = 0; i < instancia.L; i++) {
+    for (int j = 0; j < instancia.C; j++) {
+      instancia.brilhos.push_back(caixa.Brilho(i, j));
+      instancia.conexoes.push_back(caixa.Brilho(i, j) == -1
+                                       ? 0
+                                       : caixa.Conexoes(i, j));
+    }
+  }
+  return instancia;
+}
+
+/// @brief Verifica, sem usar o solucionador, se a posição (`i`, `j`) pode ser
+/// usada junto das posições já marcadas em `usadas`.
+static bool PodeUsar(const Instancia &instancia, const vector<char> &usadas,
+                     int i, int j) {
+  int L = instancia.L, C = instancia.C;
+  int direita = instancia.Indice(i, (j + 1) % C);
+  int esquerda = instancia.Indice(i, (j - 1 + C) % C);
+  int acima = instancia.Indice((i - 1 + L) % L, j);
+  int abaixo = instancia.Indice((i + 1) % L, j);
+  int k = instancia.Indice(i, j);
+
+  // Em caixas de uma coluna (ou linha), a vizinha é a própria posição
+  if (((instancia.conexoes[k] & 1) && (usadas[direita] || direita == k)) ||
+      ((instancia.conexoes[k] & 2) && (usadas[acima] || acima == k))) {
+    return false;
+  }
+  return !((instancia.conexoes[esquerda] & 1) && usadas[esquerda]) &&
+         !((instancia.conexoes[abaixo] & 2) && usadas[abaixo]);
+}
+
+/// @brief Encontra o ótimo por força bruta, testando todos os subconjuntos de
+/// cristais compatíveis.
+static long long ForcaBruta(const Instancia &instancia, vector<char> &usadas,
+                            int k) {
+  while (k < instancia.L * instancia.C && instancia.brilhos[k] == -1) {
+    k++;
+  }
+  if (k == instancia.L * instancia.C) {
+    return 0;
+  }
+
+  long long melhor = ForcaBruta(instancia, usadas, k + 1);
+  if (PodeUsar(instancia, usadas, k / instancia.C, k % instancia.C)) {
+    usadas[k] = 1;
+    melhor = std::max(melhor, instancia.brilhos[k] +
+                                  ForcaBruta(instancia, usadas, k + 1));
+    usadas[k] = 0;
+  }
+  return melhor;
+}
+
+/// @brief Verifica uma solução sem usar o solucionador.
+static bool ValidaIndependente(const Instancia &instancia,
+                               const Solucao &solucao) {
+  vector<char> usadas(instancia.L * instancia.C, 0);
+  long long soma = 0;
+  for (const pair<int, int> &cristal : solucao.cristais) {
+    int i = cristal.first - 1, j = cristal.second - 1;
+    if (i < 0 || i >= instancia.L || j < 0 || j >= instancia.C ||
+        instancia.brilhos[instancia.Indice(i, j)] == -1 ||
+        usadas[instancia.Indice(i, j)]) {
+      return false;
+    }
+    usadas[instancia.Indice(i, j)] = 1;
+    soma += instancia.brilhos[instancia.Indice(i, j)];
+  }
+
+  for (const pair<int, int> &cristal : solucao.cristais) {
+    int i = cristal.first - 1, j = cristal.second - 1;
+    usadas[instancia.Indice(i, j)] = 0;
+    bool pode = PodeUsar(instancia, usadas, i, j);
+    usadas[instancia.Indice(i, j)] = 1;
+    if (!pode) {
+      return false;
+    }
+  }
+
+  return solucao.num_cristais == (int)solucao.cristais.size() &&
+         solucao.soma == soma;
+}
+
+/// @brief Compara o veredito do verificador com o independente para uma
+/// solução.
+/// @return Uma descrição da divergência, ou uma string vazia
+static std::string ComparaVeredito(const Instancia &instancia, Cifra &cifra,
+                                   const Solucao &solucao, const char *nome) {
+  int indice;
+  bool valida = cifra.Verifica(solucao, indice) == nullptr;
+  if (valida != ValidaIndependente(instancia, solucao)) {
+    return std::string(nome) + ": o verificador diz que a solução é " +
+           (valida ? "válida" : "inválida");
+  }
+  return "";
+}
+
+/// @brief Confere a solução encontrada por um motor.
+/// @param instancia A instância
+/// @param cifra O problema, resolvido pelo motor
+/// @param nome O nome do motor
+/// @param otimo O ótimo de referência
+/// @param exato Indica se o motor deve encontrar o ótimo; caso contrário, a
+/// solução deve apenas não superá-lo, e o limite superior não ser menor
+/// @return Uma descrição da divergência, ou uma string vazia
+static std::string ConfereMotor(const Instancia &instancia, Cifra &cifra,
+                                const char *nome, long long otimo,
+                                bool exato) {
+  Solucao solucao;
+  solucao.num_cristais = cifra.GetValoresSolucao().first;
+  solucao.soma = cifra.GetValoresSolucao().second;
+  solucao.cristais = cifra.GetCristaisSolucao();
+
+  char descricao[160];
+  if (exato ? solucao.soma != otimo : solucao.soma > otimo) {
+    snprintf(descricao, sizeof(descricao), "%s: soma %lld, ótimo %lld", nome,
+             solucao.soma, otimo);
+    return descricao;
+  }
+  if (!exato && cifra.GetLimiteSuperior() < otimo) {
+    snprintf(descricao, sizeof(descricao),
+             "%s: limite superior %d, ótimo %lld", nome,
+             cifra.GetLimiteSuperior(), otimo);
+    return descricao;
+  }
+
+  int indice;
+  const char *erro = cifra.Verifica(solucao, indice);
+  if (erro != nullptr) {
+    return std::string(nome) + ": solução inválida: " + erro;
+  }
+  std::string veredito = ComparaVeredito(instancia, cifra, solucao, nome);
+  if (!veredito.empty()) {
+    return veredito;
+  }
+
+  // Acrescentar um cristal qualquer deve invalidar a solução ou a soma
+  for (int k = 0; k < instancia.L * instancia.C; k++) {
+    if (instancia.brilhos[k] != -1) {
+      solucao.cristais.push_back({k / instancia.C + 1, k % instancia.C + 1});
+      solucao.num_cristais++;
+      solucao.soma += instancia.brilhos[k];
+      return ComparaVeredito(instancia, cifra, solucao, nome);
+    }
+  }
+  return "";
+}
+
+/// @brief Resolve uma instância com todos os motores e compara os resultados.
+/// @return Uma descrição da primeira divergência, ou uma string vazia se
+/// todos os motores concordam
+static std::string Compara(const Instancia &instancia, const Opcoes &opcoes) {
+  // Os caches são compartilhados entre as comparações, como em um lote
+  static CachePlanos planos(16);
+  static CacheResultados resultados(64);
+
+  Cifra cifra;
+  std::string divergencia;
+
+  // A recursão de referência, pela memoização sobre todas as configurações
+  Preenche(instancia, cifra);
+  cifra.Resolve(kMotorMemoizacao);
+  long long otimo = cifra.GetValoresSolucao().second;
+  if (!(divergencia = ConfereMotor(instancia, cifra, "memoizacao", otimo,
+                                   true))
+           .empty()) {
+    return divergencia;
+  }
+
+  if (instancia.NumCristais() <= kMaxCristaisForcaBruta) {
+    vector<char> usadas(instancia.L * instancia.C, 0);
+    long long bruta = ForcaBruta(instancia, usadas, 0);
+    if (bruta != otimo) {
+      return "força bruta: ótimo " + std::to_string(bruta) +
+             ", memoização " + std::to_string(otimo);
+    }
+  }
+
+  const struct {
+    const char *nome;
+    MotorExato motor;
+  } motores[] = {{"automatico", kMotorAutomatico},
+                 {"produtos", kMotorProdutos}};
+  for (const auto &motor : motores) {
+    Preenche(instancia, cifra);
+    cifra.Resolve(motor.motor);
+    if (!(divergencia = ConfereMotor(instancia, cifra, motor.nome, otimo,
+                                     true))
+             .empty()) {
+      return divergencia;
+    }
+  }
+
+  // Faixas da costura vertical resolvidas em separado e combinadas, como na
+  // resolução em processos
+  Preenche(instancia, cifra);
+  vector<int> confs, melhores;
+  int metade = (1 << instancia.C) / 2, melhor = -1;
+  for (int inicio : {0, metade}) {
+    int valor = cifra.ResolveFaixa(inicio, inicio == 0 ? metade
+                                                       : 1 << instancia.C,
+                                   confs);
+    if (valor > melhor) {
+      melhor = valor;
+      melhores = confs;
+    }
+  }
+  cifra.AplicaSolucao(melhor, melhores);
+  if (!(divergencia = ConfereMotor(instancia, cifra, "faixas", otimo, true))
+           .empty()) {
+    return divergencia;
+  }
+
+  if (opcoes.processos) {
+    Preenche(instancia, cifra);
+    const char *erro = ResolveEmProcessos(cifra, 2);
+    if (erro != nullptr) {
+      return std::string("processos: ") + erro;
+    }
+    if (!(divergencia = ConfereMotor(instancia, cifra, "processos", otimo,
+                                     true))
+             .empty()) {
+      return divergencia;
+    }
+  }
+
+  // O plano de topologia vindo do cache, resolvido duas vezes para que a
+  // segunda use um plano compartilhado
+  ParametrosResolucao parametros;
+  parametros.planos = &planos;
+  for (int vez = 0; vez < 2; vez++) {
+    Preenche(instancia, cifra);
+    cifra.Resolve(parametros);
+    if (!(divergencia = ConfereMotor(instancia, cifra, "planos", otimo, true))
+             .empty()) {
+      return divergencia;
+    }
+  }
+
+  // O cache de resultados, consultado com a caixa e com uma transformação
+  // dela, que deve reaproveitar a mesma solução
+  ParametrosResolucao exato;
+  Preenche(instancia, cifra);
+  ResolveComCache(cifra, exato, &resultados);
+  if (!(divergencia = ConfereMotor(instancia, cifra, "cache", otimo, true))
+           .empty()) {
+    return divergencia;
+  }
+
+  TransformacaoToroidal transformacao;
+  transformacao.L = instancia.L;
+  transformacao.C = instancia.C;
+  transformacao.deslocamento_linhas = otimo % instancia.L;
+  transformacao.deslocamento_colunas = otimo % instancia.C;
+  transformacao.reflete_linhas = otimo % 2 == 1;
+  transformacao.reflete_colunas = otimo % 3 == 1;
+  Caixa transformada;
+  Preenche(instancia, cifra);
+  AplicaTransformacao(cifra.GetCaixa(), transformacao, transformada);
+  Instancia simetrica = Converte(transformada);
+  Preenche(simetrica, cifra);
+  ResolveComCache(cifra, exato, &resultados);
+  if (!(divergencia = ConfereMotor(simetrica, cifra, "cache transformado",
+                                   otimo, true))
+           .empty()) {
+    return divergencia;
+  }
+
+  // A busca em feixe é aproximada: basta não superar o ótimo e não
+  // subestimar o limite superior
+  for (int largura : {1, 64}) {
+    Preenche(instancia, cifra);
+    cifra.ResolveFeixe(largura, 4);
+    if (!(divergencia = ConfereMotor(instancia, cifra, "feixe", otimo, false))
+             .empty()) {
+      return divergencia;
+    }
+  }
+
+  return "";
+}
+
+/// @brief Escreve uma instância no formato texto da entrada.
+static std::string EscreveTexto(const Instancia &instancia) {
+  int L = instancia.L, C = instancia.C;
+  std::string texto = std::to_string(L) + " " + std::to_string(C) + " " +
+                      std::to_string(instancia.NumCristais()) + "\n";
+  char linha[96];
+  for (int i = 0; i < L; i++) {
+    for (int j = 0; j < C; j++) {
+      int k = instancia.Indice(i, j);
+      if (instancia.brilhos[k] == -1) {
+        continue;
+      }
+      int esquerda = instancia.conexoes[instancia.Indice(i, (j - 1 + C) % C)];
+      int abaixo = instancia.conexoes[instancia.Indice((i + 1) % L, j)];
+      snprintf(linha, sizeof(linha), "%d %d %d %d %d %d %d\n", i + 1, j + 1,
+               instancia.brilhos[k], instancia.conexoes[k] & 1,
+               instancia.conexoes[k] >> 1 & 1, esquerda & 1, abaixo >> 1 & 1);
+      texto += linha;
+    }
+  }
+  return texto;
+}
+
+/// @brief Escreve uma instância no formato binário, como `EscreveBinario`.
+static std::string EscreveBinaria(const Instancia &instancia) {
+  Cifra cifra;
+  Preenche(instancia, cifra);
+  const Caixa &caixa = cifra.GetCaixa();
+
+  CabecalhoBinario cabecalho;
+  memset(&cabecalho, 0, sizeof(cabecalho));
+  memcpy(cabecalho.magica, kMagicaBinario, sizeof(kMagicaBinario));
+  cabecalho.versao = kVersaoBinario;
+  cabecalho.L = instancia.L;
+  cabecalho.C = instancia.C;
+  cabecalho.N = instancia.NumCristais();
+
+  std::string binaria((const char *)&cabecalho, sizeof(cabecalho));
+  binaria.append((const char *)caixa.GetBrilhos(),
+                 caixa.NumPosicoes() * sizeof(int32_t));
+  binaria.append((const char *)caixa.GetConexoes(),
+                 Caixa::TamanhoConexoes(caixa.NumPosicoes()));
+  return binaria;
+}
+
+/// @brief Lê uma entrada inteira com `LeCaixa`, a partir de uma cópia
+/// alinhada a 4 bytes, como exige o formato binário.
+/// @param lida Recebe a caixa lida
+/// @param declarados Recebe o número de cristais declarado na entrada
+/// @param erro Recebe a mensagem de erro, se a entrada for rejeitada
+/// @return Se a entrada foi aceita
+static bool LeEntrada(const std::string &dados, Instancia &lida,
+                      int &declarados, std::string &erro) {
+  vector<uint32_t> alinhados(dados.size() / 4 + 1);
+  memcpy(alinhados.data(), dados.data(), dados.size());
+  const char *inicio = (const char *)alinhados.data();
+
+  Leitor leitor;
+  Cifra cifra;
+  leitor.AbreTrecho(inicio, inicio + dados.size());
+  if (!LeCaixa(leitor, cifra)) {
+    erro = leitor.GetErro();
+    return false;
+  }
+  lida = Converte(cifra.GetCaixa());
+  declarados = cifra.GetNumCristais();
+  return true;
+}
+
+/// @brief Indica se as dimensões declaradas por uma entrada de texto
+/// ultrapassam `kMaxPosicoesEntrada`. Lê apenas o começo da entrada.
+static bool EntradaGrande(const std::string &dados) {
+  if (EhBinario(dados.data(), dados.size())) {
+    return false;
+  }
+  Leitor leitor;
+  leitor.AbreTrecho(dados.data(), dados.data() + dados.size());
+  int L, C, N;
+  bool densa = DetectaFormato(leitor) == FormatoEntrada::kDensa;
+  bool dimensoes = densa ? leitor.LeInteiro(L) && leitor.LeInteiro(C)
+                         : LeCabecalho(leitor, L, C, N);
+  return dimensoes && (long long)L * C > kMaxPosicoesEntrada;
+}
+
+static bool Iguais(const Instancia &a, const Instancia &b) {
+  return a.L == b.L && a.C == b.C && a.brilhos == b.brilhos &&
+         a.conexoes == b.conexoes;
+}
+
+/// @brief Resultado da conferência da leitura de uma entrada.
+enum class LeituraEntrada { kRejeitada, kAceita, kIgnorada };
+
+/// @brief Confere a leitura de uma entrada qualquer: ela deve ser rejeitada,
+/// ou lida como uma caixa com o N declarado e que, escrita em cada formato,
+/// é relida igual.
+/// @param resultado Recebe o resultado da leitura
+/// @return Uma descrição da divergência, ou uma string vazia
+static std::string ConfereLeitura(const std::string &dados,
+                                  LeituraEntrada &resultado) {
+  resultado = LeituraEntrada::kIgnorada;
+  if (EntradaGrande(dados)) {
+    return "";
+  }
+
+  Instancia lida;
+  int declarados;
+  std::string erro;
+  resultado = LeituraEntrada::kRejeitada;
+  if (!LeEntrada(dados, lida, declarados, erro)) {
+    return "";
+  }
+
+  resultado = LeituraEntrada::kAceita;
+  if (declarados != lida.NumCristais()) {
+    return "N declarado " + std::to_string(declarados) + ", mas " +
+           std::to_string(lida.NumCristais()) + " cristais lidos";
+  }
+
+  const struct {
+    const char *nome;
+    std::string (*escreve)(const Instancia &);
+  } formatos[] = {{"texto", EscreveTexto}, {"binário", EscreveBinaria}};
+  for (const auto &formato : formatos) {
+    Instancia relida;
+    if (!LeEntrada(formato.escreve(lida), relida, declarados, erro)) {
+      return std::string(formato.nome) + ": a caixa aceita é rejeitada: " +
+             erro;
+    }
+    if (!Iguais(relida, lida)) {
+      return std::string(formato.nome) + ": a caixa aceita é relida diferente";
+    }
+  }
+  return "";
+}
+
+#ifdef CIFRA_LIBFUZZER
+
+// Cada entrada do fuzzer vira uma caixa: dois bytes com as dimensões e, para
+// cada posição, um byte de brilho (255 indica uma posição vazia) e um de
+// conexões. Posições que faltam ficam vazias.
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *dados, size_t tamanho) {
+  // Os mesmos bytes, lidos como uma entrada do programa
+  LeituraEntrada resultado;
+  std::string leitura =
+      ConfereLeitura(std::string((const char *)dados, tamanho), resultado);
+  if (!leitura.empty()) {
+    fprintf(stderr, "Divergência na leitura: %s\n", leitura.c_str());
+    abort();
+  }
+
+  if (tamanho < 2) {
+    return 0;
+  }
+
+  Instancia instancia;
+  instancia.L = 1 + dados[0] % 7;
+  instancia.C = 1 + dados[1] % 7;
+  instancia.brilhos.assign(instancia.L * instancia.C, -1);
+  instancia.conexoes.assign(instancia.L * instancia.C, 0);
+  for (size_t k = 0; k < instancia.brilhos.size(); k++) {
+    if (2 + 2 * k + 1 < tamanho && dados[2 + 2 * k] != 255) {
+      instancia.brilhos[k] = dados[2 + 2 * k];
+      instancia.conexoes[k] = dados[2 + 2 * k + 1] & Caixa::kMascaraConexoes;
+    }
+  }
+
+  std::string divergencia = Compara(instancia, Opcoes());
+  if (!divergencia.empty()) {
+    fprintf(stderr, "Divergência: %s\n", divergencia.c_str());
+    abort();
+  }
+  return 0;
+}
+
+#else
+
+/// @brief Gera uma caixa aleatória. Cada caixa sorteia as suas próprias
+/// densidades, para que os casos extremos (caixas vazias, cheias, sem
+/// conexões ou totalmente conectadas) apareçam com frequência.
+static Instancia Gera(std::mt19937_64 &gerador) {
+  auto sorteia = [&](int maximo) {
+    return (int)(gerador() % (unsigned)(maximo + 1));
+  };
+  auto chance = [&](double probabilidade) {
+    return std::uniform_real_distribution<double>(0, 1)(gerador) <
+           probabilidade;
+  };
+
+  const double densidades[] = {0, 0.3, 0.7, 0.9, 1};
+  const double probabilidades_conexao[] = {0, 0.2, 0.5, 1};
+  const int maximos_brilho[] = {0, 1, 9, 1000000};
+
+  Instancia instancia;
+  instancia.L = 1 + sorteia(6);
+  instancia.C = 1 + sorteia(6);
+  double densidade = densidades[sorteia(4)];
+  double conexao = probabilidades_conexao[sorteia(3)];
+  int maximo_brilho = maximos_brilho[sorteia(3)];
+
+  instancia.brilhos.assign(instancia.L * instancia.C, -1);
+  instancia.conexoes.assign(instancia.L * instancia.C, 0);
+  for (int k = 0; k < instancia.L * instancia.C; k++) {
+    if (chance(densidade)) {
+      instancia.brilhos[k] = sorteia(maximo_brilho);
+      instancia.conexoes[k] = chance(conexao) | chance(conexao) << 1;
+    }
+  }
+
+  // Linhas repetidas exercitam as potências de `Cifra::ResolveProdutos`
+  if (chance(0.25)) {
+    int periodo = 1 + sorteia(1);
+    for (int k = periodo * instancia.C; k < instancia.L * instancia.C; k++) {
+      instancia.brilhos[k] = instancia.brilhos[k - periodo * instancia.C];
+      instancia.conexoes[k] = instancia.conexoes[k - periodo * instancia.C];
+    }
+  }
+
+  return instancia;
+}
+
+/// @brief Remove a linha (ou coluna) `k` de uma instância.
+static Instancia RemoveLinha(const Instancia &instancia, int k,
+                             bool coluna) {
+  Instancia menor;
+  menor.L = instancia.L - !coluna;
+  menor.C = instancia.C - coluna;
+  for (int i = 0; i < instancia.L; i++) {
+    for (int j = 0; j < instancia.C; j++) {
+      if ((coluna ? j : i) != k) {
+        menor.brilhos.push_back(instancia.brilhos[instancia.Indice(i, j)]);
+        menor.conexoes.push_back(instancia.conexoes[instancia.Indice(i, j)]);
+      }
+    }
+  }
+  return menor;
+}
+
+/// @brief Reduz uma instância divergente enquanto a divergência persistir:
+/// remove linhas, colunas e cristais, desfaz conexões e diminui os brilhos.
+static Instancia Minimiza(Instancia instancia, const Opcoes &opcoes) {
+  auto diverge = [&](const Instancia &candidata) {
+    return !Compara(candidata, opcoes).empty();
+  };
+
+  bool reduziu = true;
+  while (reduziu) {
+    reduziu = false;
+    for (int coluna = 0; coluna < 2; coluna++) {
+      for (int k = (coluna ? instancia.C : instancia.L) - 1;
+           k >= 0 && (coluna ? instancia.C : instancia.L) > 1; k--) {
+        Instancia candidata = RemoveLinha(instancia, k, coluna);
+        if (diverge(candidata)) {
+          instancia = candidata;
+          reduziu = true;
+        }
+      }
+    }
+
+    // Para cada cristal, tenta as reduções da maior para a menor
+    for (int k = 0; k < instancia.L * instancia.C; k++) {
+      if (instancia.brilhos[k] == -1) {
+        continue;
+      }
+      for (int reducao = 0; reducao < 4; reducao++) {
+        Instancia candidata = instancia;
+        if (reducao == 0) {
+          candidata.brilhos[k] = -1;
+          candidata.conexoes[k] = 0;
+        } else if (reducao < 3) {
+          candidata.conexoes[k] &= ~(1 << (reducao - 1));
+        } else {
+          candidata.brilhos[k] = std::min(candidata.brilhos[k], 1);
+        }
+
+        bool mudou = candidata.brilhos[k] != instancia.brilhos[k] ||
+                     candidata.conexoes[k] != instancia.conexoes[k];
+        if (mudou && diverge(candidata)) {
+          instancia = candidata;
+          reduziu = true;
+          break;
+        }
+      }
+    }
+  }
+
+  return instancia;
+}
+
+/// @brief Escreve um buffer em um arquivo.
+static bool Salva(const std::string &dados, const char *caminho) {
+  FILE *arquivo = fopen(caminho, "wb");
+  if (arquivo == nullptr) {
+    return false;
+  }
+  bool ok = fwrite(dados.data(), 1, dados.size(), arquivo) == dados.size();
+  return fclose(arquivo) == 0 && ok;
+}
+
+/// @brief Lê um arquivo inteiro.
+static bool Carrega(const char *caminho, std::string &dados) {
+  FILE *arquivo = fopen(caminho, "rb");
+  if (arquivo == nullptr) {
+    return false;
+  }
+  char bloco[4096];
+  for (size_t lidos; (lidos = fread(bloco, 1, sizeof(bloco), arquivo)) > 0;) {
+    dados.append(bloco, lidos);
+  }
+  bool ok = !ferror(arquivo);
+  fclose(arquivo);
+  return ok;
+}
+
+/// @brief Substitui um inteiro de uma entrada por um valor extremo: no
+/// formato binário, uma palavra alinhada (um campo do cabeçalho ou um
+/// brilho); no texto, um número qualquer.
+static void SubstituiInteiro(std::string &dados, bool binaria,
+                             std::mt19937_64 &gerador) {
+  const int32_t extremos[] = {-2, -1, 0, 1, 2, 7, 1000000, 2147483647,
+                              (int32_t)0x80000000};
+  int32_t valor = extremos[gerador() % (sizeof(extremos) / sizeof(int32_t))];
+  if (binaria) {
+    if (dados.size() >= 4) {
+      memcpy(&dados[gerador() % (dados.size() / 4) * 4], &valor, 4);
+    }
+    return;
+  }
+
+  // Começo de um número escolhido ao acaso, incluindo o sinal
+  size_t pos = gerador() % (dados.size() + 1);
+  while (pos < dados.size() && !isdigit((unsigned char)dados[pos])) {
+    pos++;
+  }
+  while (pos > 0 && (isdigit((unsigned char)dados[pos - 1]) ||
+                     dados[pos - 1] == '-' || dados[pos - 1] == '+')) {
+    pos--;
+  }
+  size_t fim = pos;
+  while (fim < dados.size() && !isspace((unsigned char)dados[fim])) {
+    fim++;
+  }
+  const char *textos[] = {"2147483648", "99999999999", "+3", "--1", "1x"};
+  std::string novo = gerador() % 4 == 0 ? textos[gerador() % 5]
+                                        : std::to_string(valor);
+  dados.replace(pos, fim - pos, novo);
+}
+
+/// @brief Aplica de 1 a 3 mutações a uma entrada.
+static void Muta(std::string &dados, bool binaria, std::mt19937_64 &gerador) {
+  const char bytes[] = {' ', '\n', '\t', '-', '+', '0', '1', '9', 'x', '\0',
+                        '\xff'};
+  auto byte = [&]() { return bytes[gerador() % sizeof(bytes)]; };
+
+  for (int m = 1 + gerador() % 3; m > 0; m--) {
+    size_t pos = dados.empty() ? 0 : gerador() % dados.size();
+    switch (gerador() % 6) {
+      case 0:
+        if (!dados.empty()) {
+          dados[pos] ^= 1 << (gerador() % 8);
+        }
+        break;
+      case 1:
+        if (!dados.empty()) {
+          dados[pos] = byte();
+        }
+        break;
+      case 2:
+        dados.insert(dados.begin() + pos, byte());
+        break;
+      case 3:
+        dados.erase(pos, 1 + gerador() % 4);
+        break;
+      case 4:
+        dados.resize(pos);
+        break;
+      default:
+        SubstituiInteiro(dados, binaria, gerador);
+        break;
+    }
+  }
+}
+
+/// @brief Testa a leitura com entradas mutadas a partir de caixas geradas.
+/// @return O número de divergências
+static int TestaEntradas(unsigned long long semente, long long iteracoes,
+                         const char *diretorio) {
+  // Mutações de cada escrita de cada caixa
+  const int kMutacoes = 8;
+
+  std::mt19937_64 gerador(semente);
+  long long contagens[3] = {};
+  int divergencias = 0;
+  for (long long iteracao = 0; iteracao < iteracoes; iteracao++) {
+    Instancia instancia = Gera(gerador);
+    for (int binaria = 0; binaria < 2; binaria++) {
+      std::string escrita =
+          binaria ? EscreveBinaria(instancia) : EscreveTexto(instancia);
+
+      // A escrita intacta deve ser lida como a própria caixa
+      Instancia lida;
+      int declarados;
+      std::string erro;
+      if (!LeEntrada(escrita, lida, declarados, erro) ||
+          !Iguais(lida, instancia)) {
+        printf("iteração %lld: a escrita %s não é lida como a caixa: %s\n",
+               iteracao, binaria ? "binária" : "em texto", erro.c_str());
+        divergencias++;
+        continue;
+      }
+
+      for (int mutacao = 0; mutacao < kMutacoes; mutacao++) {
+        std::string mutada = escrita;
+        Muta(mutada, binaria, gerador);
+        LeituraEntrada resultado;
+        std::string divergencia = ConfereLeitura(mutada, resultado);
+        contagens[(int)resultado]++;
+        if (divergencia.empty()) {
+          continue;
+        }
+
+        divergencias++;
+        std::string caminho = std::string(diretorio) + "/entrada-" +
+                              std::to_string(semente) + "-" +
+                              std::to_string(iteracao) + "-" +
+                              std::to_string(mutacao) +
+                              (binaria ? ".bin" : ".txt");
+        mkdir(diretorio, 0755);
+        bool salva = Salva(mutada, caminho.c_str());
+        printf("iteração %lld: %s\n  entrada salva em %s\n", iteracao,
+               divergencia.c_str(),
+               salva ? caminho.c_str() : "(não foi possível salvar)");
+      }
+    }
+  }
+
+  printf("%lld entradas, semente %llu: %lld rejeitadas, %lld aceitas, "
+         "%lld ignoradas, %d divergências\n",
+         contagens[0] + contagens[1] + contagens[2], semente, contagens[0],
+         contagens[1], contagens[2], divergencias);
+  return divergencias;
+}
+
+int main(int argc, char **argv) {
+  Opcoes opcoes;
+  unsigned long long semente = 1;
+  long long iteracoes = 1000;
+  const char *diretorio = "regressoes";
+  bool entradas = false;
+  vector<const char *> arquivos;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+      semente = strtoull(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      iteracoes = atoll(argv[++i]);
+    } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+      diretorio = argv[++i];
+    } else if (strcmp(argv[i], "-p") == 0) {
+      opcoes.processos = true;
+    } else if (strcmp(argv[i], "-e") == 0) {
+      entradas = true;
+    } else if (argv[i][0] != '-') {
+      arquivos.push_back(argv[i]);
+    } else {
+      fprintf(stderr,
+              "Uso: %s [-s SEMENTE] [-n ITERACOES] [-d DIRETORIO] [-p] [-e] "
+              "[caixa...]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  // Com arquivos, apenas reproduz as caixas (ou, com -e, as entradas) salvas
+  int divergencias = 0;
+  if (!arquivos.empty() && entradas) {
+    for (const char *caminho : arquivos) {
+      std::string dados;
+      if (!Carrega(caminho, dados)) {
+        fprintf(stderr, "Não foi possível ler %s\n", caminho);
+        return 1;
+      }
+      LeituraEntrada resultado;
+      std::string divergencia = ConfereLeitura(dados, resultado);
+      printf("%s: %s\n", caminho,
+             divergencia.empty() ? "ok" : divergencia.c_str());
+      divergencias += !divergencia.empty();
+    }
+    return divergencias > 0;
+  }
+  if (!arquivos.empty()) {
+    for (const char *caminho : arquivos) {
+      Leitor leitor;
+      Cifra cifra;
+      if (!leitor.Abre(caminho) || !LeCaixa(leitor, cifra)) {
+        fprintf(stderr, "%s: %s\n", caminho, leitor.GetErro());
+        return 1;
+      }
+      std::string divergencia = Compara(Converte(cifra.GetCaixa()), opcoes);
+      printf("%s: %s\n", caminho,
+             divergencia.empty() ? "ok" : divergencia.c_str());
+      divergencias += !divergencia.empty();
+    }
+    return divergencias > 0;
+  }
+
+  if (entradas) {
+    return TestaEntradas(semente, iteracoes, diretorio) > 0;
+  }
+
+  std::mt19937_64 gerador(semente);
+  for (long long iteracao = 0; iteracao < iteracoes; iteracao++) {
+    Instancia instancia = Gera(gerador);
+    std::string divergencia = Compara(instancia, opcoes);
+    if (divergencia.empty()) {
+      continue;
+    }
+
+    divergencias++;
+    Instancia minima = Minimiza(instancia, opcoes);
+    std::string caminho = std::string(diretorio) + "/diferencial-" +
+                          std::to_string(semente) + "-" +
+                          std::to_string(iteracao) + ".txt";
+    mkdir(diretorio, 0755);
+    bool salva = Salva(EscreveTexto(minima), caminho.c_str());
+    printf("iteração %lld: %s\n  minimizada para %dx%d, %d cristais: %s\n",
+           iteracao, divergencia.c_str(), minima.L, minima.C,
+           minima.NumCristais(),
+           salva ? caminho.c_str() : "não foi possível salvar");
+  }
+
+  printf("%lld caixas, semente %llu: %d divergências\n", iteracoes, semente,
+         divergencias);
+  return divergencias > 0;
+}
+
+#endif
@@ -0,0 +1,102 @@
+// Gerador de instâncias para testes de desempenho. Escreve uma caixa de uma
+// das famílias de `gerador.hpp` no formato texto (ou, com -b, no formato
+// binário). A caixa depende apenas das opções, então a mesma linha de comando
+// gera a mesma caixa em qualquer máquina.
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "binario.hpp"
+#include "gerador.hpp"
+
+/// @brief Imprime a mensagem de uso da ferramenta.
+static void ImprimeUso(const char *programa) {
+  fprintf(stderr,
+          "Uso: %s [-f FAMILIA] [-l L] [-c C] [-d DENSIDADE] [-s SEMENTE]\n"
+          "          [-o ARQ | -b ARQ]\n"
+          "\n"
+          "Famílias:",
+          programa);
+  for (int f = 0; f < kNumFamilias; f++) {
+    fprintf(stderr, " %s", NomeFamilia(static_cast<FamiliaGerador>(f)));
+  }
+  fprintf(stderr,
+          "\n\nSem -l ou -c, usa as dimensões padrão da família. A caixa é\n"
+          "escrita na saída padrão, em ARQ (-o) ou, no formato binário, em\n"
+          "ARQ (-b).\n");
+}
+
+int main(int argc, char **argv) {
+  ParametrosGerador parametros;
+  const char *saida = nullptr, *saida_binaria = nullptr;
+  for (int i = 1; i < argc; i++) {
+    bool tem_valor = i + 1 < argc;
+    if (strcmp(argv[i], "-f") == 0 && tem_valor) {
+      if (!FamiliaPorNome(argv[++i], parametros.familia)) {
+        fprintf(stderr, "Família desconhecida: %s\n", argv[i]);
+        ImprimeUso(argv[0]);
+        return 1;
+      }
+    } else if (strcmp(argv[i], "-l") == 0 && tem_valor) {
+      parametros.L = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-c") == 0 && tem_valor) {
+      parametros.C = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "-d") == 0 && tem_valor) {
+      parametros.densidade = atof(argv[++i]);
+    } else if (strcmp(argv[i], "-s") == 0 && tem_valor) {
+      parametros.semente = strtoull(argv[++i], nullptr, 10);
+    } else if (strcmp(argv[i], "-o") == 0 && tem_valor) {
+      saida = argv[++i];
+    } else if (strcmp(argv[i], "-b") == 0 && tem_valor) {
+      saida_binaria = argv[++i];
+    } else {
+      ImprimeUso(argv[0]);
+      return 1;
+    }
+  }
+
+  if (parametros.L < 0 || parametros.C < 0 || parametros.densidade < 0 ||
+      parametros.densidade > 1) {
+    fprintf(stderr, "As dimensões devem ser positivas e a densidade deve "
+                    "estar entre 0 e 1\n");
+    return 1;
+  }
+
+  Cifra cifra;
+  GeraCaixa(parametros, cifra);
+
+  if (saida_binaria != nullptr) {
+    if (!EscreveBinario(saida_binaria, cifra.GetCaixa(),
+                        cifra.GetNumCristais())) {
+      fprintf(stderr, "Não foi possível escrever %s\n", saida_binaria);
+      return 1;
+    }
+    return 0;
+  }
+
+  int fd = STDOUT_FILENO;
+  if (saida != nullptr &&
+      (fd = open(saida, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+    fprintf(stderr, "Não foi possível escrever %s\n", saida);
+    return 1;
+  }
+
+  bool escrito;
+  {
+    Escritor escritor(fd);
+    EscreveCaixaTexto(escritor, cifra.GetCaixa(), cifra.GetNumCristais());
+    escrito = escritor.Descarrega();
+  }
+  if (fd != STDOUT_FILENO && close(fd) < 0) {
+    escrito = false;
+  }
+  if (!escrito) {
+    fprintf(stderr, "Não foi possível escrever a caixa\n");
+    return 1;
+  }
+  return 0;
+}
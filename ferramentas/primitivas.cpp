@@ -0,0 +1,368 @@
+// Microbenchmarks das operações elementares da programação dinâmica exata
+// (`primitivas.hpp`): a consistência interna de uma configuração, a
+// compatibilidade entre linhas vizinhas, a soma dos brilhos de uma linha e a
+// consulta à memoização, além de versões alternativas da soma. Para cada
+// número de colunas, mede o custo por chamada em ns e em ciclos do contador
+// de tempo do processador (TSC), isolando cada primitiva com barreiras que
+// impedem o compilador de eliminar ou vetorizar as chamadas.
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "cifra.hpp"
+#include "gerador.hpp"
+#include "primitivas.hpp"
+
+/// @brief Número de linhas da caixa usada nas medições, e de entradas
+/// sorteadas percorridas em ciclo por cada primitiva. Ambos são potências de
+/// 2, para que o índice da entrada seja uma máscara.
+static const int kLinhas = 64, kEntradas = 4096;
+
+/// @brief Linhas da matriz de memoização usada nas medições.
+static const int kLinhasMemo = 4;
+
+/// @brief Impede o compilador de supor qualquer coisa sobre `valor`, que
+/// passa a ser lido e escrito por código opaco a cada iteração.
+template <typename T>
+static inline void NaoOtimiza(T &valor) {
+  asm volatile("" : "+r"(valor));
+}
+
+/// @brief Retorna o tempo do relógio monotônico, em ns.
+static long long Nanossegundos() {
+  struct timespec agora;
+  clock_gettime(CLOCK_MONOTONIC, &agora);
+  return agora.tv_sec * 1000000000LL + agora.tv_nsec;
+}
+
+/// @brief Retorna o contador de tempo do processador, ou 0 se ele não
+/// estiver disponível na arquitetura. O TSC conta ciclos de uma frequência
+/// de referência fixa, que pode diferir da frequência efetiva do núcleo.
+static unsigned long long Ciclos() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/// @brief Uma entrada sorteada: uma linha e configurações dela e da linha
+/// acima, como as vistas por `Cifra::f`.
+struct Entrada {
+  int linha;
+
+  // Configuração arbitrária, que pode usar posições vazias.
+  int conf;
+
+  // Configuração que usa apenas posições com cristais.
+  int conf_presente;
+
+  // Configuração da linha acima e configuração da última linha, relativa à
+  // faixa de configurações iniciais da memoização.
+  int conf_acima, conf_relativa;
+};
+
+/// @brief Opções das medições.
+struct Opcoes {
+  // Tempo mínimo, em ns, de cada repetição.
+  long long tempo_minimo = 20000000;
+
+  int repeticoes = 5;
+
+  // Tamanho máximo, em bytes, da matriz de memoização.
+  size_t limite_memo = 256u << 20;
+
+  vector<int> colunas = {4, 8, 12, 16, 20, 24};
+  bool csv = false;
+};
+
+/// @brief Resultado da medição de uma primitiva.
+struct Resultado {
+  double ns_por_op = 0, ciclos_por_op = 0;
+};
+
+/// @brief Mede uma primitiva. O número de operações é dobrado até que uma
+/// execução leve `tempo_minimo`, e então a medição é repetida, guardando a
+/// mais rápida.
+/// @param executa Executa `n` operações e retorna um valor que depende de
+/// todas elas
+template <typename Funcao>
+static Resultado Mede(Funcao executa, const Opcoes &opcoes) {
+  long long n = 1024;
+  while (true) {
+    long long inicio = Nanossegundos();
+    long long retorno = executa(n);
+    NaoOtimiza(retorno);
+    if (Nanossegundos() - inicio >= opcoes.tempo_minimo ||
+        n >= (1LL << 40)) {
+      break;
+    }
+    n *= 2;
+  }
+
+  Resultado melhor;
+  for (int r = 0; r < opcoes.repeticoes; r++) {
+    long long inicio = Nanossegundos();
+    unsigned long long ciclos = Ciclos();
+    long long retorno = executa(n);
+    NaoOtimiza(retorno);
+    ciclos = Ciclos() - ciclos;
+    double ns = (double)(Nanossegundos() - inicio) / n;
+
+    if (r == 0 || ns < melhor.ns_por_op) {
+      melhor.ns_por_op = ns;
+      melhor.ciclos_por_op = (double)ciclos / n;
+    }
+  }
+  return melhor;
+}
+
+/// @brief Versão alternativa da soma dos brilhos, que percorre apenas os
+/// bits ativados da configuração.
+static inline int SomaBrilhosBits(const int32_t *brilhos, int conf) {
+  int valor = 0;
+  unsigned bits = conf;
+  while (bits != 0) {
+    valor += brilhos[__builtin_ctz(bits)];
+    bits &= bits - 1;
+  }
+  return valor;
+}
+
+/// @brief Versão alternativa da soma dos brilhos, sem desvios: cada brilho é
+/// mascarado pelo seu bit.
+static inline int SomaBrilhosSemDesvios(const int32_t *brilhos, int conf,
+                                        int C) {
+  int valor = 0;
+  for (int j = 0; j < C; j++) {
+    valor += brilhos[j] & -((conf >> j) & 1);
+  }
+  return valor;
+}
+
+static void ImprimeResultado(const char *primitiva, int C,
+                             const Resultado *resultado, bool csv) {
+  if (resultado == nullptr) {
+    printf(csv ? "%s,%d,,\n" : "%-24s %3d %10s %10s\n", primitiva, C, "-",
+           "-");
+    return;
+  }
+
+  // Sem TSC, a vazão por ciclo fica em branco
+  char por_ciclo[32] = "-";
+  if (resultado->ciclos_por_op > 0) {
+    snprintf(por_ciclo, sizeof(por_ciclo), "%.3f",
+             1 / resultado->ciclos_por_op);
+  } else if (csv) {
+    por_ciclo[0] = '\0';
+  }
+  printf(csv ? "%s,%d,%.3f,%s\n" : "%-24s %3d %10.3f %10s\n", primitiva, C,
+         resultado->ns_por_op, por_ciclo);
+}
+
+/// @brief Mede todas as primitivas para caixas de `C` colunas.
+static void MedeColunas(int C, const Opcoes &opcoes) {
+  // Caixa uniforme densa, como as que exigem a resolução exata
+  ParametrosGerador parametros;
+  parametros.L = kLinhas;
+  parametros.C = C;
+  parametros.densidade = 0.8;
+  parametros.semente = C;
+  Cifra cifra;
+  GeraCaixa(parametros, cifra);
+  const Caixa &caixa = cifra.GetCaixa();
+  PlanoTopologia plano;
+  plano.CalculaMascaras(caixa);
+
+  // A memoização tem todas as configurações de cada linha e tantas
+  // configurações iniciais quanto couberem no limite
+  const int num_possibilidades = 1 << C;
+  size_t por_inicial = sizeof(Resposta) * kLinhasMemo * num_possibilidades;
+  int num_iniciais = (int)std::min<size_t>(num_possibilidades,
+                                           opcoes.limite_memo / por_inicial);
+  vector<Resposta> memo;
+  if (num_iniciais > 0) {
+    memo.resize(por_inicial / sizeof(Resposta) * num_iniciais);
+    for (size_t k = 0; k < memo.size(); k++) {
+      memo[k] = {true, (int)(k & 1023), 0};
+    }
+  }
+
+  // Sorteia as entradas com um xorshift de semente fixa
+  uint64_t estado = 0x9e3779b97f4a7c15ULL ^ C;
+  auto aleatorio = [&]() {
+    estado ^= estado << 13;
+    estado ^= estado >> 7;
+    estado ^= estado << 17;
+    return (int)(estado >> 33);
+  };
+  const int mascara = num_possibilidades - 1;
+  vector<Entrada> entradas(kEntradas);
+  for (int k = 0; k < kEntradas; k++) {
+    Entrada &e = entradas[k];
+    e.linha = aleatorio() % kLinhas;
+    e.conf = aleatorio() & mascara;
+    e.conf_presente = e.conf & plano.Linha(e.linha).presenca;
+    e.conf_acima = aleatorio() & mascara;
+    e.conf_relativa = num_iniciais > 0 ? aleatorio() % num_iniciais : 0;
+  }
+
+  const int32_t *brilhos = caixa.GetBrilhos();
+  auto entrada = [&](long long k) -> const Entrada & {
+    return entradas[k & (kEntradas - 1)];
+  };
+
+  Resultado r = Mede(
+      [&](long long n) {
+        long long aceitas = 0;
+        for (long long k = 0; k < n; k++) {
+          const Entrada &e = entrada(k);
+          int conf = e.conf;
+          NaoOtimiza(conf);
+          aceitas += ConfiguracaoConsistente(plano.Linha(e.linha), conf, C);
+        }
+        return aceitas;
+      },
+      opcoes);
+  ImprimeResultado("consistente", C, &r, opcoes.csv);
+
+  r = Mede(
+      [&](long long n) {
+        long long aceitas = 0;
+        for (long long k = 0; k < n; k++) {
+          const Entrada &e = entrada(k);
+          int conf = e.conf_presente;
+          NaoOtimiza(conf);
+          aceitas += ConfiguracoesCompativeis(plano.Linha(e.linha), conf,
+                                              e.conf_acima);
+        }
+        return aceitas;
+      },
+      opcoes);
+  ImprimeResultado("compativeis", C, &r, opcoes.csv);
+
+  r = Mede(
+      [&](long long n) {
+        long long soma = 0;
+        for (long long k = 0; k < n; k++) {
+          const Entrada &e = entrada(k);
+          int conf = e.conf_presente;
+          NaoOtimiza(conf);
+          soma += SomaBrilhosLinha(brilhos + (size_t)e.linha * C, conf, C);
+        }
+        return soma;
+      },
+      opcoes);
+  ImprimeResultado("soma_brilhos", C, &r, opcoes.csv);
+
+  r = Mede(
+      [&](long long n) {
+        long long soma = 0;
+        for (long long k = 0; k < n; k++) {
+          const Entrada &e = entrada(k);
+          int conf = e.conf_presente;
+          NaoOtimiza(conf);
+          soma += SomaBrilhosBits(brilhos + (size_t)e.linha * C, conf);
+        }
+        return soma;
+      },
+      opcoes);
+  ImprimeResultado("soma_brilhos_bits", C, &r, opcoes.csv);
+
+  r = Mede(
+      [&](long long n) {
+        long long soma = 0;
+        for (long long k = 0; k < n; k++) {
+          const Entrada &e = entrada(k);
+          int conf = e.conf_presente;
+          NaoOtimiza(conf);
+          soma += SomaBrilhosSemDesvios(brilhos + (size_t)e.linha * C, conf,
+                                        C);
+        }
+        return soma;
+      },
+      opcoes);
+  ImprimeResultado("soma_brilhos_sem_desvios", C, &r, opcoes.csv);
+
+  // Consultas em posições sorteadas da matriz, que para C grande medem
+  // principalmente as faltas de cache e de TLB
+  if (num_iniciais == 0) {
+    ImprimeResultado("consulta_memo", C, nullptr, opcoes.csv);
+    return;
+  }
+  r = Mede(
+      [&](long long n) {
+        long long soma = 0;
+        for (long long k = 0; k < n; k++) {
+          const Entrada &e = entrada(k);
+          int conf = e.conf;
+          NaoOtimiza(conf);
+          soma += memo[IndiceMemo(e.linha & (kLinhasMemo - 1), conf,
+                                  e.conf_relativa, num_possibilidades,
+                                  num_iniciais)]
+                      .valor;
+        }
+        return soma;
+      },
+      opcoes);
+  ImprimeResultado("consulta_memo", C, &r, opcoes.csv);
+}
+
+int main(int argc, char **argv) {
+  Opcoes opcoes;
+  for (int i = 1; i < argc; i++) {
+    bool tem_valor = i + 1 < argc;
+    if (strcmp(argv[i], "-c") == 0 && tem_valor) {
+      // Lista de colunas separadas por vírgulas
+      opcoes.colunas.clear();
+      for (char *lista = argv[++i]; *lista != '\0';) {
+        opcoes.colunas.push_back(strtol(lista, &lista, 10));
+        lista += *lista == ',';
+      }
+    } else if (strcmp(argv[i], "-r") == 0 && tem_valor) {
+      opcoes.repeticoes = std::max(1, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "-t") == 0 && tem_valor) {
+      opcoes.tempo_minimo = atof(argv[++i]) * 1000000;
+    } else if (strcmp(argv[i], "-m") == 0 && tem_valor) {
+      opcoes.limite_memo = (size_t)atoi(argv[++i]) << 20;
+    } else if (strcmp(argv[i], "--csv") == 0) {
+      opcoes.csv = true;
+    } else {
+      fprintf(stderr,
+              "Uso: %s [-c C1,C2,...] [-r REPETICOES] [-t MS] [-m MIB] "
+              "[--csv]\n"
+              "\n"
+              "Mede cada primitiva para cada número de colunas (padrão:\n"
+              "4,8,...,24), repetindo REPETICOES vezes (padrão: 5) execuções\n"
+              "de ao menos MS milissegundos (padrão: 20). A matriz de\n"
+              "memoização usa até MIB MiB (padrão: 256). A vazão por ciclo\n"
+              "usa os ciclos de referência do TSC.\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  for (int C : opcoes.colunas) {
+    if (C < 2 || C > 30) {
+      fprintf(stderr, "O número de colunas deve estar entre 2 e 30\n");
+      return 1;
+    }
+  }
+
+  printf(opcoes.csv ? "primitiva,C,ns_por_op,ops_por_ciclo\n"
+                    : "%-24s %3s %10s %10s\n",
+         "primitiva", "C", "ns/op", "ops/ciclo");
+  for (int C : opcoes.colunas) {
+    MedeColunas(C, opcoes);
+  }
+  return 0;
+}
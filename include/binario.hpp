@@ -0,0 +1,74 @@
+#ifndef BINARIO_HPP
+#define BINARIO_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "caixa.hpp"
+
+/// @brief Cabeçalho do formato binário de caixas. O arquivo é composto por
+/// este cabeçalho, seguido do arranjo de `L * C` brilhos (`int32_t`, linha a
+/// linha, -1 onde não há cristal) e do arranjo de conexões empacotadas com 2
+/// bits por posição (bit 0 à direita, bit 1 acima, 4 posições por byte), no
+/// mesmo layout de `Caixa`. Todos os campos são little-endian. A leitura não
+/// copia os arranjos, mas percorre os brilhos uma vez para validá-los, em
+/// tempo linear no número de posições.
+struct CabecalhoBinario {
+  // Identifica o formato. Deve conter `kMagicaBinario`.
+  char magica[8];
+
+  // Versão do formato. Deve ser `kVersaoBinario`.
+  uint32_t versao;
+
+  // Reservado para flags futuras; deve ser 0.
+  uint32_t flags;
+
+  // Dimensões da caixa e número de cristais.
+  int32_t L, C, N;
+
+  // Reservado para uso futuro; deve ser 0.
+  uint32_t reservado;
+};
+
+static_assert(sizeof(CabecalhoBinario) == 32,
+              "O cabeçalho binário deve ter 32 bytes");
+
+/// @brief Sequência que identifica o formato binário.
+const char kMagicaBinario[8] = {'C', 'I', 'F', 'R', 'A', 'B', 'I', 'N'};
+
+/// @brief Versão atual do formato binário.
+const uint32_t kVersaoBinario = 1;
+
+/// @brief Verifica se um buffer começa com a identificação do formato binário.
+/// @param dados O buffer
+/// @param tamanho O tamanho do buffer, em bytes
+bool EhBinario(const char *dados, size_t tamanho);
+
+/// @brief Interpreta um buffer no formato binário sem copiá-lo, validando o
+/// cabeçalho, o tamanho dos arranjos e, em uma passada linear, os brilhos,
+/// que devem ser -1 (posição vazia) ou não negativos, com exatamente N
+/// posições não vazias.
+/// @param dados O buffer, que deve estar alinhado a 4 bytes
+/// @param tamanho O tamanho do buffer, em bytes
+/// @param cabecalho Recebe o cabeçalho
+/// @param brilhos Recebe um ponteiro para o arranjo de brilhos dentro de
+/// `dados`
+/// @param conexoes Recebe um ponteiro para o arranjo de conexões dentro de
+/// `dados`
+/// @param posicao Recebe a posição (`i * C + j`) do primeiro brilho inválido,
+/// ou -1 se o erro não se refere a uma posição
+/// @return `nullptr` se o buffer é válido, ou uma mensagem de erro caso
+/// contrário.
+const char *InterpretaBinario(const char *dados, size_t tamanho,
+                              CabecalhoBinario &cabecalho,
+                              const int32_t *&brilhos,
+                              const uint8_t *&conexoes, long long &posicao);
+
+/// @brief Escreve uma caixa no formato binário.
+/// @param caminho O caminho do arquivo a ser escrito
+/// @param caixa A caixa
+/// @param n O número de cristais da caixa
+/// @return `true` se o arquivo foi escrito, `false` caso contrário.
+bool EscreveBinario(const char *caminho, const Caixa &caixa, int n);
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "caixa.hpp"
+#include "cifra.hpp"
+#include "hash.hpp"
+#include "simetria.hpp"
+
+using std::vector;
+
+/// @brief Calcula a chave de uma caixa: um hash das dimensões, dos brilhos,
+/// das conexões empacotadas e dos parâmetros de resolução. Caixas iguais têm a
+/// mesma chave, qualquer que seja o formato em que foram lidas.
+/// @param caixa A caixa
+/// @param parametros Os parâmetros de resolução
+ChaveCaixa CalculaChave(const Caixa &caixa,
+                        const ParametrosResolucao &parametros);
+
+/// @brief Calcula a chave da forma canônica de uma caixa
+/// (`CalculaFormaCanonica`), que é a mesma para todas as rotações e reflexões
+/// da caixa. Na busca em feixe, cujo resultado depende da orientação, é a
+/// chave da própria caixa (`CalculaChave`), com a transformação identidade.
+/// @param caixa A caixa
+/// @param parametros Os parâmetros de resolução
+/// @param transformacao Recebe a transformação que leva a caixa à forma
+/// canônica, usada para converter as coordenadas das soluções
+ChaveCaixa CalculaChaveCanonica(const Caixa &caixa,
+                                const ParametrosResolucao &parametros,
+                                TransformacaoToroidal &transformacao);
+
+/// @brief Cabeçalho do armazém em disco do cache. O arquivo é composto por
+/// este cabeçalho, seguido de registros (`RegistroArmazem`) acrescentados ao
+/// fim, cada um seguido de `L * PalavrasPorLinha(C)` máscaras de linha, como
+/// no formato binário de soluções, nas coordenadas da forma canônica.
+struct CabecalhoArmazem {
+  // Identifica o formato. Deve conter `kMagicaArmazem`.
+  char magica[8];
+
+  // Versão do formato. Deve ser `kVersaoArmazem`.
+  uint32_t versao;
+
+  uint32_t reservado;
+};
+
+/// @brief Registro de uma solução no armazém em disco.
+struct RegistroArmazem {
+  ChaveCaixa chave;
+
+  // Dimensões da caixa.
+  int32_t L, C;
+
+  // Valor da solução e limite superior para o ótimo.
+  int32_t valor, limite_superior;
+};
+
+static_assert(sizeof(RegistroArmazem) % 8 == 0,
+              "As máscaras que seguem o registro devem ficar alinhadas");
+
+/// @brief Sequência que identifica o armazém em disco do cache.
+const char kMagicaArmazem[8] = {'C', 'I', 'F', 'R', 'A', 'C', 'A', 'C'};
+
+/// @brief Versão atual do formato do armazém em disco.
+const uint32_t kVersaoArmazem = 2;
+
+/// @brief Cache de soluções endereçado pelo conteúdo das caixas, na forma
+/// canônica: rotações e reflexões de uma caixa compartilham a mesma solução,
+/// guardada nas coordenadas da forma canônica e convertida para as de quem
+/// consulta. As soluções mais recentes ficam em memória, em uma lista LRU de
+/// capacidade limitada; o armazém em disco opcional guarda todas as soluções
+/// em um arquivo onde os registros só são acrescentados, mapeado em memória e
+/// indexado ao ser aberto. Pode ser usado por várias threads ao mesmo tempo.
+class CacheResultados {
+ public:
+  /// @brief Constroi um cache vazio.
+  /// @param capacidade O número máximo de soluções mantidas em memória
+  explicit CacheResultados(size_t capacidade);
+  ~CacheResultados();
+
+  CacheResultados(const CacheResultados &) = delete;
+  CacheResultados &operator=(const CacheResultados &) = delete;
+
+  /// @brief Abre (ou cria) o armazém em disco, indexando os seus registros.
+  /// Um registro incompleto no fim do arquivo, deixado por uma escrita
+  /// interrompida, é descartado.
+  /// @param caminho O caminho do arquivo
+  /// @return `nullptr` se o armazém foi aberto, ou uma mensagem de erro.
+  const char *AbreArmazem(const char *caminho);
+
+  /// @brief Procura a solução de uma caixa e, se ela for encontrada, a define
+  /// no problema (`Cifra::DefineSolucao`).
+  /// @param chave A chave da forma canônica da caixa
+  /// @param transformacao A transformação que leva a caixa à forma canônica
+  /// @param cifra O problema, com a caixa já preenchida
+  /// @return Se a solução foi encontrada
+  bool Busca(const ChaveCaixa &chave,
+             const TransformacaoToroidal &transformacao, Cifra &cifra);
+
+  /// @brief Guarda a solução de um problema já resolvido.
+  /// @param chave A chave da forma canônica da caixa
+  /// @param transformacao A transformação que leva a caixa à forma canônica
+  /// @param cifra O problema já resolvido
+  void Guarda(const ChaveCaixa &chave,
+              const TransformacaoToroidal &transformacao, Cifra &cifra);
+
+  /// @brief Imprime os contadores de consultas e acertos.
+  void ImprimeEstatisticas(FILE *arquivo);
+
+ private:
+  /// @brief Uma solução guardada em memória.
+  struct Entrada {
+    ChaveCaixa chave;
+    int32_t valor, limite_superior;
+    vector<uint64_t> mascaras;
+  };
+
+  /// @brief Coloca uma entrada no início da lista LRU, descartando a menos
+  /// recente se a capacidade for excedida.
+  void InsereEmMemoria(Entrada &&entrada);
+
+  /// @brief Garante que o mapeamento do armazém cobre os `tamanho` primeiros
+  /// bytes do arquivo.
+  bool MapeiaArmazem(size_t tamanho);
+
+  std::mutex trava_;
+  size_t capacidade_;
+
+  // Lista LRU, da entrada mais recente para a menos recente.
+  std::list<Entrada> recentes_;
+  std::unordered_map<ChaveCaixa, std::list<Entrada>::iterator, HashChaveCaixa>
+      indice_memoria_;
+
+  // Armazém em disco: descritor, mapeamento e posição de cada registro.
+  int fd_armazem_ = -1;
+  char *mapa_armazem_ = nullptr;
+  size_t tamanho_mapa_ = 0, tamanho_armazem_ = 0;
+  std::unordered_map<ChaveCaixa, size_t, HashChaveCaixa> indice_armazem_;
+
+  // Contadores.
+  long long consultas_ = 0, acertos_memoria_ = 0, acertos_armazem_ = 0;
+};
+
+/// @brief Resolve um problema, consultando antes o cache e guardando nele a
+/// solução encontrada.
+/// @param cifra O problema, com a caixa já preenchida
+/// @param parametros Os parâmetros de resolução, já validados
+/// @param cache O cache, ou `nullptr` para resolver sem cache
+/// @return Se a solução veio do cache
+bool ResolveComCache(Cifra &cifra, const ParametrosResolucao &parametros,
+                     CacheResultados *cache);
+
+#endif
@@ -0,0 +1,153 @@
+#ifndef CAIXA_HPP
+#define CAIXA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+/// @brief Reresenta um cristal da caixa.
+struct Cristal {
+  // O brilho do cristal. Um valor de -1 indica que não existe um cristal
+  // naquela posição.
+  int brilho = -1;
+
+  // Armazena as conexões do cristal com os cristais ao seu redor. Os bits 0, 1,
+  // 2 e 3 estarão ativados se o cristal está conectado com o cristal à sua
+  // direita, acima, à sua esquerda e abaixo, respectivamente.
+  int conexoes = 0;
+};
+
+/// @brief Matriz `L`x`C` dos cristais de uma caixa, guardada em arranjos
+/// densos linha a linha: um arranjo de brilhos e um arranjo com 2 bits de
+/// conexão por posição. Apenas as conexões à direita (bit 0) e acima (bit 1)
+/// são guardadas, pois as conexões à esquerda e abaixo são as mesmas vistas
+/// pelo vizinho.
+///
+/// Os arranjos podem pertencer à própria caixa ou apenas apontar para memória
+/// externa (por exemplo, um arquivo binário mapeado com `mmap`), que deve
+/// continuar válida enquanto a caixa for usada.
+class Caixa {
+ public:
+  /// @brief Máscara dos bits de conexão guardados pela caixa.
+  static const int kMascaraConexoes = 0b11;
+
+  /// @brief Inicializa uma caixa própria vazia, sem nenhum cristal.
+  /// @param l O número de linhas da caixa
+  /// @param c O número de colunas da caixa
+  void Inicializa(int l, int c) {
+    L_ = l;
+    C_ = c;
+    brilhos_proprios_.assign(NumPosicoes(), -1);
+    conexoes_proprias_.assign(TamanhoConexoes(NumPosicoes()), 0);
+    brilhos_ = brilhos_proprios_.data();
+    conexoes_ = conexoes_proprias_.data();
+    conexoes_mutaveis_ = conexoes_proprias_.data();
+  }
+
+  /// @brief Faz a caixa apontar para arranjos externos, sem copiá-los.
+  /// @param l O número de linhas da caixa
+  /// @param c O número de colunas da caixa
+  /// @param brilhos O arranjo de `l * c` brilhos, linha a linha
+  /// @param conexoes O arranjo de conexões empacotadas, com
+  /// `TamanhoConexoes(l * c)` bytes
+  void Associa(int l, int c, const int32_t *brilhos, const uint8_t *conexoes) {
+    L_ = l;
+    C_ = c;
+    brilhos_proprios_.clear();
+    conexoes_proprias_.clear();
+    brilhos_ = brilhos;
+    conexoes_ = conexoes;
+    conexoes_mutaveis_ = nullptr;
+  }
+
+  /// @brief Define o cristal da posição (`i`, `j`). Só pode ser usado em
+  /// caixas próprias.
+  /// @param i A linha do cristal (0-based)
+  /// @param j A coluna do cristal (0-based)
+  /// @param cristal O cristal. Apenas os bits de `kMascaraConexoes` das
+  /// conexões são guardados.
+  void Define(int i, int j, Cristal cristal) {
+    DefineBrilho(i, j, cristal.brilho);
+    DefineConexoes(i, j, cristal.conexoes);
+  }
+
+  /// @brief Define apenas o brilho do cristal da posição (`i`, `j`). Só pode
+  /// ser usado em caixas próprias.
+  inline void DefineBrilho(int i, int j, int brilho) {
+    brilhos_proprios_[Indice(i, j)] = brilho;
+  }
+
+  /// @brief Define apenas as conexões do cristal da posição (`i`, `j`). Só
+  /// pode ser usado em caixas próprias.
+  /// @param conexoes As conexões. Apenas os bits de `kMascaraConexoes` são
+  /// guardados.
+  inline void DefineConexoes(int i, int j, int conexoes) {
+    size_t k = Indice(i, j);
+    int deslocamento = 2 * (k & 3);
+    conexoes_mutaveis_[k >> 2] =
+        (conexoes_mutaveis_[k >> 2] & ~(kMascaraConexoes << deslocamento)) |
+        ((conexoes & kMascaraConexoes) << deslocamento);
+  }
+
+  /// @brief Acrescenta conexões ao cristal da posição (`i`, `j`) com uma
+  /// operação atômica, pois o byte das conexões é compartilhado com outras 3
+  /// posições. Permite que threads diferentes preencham posições diferentes
+  /// da mesma caixa própria sem travas.
+  /// @param conexoes As conexões. Apenas os bits de `kMascaraConexoes` são
+  /// guardados.
+  inline void AcrescentaConexoesAtomico(int i, int j, int conexoes) {
+    size_t k = Indice(i, j);
+    uint8_t bits = (conexoes & kMascaraConexoes) << (2 * (k & 3));
+    __atomic_fetch_or(&conexoes_mutaveis_[k >> 2], bits, __ATOMIC_RELAXED);
+  }
+
+  /// @brief Retorna o brilho do cristal da posição (`i`, `j`), ou -1 caso não
+  /// exista um cristal nela.
+  inline int Brilho(int i, int j) const { return brilhos_[Indice(i, j)]; }
+
+  /// @brief Retorna as conexões à direita (bit 0) e acima (bit 1) do cristal
+  /// da posição (`i`, `j`).
+  inline int Conexoes(int i, int j) const {
+    size_t k = Indice(i, j);
+    return (conexoes_[k >> 2] >> (2 * (k & 3))) & kMascaraConexoes;
+  }
+
+  int GetL() const { return L_; }
+  int GetC() const { return C_; }
+
+  /// @brief Retorna o arranjo de brilhos, linha a linha.
+  const int32_t *GetBrilhos() const { return brilhos_; }
+
+  /// @brief Retorna o arranjo de conexões empacotadas.
+  const uint8_t *GetConexoes() const { return conexoes_; }
+
+  /// @brief Retorna o número de posições da caixa.
+  size_t NumPosicoes() const { return static_cast<size_t>(L_) * C_; }
+
+  /// @brief Retorna o número de bytes ocupados pelas conexões empacotadas de
+  /// `posicoes` posições.
+  static size_t TamanhoConexoes(size_t posicoes) { return (posicoes + 3) / 4; }
+
+ private:
+  int L_ = 0, C_ = 0;
+
+  /// @brief Arranjos usados quando a caixa é própria.
+  vector<int32_t> brilhos_proprios_;
+  vector<uint8_t> conexoes_proprias_;
+
+  /// @brief Arranjos efetivamente lidos, próprios ou externos.
+  const int32_t *brilhos_ = nullptr;
+  const uint8_t *conexoes_ = nullptr;
+
+  /// @brief Versão mutável de `conexoes_`, nula quando a caixa é externa.
+  uint8_t *conexoes_mutaveis_ = nullptr;
+
+  /// @brief Retorna o índice da posição (`i`, `j`) nos arranjos.
+  inline size_t Indice(int i, int j) const {
+    return static_cast<size_t>(i) * C_ + j;
+  }
+};
+
+#endif
@@ -0,0 +1,455 @@
+#ifndef CIFRA_HPP
+#define CIFRA_HPP
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "caixa.hpp"
+#include "estatisticas.hpp"
+#include "primitivas.hpp"
+#include "topologia.hpp"
+
+using std::pair;
+using std::vector;
+
+/// @brief Transforma o bit `bit` do número `number` em 1
+/// @param number O número a ser modificado
+/// @param bit O índice (0-based) do bit a ser ativado
+inline void SET_BIT(int &number, int bit) { number |= (1 << bit); }
+
+/// @brief Transforma o bit `bit` do número `number` em 0
+/// @param number O número a ser modificado
+/// @param bit O índice (0-based) do bit a ser desativado
+inline void CLEAR_BIT(int &number, int bit) { number &= (~(1 << bit)); }
+
+/// @brief Retorna o valor do bit `bit` do número `number`
+/// @param number O número de onde o bit será extraído
+/// @param bit O índice (0-based) do bit a ser retornado
+/// @return O valor do bit passado (0 ou 1)
+inline int GET_BIT(int number, int bit) { return (number >> bit) & 0b1; }
+
+/// @brief Versão de `GET_BIT` para máscaras de 64 bits, usadas quando a caixa
+/// tem mais colunas do que cabem em um `int`.
+/// @param number A máscara de onde o bit será extraído
+/// @param bit O índice (0-based) do bit a ser retornado
+/// @return O valor do bit passado (0 ou 1)
+inline int GET_BIT64(uint64_t number, int bit) {
+  return static_cast<int>((number >> bit) & 0b1);
+}
+
+/// @brief Representa uma resposta da programação dinâmica para um estado
+/// específico.
+struct Resposta {
+  // Indica se a resposta para o estado correspondente já foi calculada ou não.
+  bool calculado = false;
+
+  // Valor da maior soma de cristais que pôde ser encontrada utilizando o estado
+  // atual. Um valor de -1 indica que
+  // - a configuração da linha é inválida, ou
+  // - a utilizção desta configuração irá levar invariavelmente a um estado
+  // inválido.
+  int valor = -1;
+
+  // Indica qual configuração da linha anterior levou à maior soma encontrada
+  // (armazenada em `valor`)
+  int conf = 0;
+};
+
+/// @brief Método usado pela resolução exata. Todos encontram a mesma solução.
+enum MotorExato {
+  // Escolhe entre a memoização e os produtos pelo custo estimado.
+  kMotorAutomatico,
+
+  // Memoização de `Cifra::ResolveFaixa` sobre todas as configurações.
+  kMotorMemoizacao,
+
+  // Produtos de matrizes de `Cifra::ResolveProdutos`, sempre que as matrizes
+  // cabem em memória.
+  kMotorProdutos,
+};
+
+/// @brief Parâmetros que escolhem como uma caixa é resolvida.
+struct ParametrosResolucao {
+  // Largura do feixe. Um valor de 0 indica que a caixa deve ser resolvida de
+  // forma exata, com `Cifra::Resolve`.
+  int largura_feixe = 0;
+
+  // Número de configurações da primeira linha testadas pela busca em feixe.
+  int sementes_feixe = 4;
+
+  // Método da resolução exata.
+  MotorExato motor = kMotorAutomatico;
+
+  // Cache de planos de topologia consultado pela resolução exata, ou
+  // `nullptr` para que cada caixa calcule o seu próprio plano.
+  CachePlanos *planos = nullptr;
+};
+
+/// @brief Estimativa do custo da resolução exata de uma caixa com cada motor
+/// (`Cifra::EstimaCusto`).
+struct CustoResolucao {
+  // Número aproximado de operações da memoização e dos produtos de matrizes.
+  double memoizacao = 0, produtos = 0;
+
+  // Tamanho da matriz de memoização, em bytes.
+  double bytes_memoizacao = 0;
+
+  // Indica se as matrizes dos produtos cabem em memória.
+  bool cabem_produtos = false;
+};
+
+/// @brief Uma solução de uma caixa, como impressa pelo programa, a ser
+/// verificada com `Cifra::Verifica`.
+struct Solucao {
+  // Número de cristais e soma dos brilhos informados pela solução.
+  int num_cristais = 0;
+  long long soma = 0;
+
+  // Posição (x, y) de cada cristal usado, 1-based.
+  vector<pair<int, int>> cristais;
+};
+
+/// @brief Representa um estado da busca em feixe (`Cifra::ResolveFeixe`).
+struct EstadoFeixe {
+  // Perfil quebrado da caixa: ao processar a coluna j da linha i, os bits
+  // 0..j-1 guardam as escolhas da linha i e os bits j..C-1 as da linha i-1.
+  // Ao final de uma linha, guarda a configuração completa da linha.
+  uint64_t fronteira = 0;
+
+  // Soma dos brilhos dos cristais escolhidos até agora.
+  int valor = 0;
+
+  // Índice, no feixe do final da linha anterior, do estado que originou este.
+  // Um valor de -1 indica que não há linha anterior.
+  int pai = -1;
+};
+
+/// @brief Representa e resolve um problema da Cifra Carmesim.
+class Cifra {
+ public:
+  /// @brief Número máximo de colunas suportado pela busca em feixe, que guarda
+  /// a configuração de uma linha em uma máscara de 64 bits.
+  static const int kMaxColunasFeixe = 64;
+
+  /// @brief Número máximo de colunas suportado pela resolução exata, que
+  /// guarda a configuração de uma linha em um `int`.
+  static const int kMaxColunasExato = 30;
+
+  /// @brief Constroi um problema da Cifra Carmesim.
+  /// @param l O número de linhas da caixa
+  /// @param c O número de colunas da caixa
+  /// @param n O número de cristais da caixa
+  Cifra(int l, int c, int n);
+
+  /// @brief Constroi um problema vazio, a ser preenchido com `Reinicia` ou
+  /// `Associa`.
+  Cifra() = default;
+
+  /// @brief Reinicia o problema para uma nova caixa vazia, descartando a
+  /// caixa e a solução anteriores. A memória já alocada pela caixa e pela
+  /// memoização é reaproveitada, o que permite resolver várias caixas com um
+  /// mesmo objeto sem novas alocações.
+  /// @param l O número de linhas da caixa
+  /// @param c O número de colunas da caixa
+  /// @param n O número de cristais da caixa
+  void Reinicia(int l, int c, int n);
+
+  /// @brief Reinicia o problema com uma caixa que aponta para arranjos
+  /// externos, sem copiá-los (ver `Caixa::Associa`).
+  /// @param l O número de linhas da caixa
+  /// @param c O número de colunas da caixa
+  /// @param n O número de cristais da caixa
+  /// @param brilhos O arranjo de `l * c` brilhos, linha a linha
+  /// @param conexoes O arranjo de conexões empacotadas
+  void Associa(int l, int c, int n, const int32_t *brilhos,
+               const uint8_t *conexoes);
+
+  /// @brief Adiciona um cristal à caixa na posição (`x`, `y`)
+  /// @param x A linha onde fica o cristal (1-based)
+  /// @param y A coluna onde fica o cristal (1-based)
+  /// @param v O valor de brilho do cristal
+  /// @param d Indica se o cristal está conectado com o cristal à sua direita
+  /// @param c Indica se o cristal está conectado com o cristal acima
+  /// @param e Indica se o cristal está conectado com o cristal à sua esquerda
+  /// @param b Indica se o cristal está conectado com o cristal abaixo
+  /// @attention O par (x, y) significa linha x e coluna y, não são coordenadas
+  /// cartesianas. As coordenadas x e y são iniciadas em 1, não em 0. Os
+  /// indicadores de conexões (d, c, e, b) devem receber apenas valores de 1 (se
+  /// a conexão existe) ou 0 (caso contrário).
+  void AdicionaCristal(int x, int y, int v, int d, int c, int e, int b);
+
+  /// @brief Resolve o problema da caixa representada. Deve ser chamado apenas
+  /// quando todos os cristais já tiverem sido adicionados, e antes que qualquer
+  /// informação sobre a solução seja consultada.
+  /// @param motor O método de resolução
+  void Resolve(MotorExato motor = kMotorAutomatico);
+
+  /// @brief Prepara o plano de topologia usado pela resolução exata,
+  /// obtendo-o do cache ou calculando-o. `Resolve` o prepara sozinho, e
+  /// `ResolveFaixa` calcula um plano próprio se nenhum tiver sido preparado;
+  /// prepará-lo antes de dividir a resolução em processos faz com que todos
+  /// herdem o mesmo plano.
+  /// @param planos O cache de planos, ou `nullptr`
+  void PreparaPlano(CachePlanos *planos);
+
+  /// @brief Estima o custo da resolução exata da caixa com cada motor, sem
+  /// resolvê-la. Prepara o plano de topologia, se necessário.
+  CustoResolucao EstimaCusto();
+
+  /// @brief Resolve o problema de forma exata restrito a uma faixa de
+  /// configurações da última linha (o laço da costura vertical de `Resolve`),
+  /// sem alterar a solução do problema. Faixas disjuntas podem ser resolvidas
+  /// em paralelo, por processos diferentes, e combinadas com `AplicaSolucao`.
+  /// @param inicio A primeira configuração da faixa
+  /// @param fim A configuração seguinte à última da faixa
+  /// @param confs Recebe a configuração de cada linha da melhor solução da
+  /// faixa
+  /// @return O valor da melhor solução da faixa, ou -1 se não houver nenhuma.
+  /// Em caso de empate, vale a menor configuração da última linha.
+  int ResolveFaixa(int inicio, int fim, vector<int> &confs);
+
+  /// @brief Define a solução do problema a partir da configuração de cada
+  /// linha, como encontrada por `ResolveFaixa`.
+  /// @param valor O valor da solução
+  /// @param confs A configuração de cada linha
+  void AplicaSolucao(int valor, const vector<int> &confs);
+
+  /// @brief Define a solução do problema a partir de máscaras de linha, como
+  /// as do formato binário de soluções, sem resolvê-lo. Usado para restaurar
+  /// soluções guardadas.
+  /// @param valor O valor da solução
+  /// @param limite_superior O limite superior para o ótimo
+  /// @param mascaras `L_` máscaras de `palavras_por_linha` palavras, onde o
+  /// bit j da linha i indica se o cristal (i + 1, j + 1) é usado
+  /// @param palavras_por_linha O número de palavras de 64 bits de cada máscara
+  void DefineSolucao(int valor, int limite_superior, const uint64_t *mascaras,
+                     size_t palavras_por_linha);
+
+  /// @brief Resolve o problema com o método escolhido pelos parâmetros.
+  /// @param parametros Os parâmetros de resolução, que devem ter sido
+  /// validados com `ValidaParametros`
+  void Resolve(const ParametrosResolucao &parametros);
+
+  /// @brief Verifica se a caixa pode ser resolvida com os parâmetros dados.
+  /// @param parametros Os parâmetros de resolução
+  /// @return `nullptr` se os parâmetros são válidos para a caixa, ou uma
+  /// mensagem de erro caso contrário.
+  const char *ValidaParametros(const ParametrosResolucao &parametros);
+
+  /// @brief Resolve o problema de forma aproximada com uma busca em feixe
+  /// célula a célula, mantendo apenas os `largura` melhores perfis a cada
+  /// passo. Serve para caixas largas demais para `Resolve`, e executa em tempo
+  /// linear em `L_` e em `largura`.
+  /// @param largura O número máximo de estados mantidos no feixe
+  /// @param num_sementes O número de configurações da primeira linha que são
+  /// testadas para fechar a costura vertical da caixa
+  /// @attention Suporta no máximo `kMaxColunasFeixe` colunas. A solução pode
+  /// não ser ótima; `GetLimiteSuperior` informa um limite para o ótimo.
+  void ResolveFeixe(int largura, int num_sementes);
+
+  /// @brief Verifica se uma solução é válida para a caixa, em tempo linear no
+  /// número de cristais da solução: cada posição usada deve ter um cristal e
+  /// aparecer uma única vez, nenhum par de cristais usados pode estar
+  /// conectado (inclusive pelas costuras da caixa) e o número de cristais e a
+  /// soma dos brilhos informados devem conferir. Não verifica se a solução é
+  /// ótima.
+  /// @param solucao A solução
+  /// @param indice Recebe o índice, em `solucao.cristais`, do cristal que
+  /// viola uma restrição, ou -1 se o erro não se refere a um único cristal
+  /// @return `nullptr` se a solução é válida, ou uma mensagem de erro
+  const char *Verifica(const Solucao &solucao, int &indice);
+
+  /// @brief Retorna o número de cristais usados na solução e a soma de seus
+  /// brilhos.
+  /// @return Um par de `int`s onde o primeiro é o número de cristais usados e o
+  /// segundo é soma dos seus brilhos
+  pair<int, int> GetValoresSolucao() {
+    return {num_cristais_usados_, max_valor_caixa_};
+  }
+
+  /// @brief Retorna uma lista dos cristais usados na solução
+  /// @return Um vector de pares (x, y) representando a posição de cada cristal
+  /// utilizado
+  vector<pair<int, int>> &GetCristaisSolucao() { return cristais_solucao_; }
+
+  /// @brief Retorna o número de cristais da caixa
+  int GetNumCristais() { return N_; }
+
+  /// @brief Retorna o número de estados calculados pelas resoluções desde o
+  /// último `Reinicia`: estados da memoização, elementos das matrizes dos
+  /// produtos e estados gerados pela busca em feixe.
+  long long GetEstadosCalculados() {
+    return estatisticas_.estados_calculados;
+  }
+
+  /// @brief Retorna os contadores das resoluções desde o último `Reinicia`.
+  const EstatisticasResolucao &GetEstatisticas() { return estatisticas_; }
+
+  /// @brief Soma aos contadores os de uma resolução feita em outro processo.
+  void AcumulaEstatisticas(const EstatisticasResolucao &outras) {
+    estatisticas_.Acumula(outras);
+  }
+
+  /// @brief Retorna o tempo gasto pelas resoluções em cada fase desde o
+  /// último `Reinicia`. A leitura e a saída são medidas por quem as faz.
+  const TemposFases &GetTempos() { return tempos_; }
+
+  /// @brief Retorna o tamanho, em bytes, da memória reservada para a
+  /// memoização.
+  size_t GetBytesMemoizacao() { return memo_.capacity() * sizeof(Resposta); }
+
+  /// @brief Define o número de cristais da caixa, para leitores que só o
+  /// conhecem depois de preencher a caixa.
+  void DefineNumCristais(int n) { N_ = n; }
+
+  /// @brief Retorna a caixa do problema
+  const Caixa &GetCaixa() { return caixa_; }
+
+  /// @brief Retorna a caixa do problema para ser preenchida diretamente,
+  /// sem passar por `AdicionaCristal`. Deve ser usada apenas entre `Reinicia`
+  /// e a resolução.
+  Caixa &EditaCaixa() { return caixa_; }
+
+  /// @brief Retorna um limite superior para o valor ótimo da caixa, calculado
+  /// pela última chamada de `ResolveFeixe`. Após `Resolve`, é o próprio ótimo.
+  int GetLimiteSuperior() { return limite_superior_; }
+
+ private:
+  int L_ = 0, C_ = 0, N_ = 0;
+
+  /// @brief Número de configurações possíveis que uma linha da caixa pode
+  /// assumir (2**C_). Só é calculado por `Resolve`.
+  int num_possibilidades_ = 0;
+
+  /// @brief Faixa de configurações da última linha coberta pela memoização:
+  /// começa em `conf_inicial_base_` e tem `num_confs_iniciais_` elementos.
+  int conf_inicial_base_ = 0, num_confs_iniciais_ = 0;
+
+  /// @brief Número de cristais utilizados na solução
+  int num_cristais_usados_ = 0;
+
+  /// @brief Valor da solução ótima da caixa.
+  int max_valor_caixa_ = 0;
+
+  /// @brief Limite superior para o valor ótimo da caixa.
+  int limite_superior_ = 0;
+
+  /// @brief Contadores e tempos das fases das resoluções desde o último
+  /// `Reinicia`.
+  EstatisticasResolucao estatisticas_;
+  TemposFases tempos_;
+
+  /// @brief Lista de cristais utilizados na solução
+  vector<pair<int, int>> cristais_solucao_;
+
+  /// @brief Matriz `L_`x`C_` dos cristais do problema
+  Caixa caixa_;
+
+  /// @brief Plano de topologia da caixa usado pela resolução exata, que é o
+  /// plano obtido do cache ou o próprio. É nulo até ser preparado.
+  const PlanoTopologia *plano_ = nullptr;
+  std::shared_ptr<const PlanoTopologia> plano_compartilhado_;
+  PlanoTopologia plano_proprio_;
+
+  /// @brief Matriz `L_`x`num_possibiliddes_`x`num_confs_iniciais_` de
+  /// memoização da função de programação dinâmica, guardada de forma contígua
+  vector<Resposta> memo_;
+
+  /// @brief Retorna a posição da matriz de memoização correspondente ao estado
+  /// (`linha`, `conf`, `conf_inicial`).
+  inline Resposta &Memo(int linha, int conf, int conf_inicial) {
+    return memo_[IndiceMemo(linha, conf, conf_inicial - conf_inicial_base_,
+                            num_possibilidades_, num_confs_iniciais_)];
+  }
+
+  /// @brief Programação dinâmica que encontra a maior soma de cristais da
+  /// caixa, dado uma configuração inicial e uma configuração de linha.
+  /// @param linha O índice da linha atual da caixa
+  /// @param conf A configuração da linha atual da caixa
+  /// @param conf_inicial A configuração utilizada na última linha da caixa
+  /// neste ramo da árvore de recursão
+  /// @return Uma `Resposta` onde `valor` é o maior valor encontrado e `conf` é
+  /// a configuração que foi utilizada na linha acima para encontrar este
+  /// máximo.
+  Resposta f(int linha, int conf, int conf_inicial);
+
+  /// @brief Verifica se a configuração `conf` não quebra nenhuma restrição para
+  /// a linha `linha`
+  /// @param linha O índice linha da caixa a ser verificada
+  /// @param conf A configuração de cristais ativados a ser testada para a linha
+  /// dada
+  /// @return `true` se a configuração é valida, `false` caso contrário.
+  inline bool EhInternamenteConsistente(int linha, int conf) {
+    return ConfiguracaoConsistente(plano_->Linha(linha), conf, C_);
+  }
+
+  /// @brief Verifica se a configuração `conf_i` para a linha `linha` da caixa
+  /// não quebra nenhuma restrição se utilizada com a configuração `conf_s` para
+  /// a linha acima.
+  /// @param linha O índice da linha superior do par de linhas adjacentes a ser
+  /// verificado
+  /// @param conf_i A configuração da linha inferior do par a ser verificado
+  /// @param conf_s A configuração da linha superior do par a ser verificado
+  /// @return `true` se as configurações são compatíveis, `false` caso
+  /// contrário.
+  inline bool SaoCompativeis(int linha, int conf_i, int conf_s) {
+    return ConfiguracoesCompativeis(plano_->Linha(linha), conf_i, conf_s);
+  }
+
+  /// @brief Agrupa as linhas da caixa para `ResolveProdutos`.
+  /// @param classes Recebe, para cada linha, um identificador que é o mesmo
+  /// para linhas com os mesmos brilhos e conexões horizontais
+  /// @param sequencias Recebe o início de cada sequência de linhas consecutivas
+  /// com a mesma transição a partir da linha anterior, seguido de `L_`
+  void AgrupaLinhas(vector<int> &classes, vector<int> &sequencias);
+
+  /// @brief Estima o custo da memoização de `ResolveFaixa` e de
+  /// `ResolveProdutos`. Os produtos são mais baratos quando a caixa tem
+  /// sequências longas de linhas iguais.
+  /// @param sequencias As sequências de linhas, de `AgrupaLinhas`
+  CustoResolucao CalculaCusto(const vector<int> &sequencias);
+
+  /// @brief Resolve o problema de forma exata com produtos de matrizes na
+  /// álgebra max-plus: cada linha é uma matriz de transição a partir da linha
+  /// anterior, e a diagonal do produto de todas dá o valor de cada
+  /// configuração da última linha. Uma sequência de k linhas iguais é uma
+  /// potência, calculada com O(log k) produtos. Encontra a mesma solução que
+  /// `ResolveFaixa` sobre todas as configurações.
+  /// @param classes As classes das linhas, de `AgrupaLinhas`
+  /// @param sequencias As sequências de linhas, de `AgrupaLinhas`
+  /// @param confs Recebe a configuração de cada linha da melhor solução
+  /// @return O valor da melhor solução, ou -1 se não houver nenhuma
+  int ResolveProdutos(const vector<int> &classes,
+                      const vector<int> &sequencias, vector<int> &confs);
+
+  /// @brief Executa uma passada da busca em feixe sobre a caixa.
+  /// @param largura O número máximo de estados mantidos no feixe
+  /// @param com_semente Indica se a primeira linha está fixada em `semente`.
+  /// Caso não esteja, a costura vertical é ignorada (a caixa é tratada como um
+  /// cilindro) e a passada serve apenas para sugerir sementes.
+  /// @param semente A configuração fixada para a primeira linha
+  /// @param sufixos As estimativas otimistas de `CalculaSufixosOtimistas`
+  /// @param historico Recebe, para cada linha, o feixe ao final da linha
+  /// @return O índice do melhor estado em `historico[L_ - 1]`
+  int PassadaFeixe(int largura, bool com_semente, uint64_t semente,
+                   const vector<vector<int>> &sufixos,
+                   vector<vector<EstadoFeixe>> &historico);
+
+  /// @brief Calcula, para cada linha, o maior valor que uma configuração pode
+  /// obter em cada sufixo de colunas, ignorando as conexões verticais e a
+  /// costura horizontal. Usado como estimativa otimista pela busca em feixe.
+  /// @param sufixos Recebe, para cada linha i, um vetor onde a posição
+  /// 2 * j + b é o maior valor das colunas j..C_-1, com b indicando se o
+  /// cristal da coluna j-1 foi escolhido
+  void CalculaSufixosOtimistas(vector<vector<int>> &sufixos);
+
+  /// @brief Função de depuração que imprime o conteúdo da caixa
+  void DumpCaixa();
+
+  /// @brief Função de depuração que imprime o conteúdo da matriz de memoização.
+  void DumpMemo();
+};
+
+#endif
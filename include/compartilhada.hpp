@@ -0,0 +1,214 @@
+#ifndef COMPARTILHADA_HPP
+#define COMPARTILHADA_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Situação de uma vaga da fila compartilhada.
+enum EstadoVaga : uint32_t {
+  // A vaga pode ser reservada por um cliente.
+  kVagaLivre = 0,
+
+  // Um cliente reservou a vaga e está escrevendo a caixa nela.
+  kVagaReservada = 1,
+
+  // A caixa foi submetida e aguarda (ou está em) resolução.
+  kVagaPendente = 2,
+
+  // A solução foi escrita na vaga, no formato binário de soluções.
+  kVagaPronta = 3,
+
+  // A caixa não pôde ser resolvida; a vaga contém a mensagem de erro.
+  kVagaErro = 4,
+};
+
+/// @brief Etapas do encerramento do servidor.
+enum EncerramentoFila : uint32_t {
+  kFilaAtiva = 0,
+
+  // Os trabalhadores estão terminando; novas submissões são recusadas.
+  kFilaEncerrando = 1,
+
+  // Os trabalhadores terminaram e as vagas pendentes foram concluídas.
+  kFilaFinalizada = 2,
+};
+
+/// @brief Contador usado para esperar, com futex, por uma condição sinalizada
+/// por outro processo. Só faz chamadas de sistema quando há alguém esperando.
+struct SinalCompartilhado {
+  std::atomic<uint32_t> sequencia;
+  std::atomic<uint32_t> esperando;
+};
+
+/// @brief Descritor de uma vaga, guardado no segmento compartilhado.
+struct DescritorVaga {
+  // Um valor de `EstadoVaga`. Também é a palavra de futex que o cliente usa
+  // para esperar a conclusão.
+  std::atomic<uint32_t> estado;
+
+  // Indica que o cliente está dormindo à espera da conclusão.
+  std::atomic<uint32_t> aguardando;
+
+  // Tamanho da caixa escrita no início da vaga, em bytes.
+  uint64_t tamanho_entrada;
+
+  // Posição e tamanho do resultado (solução ou mensagem de erro) na vaga.
+  uint64_t inicio_resultado, tamanho_resultado;
+};
+
+/// @brief Célula do anel de submissões (mesmo algoritmo de `FilaLimitada`).
+struct CelulaAnel {
+  std::atomic<uint64_t> sequencia;
+  uint32_t vaga;
+};
+
+/// @brief Cabeçalho do segmento compartilhado. O segmento é composto por este
+/// cabeçalho, pelo anel de submissões, pelos descritores das vagas e, a partir
+/// de uma posição alinhada à página, pelas vagas.
+struct CabecalhoCompartilhado {
+  // Identifica o segmento. Deve conter `kMagicaCompartilhada`.
+  char magica[8];
+
+  // Versão do layout. Deve ser `kVersaoCompartilhada`.
+  uint32_t versao;
+
+  // Número de vagas e máscara do anel (capacidade - 1).
+  uint32_t num_vagas, mascara_anel;
+
+  // Tamanho de cada vaga e posição da primeira, em bytes.
+  uint64_t tamanho_vaga, inicio_vagas;
+
+  // Um valor de `EncerramentoFila`.
+  std::atomic<uint32_t> encerrado;
+
+  // Contadores do anel, em linhas de cache separadas.
+  alignas(64) std::atomic<uint64_t> inicio_anel;
+  alignas(64) std::atomic<uint64_t> fim_anel;
+
+  // Sinalizados a cada submissão e a cada vaga liberada.
+  alignas(64) SinalCompartilhado submissoes;
+  alignas(64) SinalCompartilhado liberacoes;
+};
+
+/// @brief Sequência que identifica o segmento compartilhado.
+const char kMagicaCompartilhada[8] = {'C', 'I', 'F', 'R', 'A', 'S', 'H', 'M'};
+
+/// @brief Versão atual do layout do segmento compartilhado.
+const uint32_t kVersaoCompartilhada = 1;
+
+/// @brief Fila de trabalhos em memória compartilhada, para clientes na mesma
+/// máquina. O cliente reserva uma vaga, escreve nela uma caixa (de preferência
+/// no formato binário, que é lido sem cópias) e a submete; um trabalhador do
+/// servidor resolve a caixa diretamente na vaga e escreve a solução, no
+/// formato binário de soluções, logo após a caixa. As esperas usam futex, sem
+/// espera ativa. Os clientes são considerados confiáveis: não devem alterar
+/// uma vaga submetida até a sua conclusão.
+class FilaCompartilhada {
+ public:
+  FilaCompartilhada() = default;
+  ~FilaCompartilhada();
+
+  FilaCompartilhada(const FilaCompartilhada &) = delete;
+  FilaCompartilhada &operator=(const FilaCompartilhada &) = delete;
+
+  /// @brief Cria o segmento compartilhado. Usado pelo servidor, que remove o
+  /// segmento ao ser destruído.
+  /// @param nome O nome do segmento (como em `shm_open`, por ex. "/cifra")
+  /// @param num_vagas O número de vagas
+  /// @param tamanho_vaga O tamanho mínimo de cada vaga, em bytes
+  /// @param substitui Remove antes um segmento de mesmo nome, deixado por um
+  /// servidor que não terminou normalmente. Sem ela, a criação falha com
+  /// `EEXIST` se o segmento existir
+  /// @return Se o segmento foi criado
+  bool Cria(const char *nome, int num_vagas, size_t tamanho_vaga,
+            bool substitui);
+
+  /// @brief Abre um segmento criado pelo servidor. Usado pelos clientes.
+  /// @param nome O nome do segmento
+  /// @return Se o segmento foi aberto e é válido
+  bool Abre(const char *nome);
+
+  int GetNumVagas() const { return cabecalho_->num_vagas; }
+  size_t GetTamanhoVaga() const { return cabecalho_->tamanho_vaga; }
+
+  /// @brief Retorna o número aproximado de caixas submetidas que ainda não
+  /// foram retiradas por um trabalhador.
+  uint64_t GetPendentesAproximado() const {
+    uint64_t fim = cabecalho_->fim_anel.load(std::memory_order_relaxed);
+    uint64_t inicio = cabecalho_->inicio_anel.load(std::memory_order_relaxed);
+    return fim > inicio ? fim - inicio : 0;
+  }
+
+  /// @brief Retorna o tamanho da caixa submetida em uma vaga, em bytes.
+  size_t GetTamanhoEntrada(int vaga) const {
+    return descritores_[vaga].tamanho_entrada;
+  }
+
+  /// @brief Retorna o início de uma vaga, alinhado à página.
+  char *GetVaga(int vaga) {
+    return base_ + cabecalho_->inicio_vagas + vaga * cabecalho_->tamanho_vaga;
+  }
+
+  // ----------------------------- Clientes ---------------------------------
+
+  /// @brief Reserva uma vaga livre, esperando se não houver nenhuma.
+  /// @return O índice da vaga, ou -1 se o servidor foi encerrado.
+  int ReservaVaga();
+
+  /// @brief Submete a caixa escrita no início de uma vaga reservada.
+  /// @param vaga A vaga
+  /// @param tamanho O tamanho da caixa, em bytes
+  /// @return `false` se o servidor foi encerrado.
+  bool Submete(int vaga, size_t tamanho);
+
+  /// @brief Espera a conclusão de uma vaga submetida. A vaga continua
+  /// reservada e pode ser submetida novamente.
+  /// @param vaga A vaga
+  /// @param resultado Recebe a solução ou a mensagem de erro, dentro da vaga
+  /// @param tamanho Recebe o tamanho do resultado, em bytes
+  /// @return `true` se a caixa foi resolvida, `false` caso contrário.
+  bool Aguarda(int vaga, const char *&resultado, size_t &tamanho);
+
+  /// @brief Devolve uma vaga reservada.
+  void LiberaVaga(int vaga);
+
+  // ----------------------------- Servidor ---------------------------------
+
+  /// @brief Retira a próxima vaga submetida, esperando se não houver nenhuma.
+  /// @return O índice da vaga, ou -1 se o servidor foi encerrado.
+  int ProximaVaga();
+
+  /// @brief Conclui uma vaga, acordando o cliente que a aguarda.
+  /// @param vaga A vaga
+  /// @param sucesso Se o resultado é uma solução ou uma mensagem de erro
+  /// @param inicio A posição do resultado na vaga, em bytes
+  /// @param tamanho O tamanho do resultado, em bytes
+  void Conclui(int vaga, bool sucesso, size_t inicio, size_t tamanho);
+
+  /// @brief Começa o encerramento da fila, recusando novas submissões e
+  /// acordando todos os clientes e trabalhadores.
+  void Encerra();
+
+  /// @brief Termina o encerramento depois que os trabalhadores pararam,
+  /// concluindo com erro as vagas que ficaram pendentes.
+  void Finaliza();
+
+ private:
+  /// @brief Tenta retirar uma vaga do anel de submissões.
+  bool TentaRetirar(int &vaga);
+
+  /// @brief Tenta reservar uma vaga livre.
+  bool TentaReservar(int &vaga);
+
+  char *base_ = nullptr;
+  size_t tamanho_ = 0;
+  CabecalhoCompartilhado *cabecalho_ = nullptr;
+  CelulaAnel *anel_ = nullptr;
+  DescritorVaga *descritores_ = nullptr;
+
+  // Nome do segmento, guardado apenas pelo servidor para removê-lo.
+  char nome_[256] = {};
+};
+
+#endif
@@ -0,0 +1,60 @@
+#ifndef CONTADORES_HPP
+#define CONTADORES_HPP
+
+/// @brief Eventos de hardware medidos por `ContadoresHardware`.
+enum EventoHardware {
+  kEventoCiclos,
+  kEventoInstrucoes,
+  kEventoFaltasLlc,
+  kEventoFaltasDtlb,
+  kEventoDesviosErrados,
+  kNumEventos,
+};
+
+/// @brief Retorna o nome de um evento de hardware.
+const char *NomeEvento(EventoHardware evento);
+
+/// @brief Contadores de desempenho do processador, abertos com
+/// `perf_event_open` para a thread que os abre e para os processos e threads
+/// criados por ela depois da abertura. Cada evento é aberto separadamente, e
+/// os que o processador, o kernel ou o contêiner não oferecem ficam
+/// indisponíveis sem impedir a medição dos demais.
+class ContadoresHardware {
+ public:
+  ContadoresHardware();
+  ~ContadoresHardware();
+
+  ContadoresHardware(const ContadoresHardware &) = delete;
+  ContadoresHardware &operator=(const ContadoresHardware &) = delete;
+
+  /// @brief Abre e inicia os contadores.
+  /// @return nullptr se algum evento pôde ser aberto, ou o motivo de nenhum
+  /// estar disponível
+  const char *Abre();
+
+  /// @brief Indica se um evento está sendo medido.
+  bool Disponivel(EventoHardware evento) const { return fds_[evento] >= 0; }
+
+  /// @brief Retorna o motivo do primeiro evento indisponível, ou nullptr se
+  /// todos estão disponíveis.
+  const char *GetMotivo() const { return motivo_; }
+
+  /// @brief Lê o valor atual de cada evento, corrigido pela fração do tempo
+  /// em que o evento esteve no processador quando os contadores são
+  /// multiplexados. Eventos indisponíveis são lidos como 0.
+  void Le(long long valores[kNumEventos]) const;
+
+ private:
+  int fds_[kNumEventos];
+  const char *motivo_ = nullptr;
+};
+
+/// @brief Define os contadores lidos por `CronometroFase` no início e no fim
+/// de cada fase, ou nullptr para não medir eventos de hardware. Deve ser
+/// chamada antes de qualquer medição, pela thread dona dos contadores.
+void AtivaContadoresHardware(ContadoresHardware *contadores);
+
+/// @brief Retorna os contadores ativos, ou nullptr.
+ContadoresHardware *GetContadoresHardware();
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef ENTRADA_HPP
+#define ENTRADA_HPP
+
+#include "cifra.hpp"
+#include "leitor.hpp"
+
+/// @brief Representa um cristal como descrito em uma linha da entrada:
+/// `x y v d c e b`.
+struct CristalLido {
+  int x = 0, y = 0, v = 0, d = 0, c = 0, e = 0, b = 0;
+};
+
+/// @brief Lê e valida o cabeçalho `L C N` da entrada.
+/// @param leitor O leitor posicionado no início da entrada
+/// @param L Recebe o número de linhas da caixa
+/// @param C Recebe o número de colunas da caixa
+/// @param N Recebe o número de cristais da caixa
+/// @return `true` se o cabeçalho é válido, `false` caso contrário (o erro fica
+/// registrado no leitor).
+bool LeCabecalho(Leitor &leitor, int &L, int &C, int &N);
+
+/// @brief Lê e valida a descrição de um cristal da entrada.
+/// @param leitor O leitor posicionado no início da descrição do cristal
+/// @param L O número de linhas da caixa
+/// @param C O número de colunas da caixa
+/// @param cristal Recebe o cristal lido
+/// @return `true` se o cristal é válido, `false` caso contrário (o erro fica
+/// registrado no leitor).
+inline bool LeCristal(Leitor &leitor, int L, int C, CristalLido &cristal) {
+  if (!leitor.LeInteiro(cristal.x) || !leitor.LeInteiro(cristal.y) ||
+      !leitor.LeInteiro(cristal.v) || !leitor.LeInteiro(cristal.d) ||
+      !leitor.LeInteiro(cristal.c) || !leitor.LeInteiro(cristal.e) ||
+      !leitor.LeInteiro(cristal.b)) {
+    return false;
+  }
+
+  if (cristal.x < 1 || cristal.x > L || cristal.y < 1 || cristal.y > C) {
+    return leitor.Falha("posição do cristal fora da caixa");
+  }
+
+  if (cristal.v < 0) {
+    return leitor.Falha("o brilho do cristal não pode ser negativo");
+  }
+
+  // Os indicadores de conexão só podem valer 0 ou 1
+  if ((cristal.d | cristal.c | cristal.e | cristal.b) & ~1) {
+    return leitor.Falha("indicadores de conexão devem ser 0 ou 1");
+  }
+
+  return true;
+}
+
+/// @brief Formatos de entrada aceitos.
+enum class FormatoEntrada {
+  // `L C N` seguido de N linhas `x y v d c e b`.
+  kTexto,
+
+  // `DENSA L C`, seguido de L linhas com os C brilhos de cada linha (-1 onde
+  // não há cristal) e de L linhas com C dígitos de conexão, um por posição,
+  // valendo d + 2 * c (conexões à direita e acima).
+  kDensa,
+
+  // Formato binário de `binario.hpp`.
+  kBinario,
+};
+
+/// @brief Palavra que inicia uma entrada no formato denso.
+const char kPalavraDensa[] = "DENSA";
+
+/// @brief Detecta o formato da entrada, consumindo o seu marcador (como
+/// `kPalavraDensa`), caso exista.
+/// @param leitor O leitor posicionado no início da entrada
+/// @return O formato detectado
+FormatoEntrada DetectaFormato(Leitor &leitor);
+
+/// @brief Lê uma instância da entrada em um formato já detectado por
+/// `DetectaFormato`, sem exigir que a entrada termine depois dela. Permite ler
+/// várias instâncias seguidas de uma mesma entrada.
+/// @param leitor O leitor posicionado logo após o marcador do formato
+/// @param formato O formato da instância
+/// @param cifra Recebe a caixa lida, reaproveitando a memória que já possuir.
+/// No formato binário, a caixa não é copiada e aponta para o buffer do
+/// leitor, que deve continuar vivo enquanto ela for usada.
+/// @param num_threads O número de threads usadas na leitura do formato texto.
+/// Com mais de uma thread, a instância deve ocupar o restante da entrada e
+/// cada cristal deve estar descrito em uma única linha. Os outros formatos são
+/// sempre lidos por uma única thread.
+/// @return `true` se a instância é válida, `false` caso contrário (o erro
+/// fica registrado no leitor).
+bool LeInstancia(Leitor &leitor, FormatoEntrada formato, Cifra &cifra,
+                 int num_threads = 1);
+
+/// @brief Lê uma solução que ocupa a entrada inteira, no formato texto (como
+/// o de `EscreveSolucaoTexto`) ou no formato binário de soluções, detectando o
+/// formato automaticamente.
+/// @param leitor O leitor com a solução já aberta
+/// @param caixa A caixa a que a solução se refere, cujas dimensões devem ser
+/// as de uma solução binária
+/// @param solucao Recebe a solução lida
+/// @return `true` se a solução pôde ser lida, `false` caso contrário (o erro
+/// fica registrado no leitor). A validade da solução para a caixa não é
+/// verificada.
+bool LeSolucao(Leitor &leitor, const Caixa &caixa, Solucao &solucao);
+
+/// @brief Lê uma caixa que ocupa a entrada inteira, detectando o formato
+/// automaticamente.
+/// @param leitor O leitor com a entrada já aberta
+/// @param cifra Recebe a caixa lida (ver `LeInstancia`)
+/// @param num_threads O número de threads usadas na leitura do formato texto
+/// @return `true` se a entrada é válida, `false` caso contrário (o erro fica
+/// registrado no leitor).
+bool LeCaixa(Leitor &leitor, Cifra &cifra, int num_threads = 1);
+
+#endif
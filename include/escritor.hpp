@@ -0,0 +1,119 @@
+#ifndef ESCRITOR_HPP
+#define ESCRITOR_HPP
+
+#include <unistd.h>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+using std::vector;
+
+/// @brief Escritor de texto com um buffer grande, que só é enviado ao
+/// descritor de arquivo em blocos inteiros com `write`. Substitui chamadas de
+/// `printf` por valor quando a saída é longa.
+///
+/// Com o descritor `kMemoria`, o escritor apenas acumula a saída em memória,
+/// aumentando o buffer conforme necessário, para que ela seja copiada depois
+/// (por exemplo, por uma thread que escreve as saídas em ordem).
+class Escritor {
+ public:
+  /// @brief Descritor que indica que a saída deve ficar em memória.
+  static const int kMemoria = -1;
+
+  /// @brief Constroi um escritor.
+  /// @param fd O descritor de arquivo onde a saída será escrita, ou
+  /// `kMemoria`
+  explicit Escritor(int fd = STDOUT_FILENO)
+      : fd_(fd),
+        buffer_(fd == kMemoria ? kTamanhoInicialMemoria : kTamanhoBuffer) {}
+
+  /// @brief Descarrega o que ainda estiver no buffer.
+  ~Escritor() { Descarrega(); }
+
+  Escritor(const Escritor &) = delete;
+  Escritor &operator=(const Escritor &) = delete;
+
+  /// @brief Escreve um inteiro em decimal.
+  /// @param valor O inteiro a ser escrito
+  inline void EscreveInteiro(long long valor) {
+    // Um inteiro de 64 bits ocupa no máximo 20 caracteres com o sinal
+    if (usado_ + 20 > buffer_.size()) {
+      AbreEspaco(20);
+    }
+
+    unsigned long long absoluto = valor;
+    if (valor < 0) {
+      buffer_[usado_++] = '-';
+      absoluto = -absoluto;
+    }
+
+    // Escreve os dígitos de trás para frente em um buffer temporário
+    char digitos[20];
+    int num_digitos = 0;
+    do {
+      digitos[num_digitos++] = '0' + absoluto % 10;
+      absoluto /= 10;
+    } while (absoluto != 0);
+
+    while (num_digitos > 0) {
+      buffer_[usado_++] = digitos[--num_digitos];
+    }
+  }
+
+  /// @brief Escreve um único caractere.
+  /// @param caractere O caractere a ser escrito
+  inline void EscreveCaractere(char caractere) {
+    if (usado_ == buffer_.size()) {
+      AbreEspaco(1);
+    }
+    buffer_[usado_++] = caractere;
+  }
+
+  /// @brief Escreve uma sequência de bytes.
+  /// @param dados Os bytes a serem escritos
+  /// @param tamanho O número de bytes
+  void EscreveBytes(const char *dados, size_t tamanho);
+
+  /// @brief Envia o conteúdo do buffer ao descritor de arquivo. Não faz nada
+  /// quando a saída fica em memória.
+  /// @return `true` se tudo foi escrito, `false` se esta ou qualquer escrita
+  /// anterior falhou.
+  bool Descarrega();
+
+  /// @brief Retorna a saída acumulada em memória.
+  const char *GetDados() { return buffer_.data(); }
+
+  /// @brief Retorna o tamanho da saída acumulada em memória, em bytes.
+  size_t GetTamanho() { return usado_; }
+
+  /// @brief Descarta a saída acumulada em memória, mantendo o buffer alocado.
+  void Limpa() { usado_ = 0; }
+
+ private:
+  /// @brief Tamanho do buffer, em bytes.
+  static const size_t kTamanhoBuffer = 1 << 20;
+
+  /// @brief Tamanho inicial do buffer quando a saída fica em memória.
+  static const size_t kTamanhoInicialMemoria = 1 << 12;
+
+  int fd_;
+  vector<char> buffer_;
+
+  /// @brief Número de bytes ocupados do buffer.
+  size_t usado_ = 0;
+
+  /// @brief Indica que alguma escrita no descritor falhou. As escritas
+  /// seguintes são descartadas.
+  bool erro_ = false;
+
+  /// @brief Escreve bytes diretamente no descritor, marcando `erro_` se
+  /// falhar.
+  void Escreve(const char *dados, size_t tamanho);
+
+  /// @brief Garante espaço para mais `bytes` bytes no buffer, descarregando-o
+  /// ou, quando a saída fica em memória, aumentando-o.
+  void AbreEspaco(size_t bytes);
+};
+
+#endif
@@ -0,0 +1,151 @@
+#ifndef ESTATISTICAS_HPP
+#define ESTATISTICAS_HPP
+
+#include <chrono>
+#include <cstdio>
+
+#include "contadores.hpp"
+#include "rastreio.hpp"
+
+/// @brief Incrementa um contador de `EstatisticasResolucao` nos laços
+/// internos da resolução. Compilando com `-DCIFRA_SEM_ESTATISTICAS`, os
+/// contadores deixam de existir no código gerado.
+#ifdef CIFRA_SEM_ESTATISTICAS
+#define CIFRA_CONTA(contador, quantidade) ((void)0)
+#else
+#define CIFRA_CONTA(contador, quantidade) ((contador) += (quantidade))
+#endif
+
+/// @brief Método que efetivamente resolveu uma caixa.
+enum MetodoResolucao {
+  kMetodoNenhum,
+  kMetodoMemoizacao,
+  kMetodoProdutos,
+  kMetodoFeixe,
+  kNumMetodos,
+};
+
+/// @brief Retorna o nome de um método de resolução.
+const char *NomeMetodo(MetodoResolucao metodo);
+
+/// @brief Contadores da resolução de uma caixa. Exceto `estados_calculados`,
+/// que é sempre contado, só são atualizados sem `CIFRA_SEM_ESTATISTICAS`.
+struct EstatisticasResolucao {
+  MetodoResolucao metodo = kMetodoNenhum;
+
+  // Estados da memoização, elementos das matrizes dos produtos e estados
+  // gerados pela busca em feixe.
+  long long estados_calculados = 0;
+
+  // Consultas à memoização de `Cifra::f` que encontraram o estado já
+  // calculado, e que precisaram calculá-lo.
+  long long memo_acertos = 0, memo_faltas = 0;
+
+  // Verificações de compatibilidade entre configurações de linhas vizinhas.
+  long long verificacoes_compatibilidade = 0;
+
+  // Estados descartados por violarem alguma restrição.
+  long long estados_invalidos = 0;
+
+  // Configurações da costura vertical (da última linha, ou sementes do
+  // feixe) avaliadas, e descartadas sem avaliação por serem inválidas.
+  long long costuras_avaliadas = 0, costuras_ignoradas = 0;
+
+  // Bytes alocados pelas estruturas da resolução.
+  long long bytes_alocados = 0;
+
+  /// @brief Soma os contadores de outra resolução, como a de uma faixa
+  /// resolvida por outro processo.
+  void Acumula(const EstatisticasResolucao &outras);
+
+  /// @brief Subtrai os contadores de um instante anterior, deixando apenas o
+  /// que foi contado desde então.
+  void Desconta(const EstatisticasResolucao &anteriores);
+};
+
+/// @brief Fases da execução medidas por `CronometroFase`.
+enum FaseExecucao {
+  kFaseLeitura,
+  kFasePreparacao,
+  kFaseResolucao,
+  kFaseReconstrucao,
+  kFaseSaida,
+  kNumFases,
+};
+
+/// @brief Retorna o nome de uma fase.
+const char *NomeFase(FaseExecucao fase);
+
+/// @brief Tempo de parede gasto em cada fase, em segundos, e eventos de
+/// hardware contados em cada fase, quando há contadores ativos.
+struct TemposFases {
+  double segundos[kNumFases] = {};
+  long long eventos[kNumFases][kNumEventos] = {};
+
+  void Acumula(const TemposFases &outros);
+};
+
+/// @brief Mede o tempo de parede de um trecho de código, do construtor ao
+/// destrutor, e o acumula na fase correspondente, junto com os eventos dos
+/// contadores de hardware ativos (`AtivaContadoresHardware`). Com o rastreio
+/// ativo, a fase também aparece na linha do tempo.
+class CronometroFase {
+ public:
+  CronometroFase(TemposFases &tempos, FaseExecucao fase)
+      : tempos_(tempos), fase_(fase), contadores_(GetContadoresHardware()) {
+    if (contadores_ != nullptr) {
+      contadores_->Le(eventos_inicio_);
+    }
+    inicio_ = std::chrono::steady_clock::now();
+  }
+
+  ~CronometroFase() { Para(); }
+
+  /// @brief Encerra a medição antes do fim do escopo.
+  void Para() {
+    if (parado_) {
+      return;
+    }
+    parado_ = true;
+    auto fim = std::chrono::steady_clock::now();
+    tempos_.segundos[fase_] +=
+        std::chrono::duration<double>(fim - inicio_).count();
+    if (RastreioAtivo()) {
+      RegistraTrecho(NomeFase(fase_), "fase", InstanteRastreio(inicio_),
+                     InstanteRastreio(fim), -1);
+    }
+    if (contadores_ != nullptr) {
+      long long eventos_fim[kNumEventos];
+      contadores_->Le(eventos_fim);
+      for (int evento = 0; evento < kNumEventos; evento++) {
+        tempos_.eventos[fase_][evento] +=
+            eventos_fim[evento] - eventos_inicio_[evento];
+      }
+    }
+  }
+
+  CronometroFase(const CronometroFase &) = delete;
+  CronometroFase &operator=(const CronometroFase &) = delete;
+
+ private:
+  TemposFases &tempos_;
+  FaseExecucao fase_;
+  ContadoresHardware *contadores_;
+  long long eventos_inicio_[kNumEventos];
+  std::chrono::steady_clock::time_point inicio_;
+  bool parado_ = false;
+};
+
+/// @brief Escreve as estatísticas de uma execução como um objeto JSON.
+/// @param arquivo O arquivo onde o objeto será escrito
+/// @param estatisticas Os contadores da resolução
+/// @param tempos O tempo de cada fase
+/// @param em_cache Indica que a solução veio do cache, sem resolução
+/// @param hardware Os contadores de hardware usados na medição, ou nullptr
+/// para omitir os eventos
+void EscreveEstatisticasJson(FILE *arquivo,
+                             const EstatisticasResolucao &estatisticas,
+                             const TemposFases &tempos, bool em_cache,
+                             const ContadoresHardware *hardware);
+
+#endif
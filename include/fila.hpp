@@ -0,0 +1,153 @@
+#ifndef FILA_HPP
+#define FILA_HPP
+
+#include <time.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+/// @brief Espera ativa com recuo progressivo: gira algumas vezes, depois cede
+/// o processador e, se a espera se prolongar, dorme por curtos intervalos.
+/// @param tentativas O número de tentativas já feitas, que é incrementado
+inline void Recua(int &tentativas) {
+  tentativas++;
+  if (tentativas < 64) {
+    return;
+  }
+
+  if (tentativas < 256) {
+    std::this_thread::yield();
+    return;
+  }
+
+  timespec intervalo = {0, 50000};
+  nanosleep(&intervalo, nullptr);
+}
+
+/// @brief Fila limitada sem travas, com múltiplos produtores e múltiplos
+/// consumidores (algoritmo de Dmitry Vyukov). Cada posição guarda um número
+/// de sequência que indica se ela está livre para o próximo produtor ou
+/// ocupada para o próximo consumidor, de modo que produtores e consumidores
+/// só disputam os seus respectivos contadores.
+/// @tparam T O tipo dos elementos, que deve ser barato de copiar
+template <typename T>
+class FilaLimitada {
+ public:
+  /// @brief Constroi uma fila vazia.
+  /// @param capacidade A capacidade mínima da fila, arredondada para a próxima
+  /// potência de 2
+  explicit FilaLimitada(size_t capacidade) {
+    size_t tamanho = 2;
+    while (tamanho < capacidade) {
+      tamanho *= 2;
+    }
+
+    mascara_ = tamanho - 1;
+    celulas_.reset(new Celula[tamanho]);
+    for (size_t i = 0; i < tamanho; i++) {
+      celulas_[i].sequencia.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  FilaLimitada(const FilaLimitada &) = delete;
+  FilaLimitada &operator=(const FilaLimitada &) = delete;
+
+  /// @brief Tenta inserir um elemento no fim da fila.
+  /// @return `true` se o elemento foi inserido, `false` se a fila está cheia.
+  bool TentaInserir(const T &valor) {
+    size_t posicao = fim_.load(std::memory_order_relaxed);
+    while (true) {
+      Celula &celula = celulas_[posicao & mascara_];
+      size_t sequencia = celula.sequencia.load(std::memory_order_acquire);
+      intptr_t diferenca = (intptr_t)sequencia - (intptr_t)posicao;
+
+      if (diferenca == 0) {
+        // A posição está livre; tenta reservá-la
+        if (fim_.compare_exchange_weak(posicao, posicao + 1,
+                                       std::memory_order_relaxed)) {
+          celula.valor = valor;
+          celula.sequencia.store(posicao + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diferenca < 0) {
+        // A posição ainda não foi consumida: a fila está cheia
+        return false;
+      } else {
+        posicao = fim_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @brief Tenta remover um elemento do início da fila.
+  /// @param valor Recebe o elemento removido
+  /// @return `true` se um elemento foi removido, `false` se a fila está vazia.
+  bool TentaRemover(T &valor) {
+    size_t posicao = inicio_.load(std::memory_order_relaxed);
+    while (true) {
+      Celula &celula = celulas_[posicao & mascara_];
+      size_t sequencia = celula.sequencia.load(std::memory_order_acquire);
+      intptr_t diferenca = (intptr_t)sequencia - (intptr_t)(posicao + 1);
+
+      if (diferenca == 0) {
+        // A posição está ocupada; tenta reservá-la
+        if (inicio_.compare_exchange_weak(posicao, posicao + 1,
+                                          std::memory_order_relaxed)) {
+          valor = celula.valor;
+          celula.sequencia.store(posicao + mascara_ + 1,
+                                 std::memory_order_release);
+          return true;
+        }
+      } else if (diferenca < 0) {
+        // A posição ainda não foi produzida: a fila está vazia
+        return false;
+      } else {
+        posicao = inicio_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// @brief Insere um elemento, esperando enquanto a fila estiver cheia.
+  void Insere(const T &valor) {
+    int tentativas = 0;
+    while (!TentaInserir(valor)) {
+      Recua(tentativas);
+    }
+  }
+
+  /// @brief Remove um elemento, esperando enquanto a fila estiver vazia.
+  T Remove() {
+    T valor;
+    int tentativas = 0;
+    while (!TentaRemover(valor)) {
+      Recua(tentativas);
+    }
+    return valor;
+  }
+
+  /// @brief Retorna o número aproximado de elementos na fila, que pode estar
+  /// desatualizado enquanto houver inserções e remoções concorrentes.
+  size_t GetTamanhoAproximado() const {
+    size_t fim = fim_.load(std::memory_order_relaxed);
+    size_t inicio = inicio_.load(std::memory_order_relaxed);
+    return fim > inicio ? fim - inicio : 0;
+  }
+
+ private:
+  struct Celula {
+    std::atomic<size_t> sequencia;
+    T valor;
+  };
+
+  std::unique_ptr<Celula[]> celulas_;
+  size_t mascara_ = 0;
+
+  /// @brief Contadores de consumidores e produtores, em linhas de cache
+  /// separadas para que uns não invalidem o cache dos outros.
+  alignas(64) std::atomic<size_t> inicio_{0};
+  alignas(64) std::atomic<size_t> fim_{0};
+};
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef GERADOR_HPP
+#define GERADOR_HPP
+
+#include <cstdint>
+
+#include "caixa.hpp"
+#include "cifra.hpp"
+#include "escritor.hpp"
+
+/// @brief Famílias de caixas do gerador de instâncias, que imitam cargas de
+/// trabalho com estruturas diferentes.
+enum FamiliaGerador {
+  // Cristais e conexões independentes, com probabilidade `densidade`.
+  kFamiliaUniforme,
+
+  // Caixa cheia, com os cristais das casas pretas de um tabuleiro de xadrez
+  // mais brilhantes, e conexões com probabilidade `densidade`.
+  kFamiliaXadrez,
+
+  // Aglomerados circulares de cristais espalhados por uma caixa quase vazia.
+  kFamiliaAglomerados,
+
+  // Faixas de linhas iguais, de dois a quatro tipos que se alternam
+  // periodicamente ao longo da caixa.
+  kFamiliaFaixas,
+
+  // Caixa uniforme com muitas linhas e poucas colunas.
+  kFamiliaLonga,
+
+  // Caixa uniforme com poucas linhas e muitas colunas.
+  kFamiliaLarga,
+
+  // Linhas cheias e sem conexões horizontais, em que todas as 2**C
+  // configurações são válidas, ligadas por conexões verticais com
+  // probabilidade `densidade`.
+  kFamiliaAdversaria,
+
+  kNumFamilias,
+};
+
+/// @brief Parâmetros do gerador de instâncias.
+struct ParametrosGerador {
+  FamiliaGerador familia = kFamiliaUniforme;
+
+  // Dimensões da caixa. Um valor de 0 indica a dimensão padrão da família.
+  int L = 0, C = 0;
+
+  // Densidade da família, entre 0 e 1.
+  double densidade = 0.8;
+
+  // Semente do gerador pseudoaleatório.
+  uint64_t semente = 1;
+};
+
+/// @brief Retorna o nome de uma família, como aceito por `FamiliaPorNome`.
+const char *NomeFamilia(FamiliaGerador familia);
+
+/// @brief Procura uma família pelo nome.
+/// @param nome O nome da família
+/// @param familia Recebe a família
+/// @return Se a família existe
+bool FamiliaPorNome(const char *nome, FamiliaGerador &familia);
+
+/// @brief Gera uma caixa da família escolhida. A caixa depende apenas dos
+/// parâmetros: o gerador pseudoaleatório e os sorteios usam apenas aritmética
+/// inteira e de ponto flutuante exata, para que a mesma semente gere a mesma
+/// caixa em qualquer máquina e compilador.
+/// @param parametros Os parâmetros do gerador
+/// @param cifra Recebe a caixa gerada, com o número de cristais definido
+void GeraCaixa(const ParametrosGerador &parametros, Cifra &cifra);
+
+/// @brief Escreve uma caixa no formato texto da entrada, com os cristais em
+/// ordem de linha e coluna.
+/// @param escritor O escritor onde a caixa será escrita
+/// @param caixa A caixa
+/// @param n O número de cristais da caixa
+void EscreveCaixaTexto(Escritor &escritor, const Caixa &caixa, int n);
+
+#endif
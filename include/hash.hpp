@@ -0,0 +1,112 @@
+#ifndef HASH_HPP
+#define HASH_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/// @brief Identifica o conteúdo de uma caixa (ou parte dele) por um hash de
+/// 128 bits.
+struct ChaveCaixa {
+  uint64_t partes[2];
+
+  bool operator==(const ChaveCaixa &outra) const {
+    return partes[0] == outra.partes[0] && partes[1] == outra.partes[1];
+  }
+};
+
+/// @brief Função de hash de `ChaveCaixa` para os mapas da biblioteca padrão.
+struct HashChaveCaixa {
+  size_t operator()(const ChaveCaixa &chave) const { return chave.partes[0]; }
+};
+
+/// @brief Mistura os bits de um valor (finalizador fmix64 do MurmurHash3).
+static inline uint64_t Mistura(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdull;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ull;
+  k ^= k >> 33;
+  return k;
+}
+
+/// @brief Hash de 128 bits calculado de forma incremental, com as etapas de
+/// mistura do MurmurHash3 (x64, 128 bits).
+class Hash128 {
+ public:
+  /// @brief Acrescenta bytes ao conteúdo do hash.
+  void Acrescenta(const void *dados, size_t tamanho) {
+    const char *bytes = static_cast<const char *>(dados);
+    total_ += tamanho;
+
+    // Completa o bloco pendente
+    if (pendentes_ > 0) {
+      size_t copiados = std::min(tamanho, sizeof(bloco_) - pendentes_);
+      memcpy(bloco_ + pendentes_, bytes, copiados);
+      pendentes_ += copiados;
+      bytes += copiados;
+      tamanho -= copiados;
+      if (pendentes_ < sizeof(bloco_)) {
+        return;
+      }
+      ProcessaBloco(bloco_);
+      pendentes_ = 0;
+    }
+
+    for (; tamanho >= sizeof(bloco_); bytes += 16, tamanho -= 16) {
+      ProcessaBloco(bytes);
+    }
+
+    memcpy(bloco_, bytes, tamanho);
+    pendentes_ = tamanho;
+  }
+
+  /// @brief Termina o cálculo e retorna o hash.
+  ChaveCaixa Finaliza() {
+    if (pendentes_ > 0) {
+      uint64_t k1 = 0, k2 = 0;
+      memcpy(&k1, bloco_, std::min<size_t>(pendentes_, 8));
+      if (pendentes_ > 8) {
+        memcpy(&k2, bloco_ + 8, pendentes_ - 8);
+      }
+      h1_ ^= Rotaciona(k1 * kC1, 31) * kC2;
+      h2_ ^= Rotaciona(k2 * kC2, 33) * kC1;
+    }
+
+    h1_ ^= total_;
+    h2_ ^= total_;
+    h1_ += h2_;
+    h2_ += h1_;
+    h1_ = Mistura(h1_);
+    h2_ = Mistura(h2_);
+    h1_ += h2_;
+    h2_ += h1_;
+    return {{h1_, h2_}};
+  }
+
+ private:
+  static const uint64_t kC1 = 0x87c37b91114253d5ull;
+  static const uint64_t kC2 = 0x4cf5ad432745937full;
+
+  static uint64_t Rotaciona(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  void ProcessaBloco(const char *bloco) {
+    uint64_t k1, k2;
+    memcpy(&k1, bloco, 8);
+    memcpy(&k2, bloco + 8, 8);
+
+    h1_ ^= Rotaciona(k1 * kC1, 31) * kC2;
+    h1_ = (Rotaciona(h1_, 27) + h2_) * 5 + 0x52dce729;
+    h2_ ^= Rotaciona(k2 * kC2, 33) * kC1;
+    h2_ = (Rotaciona(h2_, 31) + h1_) * 5 + 0x38495ab5;
+  }
+
+  uint64_t h1_ = 0, h2_ = 0, total_ = 0;
+  char bloco_[16];
+  size_t pendentes_ = 0;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#ifndef LEITOR_HPP
+#define LEITOR_HPP
+
+#include <cstddef>
+#include <vector>
+
+using std::vector;
+
+/// @brief Leitor de inteiros em texto sobre um buffer contíguo com a entrada
+/// inteira. Arquivos regulares são mapeados em memória com `mmap`, sem cópias;
+/// outras entradas (como pipes) são lidas de uma vez para um buffer próprio.
+class Leitor {
+ public:
+  Leitor() = default;
+  ~Leitor();
+
+  Leitor(const Leitor &) = delete;
+  Leitor &operator=(const Leitor &) = delete;
+
+  /// @brief Abre a entrada a ser lida.
+  /// @param caminho O caminho do arquivo de entrada. Um valor de `nullptr`
+  /// indica a entrada padrão.
+  /// @return `true` se a entrada foi aberta, `false` caso contrário (a
+  /// mensagem de erro fica disponível em `GetErro`).
+  bool Abre(const char *caminho);
+
+  /// @brief Faz o leitor percorrer um trecho de um buffer externo, sem
+  /// copiá-lo. Usado para dividir uma entrada entre várias threads.
+  /// @param inicio O início do trecho
+  /// @param fim O fim (exclusivo) do trecho
+  void AbreTrecho(const char *inicio, const char *fim) {
+    inicio_ = pos_ = inicio;
+    fim_ = fim;
+    linha_ = 1;
+  }
+
+  /// @brief Lê o próximo inteiro da entrada, ignorando espaços em branco. São
+  /// aceitos sinais de `+` e `-` antes dos dígitos.
+  /// @param valor Recebe o inteiro lido
+  /// @return `true` se um inteiro foi lido, `false` se a entrada acabou ou está
+  /// mal formada (a mensagem de erro fica disponível em `GetErro`).
+  inline bool LeInteiro(int &valor) {
+    PulaEspacos();
+
+    if (pos_ == fim_) {
+      return Falha("fim inesperado da entrada");
+    }
+
+    bool negativo = false;
+    if (*pos_ == '-' || *pos_ == '+') {
+      negativo = *pos_ == '-';
+      pos_++;
+    }
+
+    // O acumulador é sem sinal para que números longos demais apenas deem a
+    // volta, sendo rejeitados depois pela contagem de dígitos
+    const char *inicio_digitos = pos_;
+    unsigned long long numero = 0;
+    while (pos_ != fim_ && (unsigned)(*pos_ - '0') < 10) {
+      numero = numero * 10 + (*pos_ - '0');
+      pos_++;
+    }
+
+    // O número precisa ter ao menos um dígito e terminar em um espaço em branco
+    // ou no fim da entrada
+    if (pos_ == inicio_digitos || (pos_ != fim_ && !EhEspaco(*pos_))) {
+      return Falha("era esperado um número inteiro");
+    }
+
+    if (pos_ - inicio_digitos > kMaxDigitos || numero > kMaxAbsoluto) {
+      return Falha("inteiro fora do intervalo suportado");
+    }
+
+    valor = negativo ? -static_cast<int>(numero) : static_cast<int>(numero);
+    return true;
+  }
+
+  /// @brief Lê o próximo dígito da entrada, ignorando espaços em branco. Ao
+  /// contrário de `LeInteiro`, não exige separação entre dígitos seguidos.
+  /// @param valor Recebe o valor do dígito lido
+  /// @return `true` se um dígito foi lido, `false` caso contrário (a mensagem
+  /// de erro fica disponível em `GetErro`).
+  inline bool LeDigito(int &valor) {
+    PulaEspacos();
+
+    if (pos_ == fim_ || (unsigned)(*pos_ - '0') >= 10) {
+      return Falha("era esperado um dígito");
+    }
+
+    valor = *pos_ - '0';
+    pos_++;
+    return true;
+  }
+
+  /// @brief Consome `palavra` caso ela seja a próxima palavra da entrada.
+  /// @param palavra A palavra esperada
+  /// @return `true` se a palavra foi encontrada e consumida, `false` caso
+  /// contrário (nesse caso, nada é consumido).
+  bool ConsomePalavra(const char *palavra);
+
+  /// @brief Avança a leitura até o fim da entrada, para leitores que a
+  /// consomem sem passar pelo `Leitor`.
+  void PulaParaFim() { pos_ = fim_; }
+
+  /// @brief Verifica se resta apenas espaço em branco na entrada.
+  bool Terminou() {
+    PulaEspacos();
+    return pos_ == fim_;
+  }
+
+  /// @brief Registra um erro na linha atual da entrada.
+  /// @param mensagem A descrição do erro
+  /// @return Sempre `false`, para ser usado diretamente em retornos.
+  bool Falha(const char *mensagem);
+
+  /// @brief Registra um erro em uma linha específica da entrada.
+  /// @param linha A linha (1-based) do erro
+  /// @param mensagem A descrição do erro
+  /// @return Sempre `false`, para ser usado diretamente em retornos.
+  bool FalhaNaLinha(int linha, const char *mensagem);
+
+  /// @brief Registra um erro que não se refere a uma linha da entrada, como
+  /// em entradas binárias.
+  /// @param mensagem A descrição do erro
+  /// @return Sempre `false`, para ser usado diretamente em retornos.
+  bool FalhaGeral(const char *mensagem);
+
+  /// @brief Registra um erro em um cristal de uma entrada sem linhas, como
+  /// as binárias.
+  /// @param x A linha (1-based) do cristal na caixa
+  /// @param y A coluna (1-based) do cristal na caixa
+  /// @param mensagem A descrição do erro
+  /// @return Sempre `false`, para ser usado diretamente em retornos.
+  bool FalhaNoCristal(int x, int y, const char *mensagem);
+
+  /// @brief Retorna a linha (1-based) onde a leitura está.
+  int GetLinha() { return linha_; }
+
+  /// @brief Retorna a mensagem do último erro, já com o número da linha.
+  const char *GetErro() { return erro_; }
+
+  /// @brief Retorna a descrição do último erro, sem o número da linha.
+  const char *GetMensagem() { return mensagem_; }
+
+  /// @brief Retorna a posição atual da leitura no buffer.
+  const char *GetPosicao() { return pos_; }
+
+  /// @brief Retorna o início do buffer com a entrada inteira.
+  const char *GetDados() { return inicio_; }
+
+  /// @brief Retorna o tamanho da entrada, em bytes.
+  size_t GetTamanho() { return fim_ - inicio_; }
+
+ private:
+  /// @brief Maior valor absoluto aceito para um inteiro lido.
+  static const unsigned long long kMaxAbsoluto = 2147483647ULL;
+
+  /// @brief Maior número de dígitos de um inteiro aceito.
+  static const int kMaxDigitos = 10;
+
+  /// @brief Início, posição atual e fim do buffer com a entrada.
+  const char *inicio_ = nullptr, *pos_ = nullptr, *fim_ = nullptr;
+
+  /// @brief Linha (1-based) correspondente a `pos_`.
+  int linha_ = 1;
+
+  /// @brief Região mapeada com `mmap`, ou `nullptr` caso a entrada esteja em
+  /// `buffer_`.
+  void *mapeamento_ = nullptr;
+
+  /// @brief Buffer da entrada, usado quando ela não pode ser mapeada.
+  vector<char> buffer_;
+
+  /// @brief Mensagem do último erro, e a sua descrição sem o número da linha.
+  char erro_[256] = "";
+  const char *mensagem_ = "";
+
+  /// @brief Verifica se o caractere é um espaço em branco.
+  static inline bool EhEspaco(char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' ||
+           c == '\f';
+  }
+
+  /// @brief Avança `pos_` até o próximo caractere que não é espaço em branco,
+  /// contando as linhas.
+  inline void PulaEspacos() {
+    while (pos_ != fim_ && EhEspaco(*pos_)) {
+      if (*pos_ == '\n') {
+        linha_++;
+      }
+      pos_++;
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef LOTE_HPP
+#define LOTE_HPP
+
+#include <cstdio>
+#include <vector>
+
+#include "cache.hpp"
+#include "cifra.hpp"
+#include "escritor.hpp"
+#include "leitor.hpp"
+
+using std::vector;
+
+/// @brief Resolve, em ordem, todas as instâncias de uma entrada com várias
+/// caixas seguidas, cada uma com o seu próprio cabeçalho (no formato texto ou
+/// denso). Um único `Cifra` é reaproveitado entre as instâncias, evitando
+/// novas alocações da caixa e da memoização.
+/// @param leitor O leitor com a entrada já aberta
+/// @param parametros Os parâmetros de resolução
+/// @param cache O cache de soluções, ou `nullptr`
+/// @param escritor O escritor onde as soluções são escritas, na ordem da
+/// entrada
+/// @param latencias Recebe o tempo, em segundos, gasto com cada instância
+/// (leitura, resolução e escrita)
+/// @return `true` se todas as instâncias foram resolvidas e as soluções
+/// escritas, `false` caso contrário (o erro é impresso na saída de erro).
+bool ResolveLote(Leitor &leitor, const ParametrosResolucao &parametros,
+                 CacheResultados *cache, Escritor &escritor,
+                 vector<double> &latencias);
+
+/// @brief Versão de `ResolveLote` organizada como uma esteira de três
+/// estágios: a thread que chama a função lê as instâncias, um conjunto de
+/// `num_trabalhadores` threads as resolve, e uma thread escritora imprime as
+/// soluções na ordem da entrada. Os estágios são ligados por filas limitadas
+/// sem travas, e as instâncias circulam em um número fixo de tarefas
+/// reaproveitadas; quando todas estão em uso, a leitura espera.
+/// @param leitor O leitor com a entrada já aberta
+/// @param parametros Os parâmetros de resolução
+/// @param cache O cache de soluções, compartilhado pelos trabalhadores, ou
+/// `nullptr`
+/// @param num_trabalhadores O número de threads que resolvem as instâncias
+/// @param escritor O escritor onde as soluções são escritas, na ordem da
+/// entrada
+/// @param latencias Recebe o tempo, em segundos, entre o início da leitura e
+/// o fim da escrita de cada instância
+/// @return `true` se todas as instâncias foram resolvidas e as soluções
+/// escritas, `false` caso contrário (o erro é impresso na saída de erro).
+bool ResolveLoteParalelo(Leitor &leitor, const ParametrosResolucao &parametros,
+                         CacheResultados *cache, int num_trabalhadores,
+                         Escritor &escritor, vector<double> &latencias);
+
+/// @brief Imprime o número de instâncias e os percentis das latências.
+/// @param arquivo O arquivo onde o relatório é impresso
+/// @param latencias As latências, em segundos. O vetor é ordenado.
+void ImprimeLatencias(FILE *arquivo, vector<double> &latencias);
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef METRICAS_HPP
+#define METRICAS_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "cifra.hpp"
+
+/// @brief Faixas do histograma de latências, no estilo do HdrHistogram: cada
+/// intervalo [2^k, 2^(k+1)) de nanossegundos, de k = 10 a k = 36, é dividido
+/// em 4 faixas lineares, com erro relativo de no máximo 25%. A escala vai de
+/// 2^10 ns (~1 us) a 2^37 ns (~137 s). A primeira faixa guarda as latências
+/// menores que 2^10 ns e a última, as maiores que o fim da escala.
+const int kExpoenteMinimoLatencia = 10;
+const int kExpoenteMaximoLatencia = 36;
+const int kSubfaixasLatencia = 4;
+const int kNumFaixasLatencia =
+    (kExpoenteMaximoLatencia - kExpoenteMinimoLatencia + 1) *
+        kSubfaixasLatencia +
+    2;
+
+/// @brief Faixas dos histogramas de tamanho das caixas: uma por potência de 2,
+/// de 1 a 2^30, e a última para os valores maiores.
+const int kNumFaixasTamanho = 32;
+
+/// @brief Número de fatias dos contadores. As threads são distribuídas entre
+/// as fatias, cada uma na sua linha de cache, para que os incrementos não
+/// disputem as mesmas linhas.
+const int kNumFatiasMetricas = 16;
+
+/// @brief Histograma de um tamanho das caixas, em uma fatia.
+struct HistogramaTamanho {
+  std::atomic<uint64_t> faixas[kNumFaixasTamanho] = {};
+  std::atomic<uint64_t> soma{0};
+};
+
+/// @brief Contadores de uma fatia.
+struct alignas(64) FatiaMetricas {
+  // Resoluções por método. As soluções vindas do cache não passam por nenhum
+  // método, e ficam em `kMetodoNenhum`.
+  std::atomic<uint64_t> resolucoes[kNumMetodos] = {};
+
+  std::atomic<uint64_t> erros{0}, acertos_cache{0}, faltas_cache{0};
+
+  std::atomic<uint64_t> latencias[kNumFaixasLatencia] = {};
+  std::atomic<uint64_t> soma_latencias_ns{0};
+
+  HistogramaTamanho linhas, colunas, cristais;
+};
+
+/// @brief Métricas dos modos servidor e lote, exportadas no formato texto do
+/// Prometheus. Os registros apenas incrementam, sem travas, os contadores da
+/// fatia da thread atual; a exportação soma as fatias.
+class Metricas {
+ public:
+  Metricas() = default;
+  ~Metricas() { EncerraExportacao(); }
+
+  Metricas(const Metricas &) = delete;
+  Metricas &operator=(const Metricas &) = delete;
+
+  /// @brief Registra uma caixa resolvida.
+  /// @param cifra O problema resolvido
+  /// @param com_cache Indica que o cache foi consultado. Sem cache, a
+  /// resolução não conta como acerto nem como falta
+  /// @param em_cache Indica que a solução veio do cache
+  void RegistraResolucao(Cifra &cifra, bool com_cache, bool em_cache);
+
+  /// @brief Registra uma instância ou requisição que não pôde ser resolvida.
+  void RegistraErro();
+
+  /// @brief Registra a latência de uma instância ou requisição.
+  void RegistraLatencia(double segundos);
+
+  /// @brief Define a função que retorna a profundidade atual da fila de
+  /// trabalho, consultada apenas na exportação, ou nullptr se não há fila.
+  void DefineFonteFila(std::function<long long()> fonte);
+
+  /// @brief Escreve as métricas no formato texto do Prometheus.
+  void Imprime(FILE *arquivo);
+
+  /// @brief Escreve as métricas em um arquivo temporário e o renomeia para o
+  /// caminho, para que leitores (como o coletor de arquivos texto do
+  /// node_exporter) nunca vejam um arquivo pela metade.
+  /// @return Se o arquivo pôde ser escrito
+  bool Escreve(const char *caminho);
+
+  /// @brief Inicia uma thread que escreve as métricas periodicamente.
+  /// @param caminho O caminho do arquivo
+  /// @param intervalo O intervalo entre as escritas, em segundos
+  void IniciaExportacao(const char *caminho, double intervalo);
+
+  /// @brief Encerra a thread de exportação, se houver, escrevendo as métricas
+  /// uma última vez.
+  /// @return Se a última escrita foi bem-sucedida
+  bool EncerraExportacao();
+
+ private:
+  FatiaMetricas &Fatia();
+
+  FatiaMetricas fatias_[kNumFatiasMetricas];
+
+  std::mutex trava_fonte_;
+  std::function<long long()> fonte_fila_;
+
+  // Exportação periódica.
+  const char *caminho_ = nullptr;
+  std::thread exportadora_;
+  std::mutex trava_exportacao_;
+  std::condition_variable encerramento_;
+  bool encerrando_ = false;
+};
+
+/// @brief Define as métricas atualizadas pelos modos servidor e lote, ou
+/// nullptr para não registrar métricas. Deve ser chamada antes de iniciar o
+/// modo.
+void AtivaMetricas(Metricas *metricas);
+
+/// @brief Retorna as métricas ativas, ou nullptr.
+Metricas *GetMetricas();
+
+#endif
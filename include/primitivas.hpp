@@ -0,0 +1,70 @@
+#ifndef PRIMITIVAS_HPP
+#define PRIMITIVAS_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "topologia.hpp"
+
+// Operações elementares da programação dinâmica exata, chamadas uma vez por
+// estado ou por transição. Ficam fora de `Cifra` para que os microbenchmarks
+// (ferramentas/primitivas.cpp) meçam exatamente o código usado na resolução.
+
+/// @brief Verifica se a configuração `conf` usa apenas posições com cristais
+/// e não ativa dois cristais vizinhos conectados da mesma linha.
+/// @param linha As estruturas da linha
+/// @param conf A configuração da linha
+/// @param C O número de colunas da caixa
+/// @return `true` se a configuração é válida, `false` caso contrário.
+inline bool ConfiguracaoConsistente(const LinhaPlano &linha, int conf, int C) {
+  // Alguma posição ativada não possui um cristal
+  if ((conf & ~linha.presenca) != 0) {
+    return false;
+  }
+
+  // Alguma posição ativada está conectada com a posição à sua direita, que
+  // também está ativada
+  int direita = (conf >> 1) | ((conf & 1) << (C - 1));
+  return (conf & direita & linha.horizontal) == 0;
+}
+
+/// @brief Verifica se a configuração `conf_i` de uma linha pode ser usada com
+/// a configuração `conf_s` da linha acima.
+/// @param linha As estruturas da linha superior do par
+/// @param conf_i A configuração da linha inferior do par
+/// @param conf_s A configuração da linha superior do par
+/// @return `true` se as configurações são compatíveis, `false` caso
+/// contrário.
+inline bool ConfiguracoesCompativeis(const LinhaPlano &linha, int conf_i,
+                                     int conf_s) {
+  // Algum cristal ativado nas duas linhas está conectado com o de cima
+  return (conf_i & conf_s & linha.vertical) == 0;
+}
+
+/// @brief Soma os brilhos dos cristais ativados em uma configuração.
+/// @param brilhos Os brilhos da linha, um por coluna
+/// @param conf A configuração da linha, que só ativa posições com cristais
+/// @param C O número de colunas da caixa
+inline int SomaBrilhosLinha(const int32_t *brilhos, int conf, int C) {
+  int valor = 0;
+  for (int j = 0; j < C; j++) {
+    if (((conf >> j) & 1) == 1) {
+      valor += brilhos[j];
+    }
+  }
+  return valor;
+}
+
+/// @brief Retorna a posição do estado (`linha`, `conf`, `conf_relativa`) na
+/// matriz contígua de memoização, de dimensões `linha`x`num_possibilidades`x
+/// `num_confs_iniciais`.
+/// @param conf_relativa A configuração da última linha, relativa ao início da
+/// faixa de configurações iniciais
+inline size_t IndiceMemo(int linha, int conf, int conf_relativa,
+                         int num_possibilidades, int num_confs_iniciais) {
+  return (static_cast<size_t>(linha) * num_possibilidades + conf) *
+             num_confs_iniciais +
+         conf_relativa;
+}
+
+#endif
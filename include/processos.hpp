@@ -0,0 +1,19 @@
+#ifndef PROCESSOS_HPP
+#define PROCESSOS_HPP
+
+#include "cifra.hpp"
+
+/// @brief Resolve uma caixa de forma exata dividindo o laço da costura vertical
+/// entre processos. O coordenador cria `num_processos` processos filhos com
+/// `fork`, cada um responsável por uma faixa disjunta de configurações da
+/// última linha (`Cifra::ResolveFaixa`), que escrevem o seu melhor valor e a
+/// configuração de cada linha em um arquivo mapeado em memória compartilhada.
+/// O coordenador então combina os resultados e define a solução da caixa,
+/// que é a mesma de `Cifra::Resolve`. Cada processo aloca apenas a parte da
+/// memoização da sua faixa.
+/// @param cifra O problema, com a caixa já preenchida
+/// @param num_processos O número de processos filhos
+/// @return `nullptr` se a caixa foi resolvida, ou uma mensagem de erro.
+const char *ResolveEmProcessos(Cifra &cifra, int num_processos);
+
+#endif
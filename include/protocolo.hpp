@@ -0,0 +1,53 @@
+#ifndef PROTOCOLO_HPP
+#define PROTOCOLO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+using std::vector;
+
+/// @brief Cabeçalho dos quadros trocados com o servidor (`servidor.hpp`).
+/// Cada requisição é um quadro cujo conteúdo é uma caixa em qualquer formato
+/// de entrada aceito; cada resposta é um quadro com a solução no formato
+/// texto ou, em caso de erro, com a mensagem de erro. As respostas de uma
+/// conexão chegam na ordem das requisições. Os campos são little-endian.
+struct CabecalhoQuadro {
+  // Um valor de `StatusQuadro`. Nas requisições, deve ser `kQuadroOk`.
+  uint32_t status;
+
+  // Tamanho do conteúdo que segue o cabeçalho, em bytes.
+  uint32_t tamanho;
+};
+
+/// @brief Situação de um quadro de resposta.
+enum StatusQuadro : uint32_t {
+  kQuadroOk = 0,
+  kQuadroErro = 1,
+};
+
+/// @brief Maior conteúdo aceito em um quadro, em bytes.
+const uint32_t kTamanhoMaximoQuadro = 1u << 30;
+
+/// @brief Envia um quadro por um socket.
+/// @param fd O socket
+/// @param status A situação do quadro
+/// @param dados O conteúdo do quadro
+/// @param tamanho O tamanho do conteúdo, em bytes
+/// @return `true` se o quadro foi enviado, `false` caso contrário.
+bool EnviaQuadro(int fd, uint32_t status, const char *dados, size_t tamanho);
+
+/// @brief Recebe um quadro de um socket.
+/// @param fd O socket
+/// @param status Recebe a situação do quadro
+/// @param dados Recebe o conteúdo do quadro, reaproveitando a sua memória
+/// @return `true` se um quadro foi recebido, `false` se a conexão foi
+/// encerrada ou o quadro é inválido.
+bool RecebeQuadro(int fd, uint32_t &status, vector<char> &dados);
+
+/// @brief Conecta-se ao servidor.
+/// @param caminho O caminho do socket Unix do servidor
+/// @return O socket conectado, ou -1 em caso de erro (com `errno` definido).
+int ConectaServidor(const char *caminho);
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef RASTREIO_HPP
+#define RASTREIO_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// @brief Indica se o rastreio está ativo. Com o rastreio desativado, cada
+/// trecho instrumentado custa apenas esta leitura.
+extern std::atomic<bool> rastreio_ativo;
+
+inline bool RastreioAtivo() {
+  return rastreio_ativo.load(std::memory_order_relaxed);
+}
+
+/// @brief Converte um instante do relógio monotônico em nanossegundos.
+inline uint64_t InstanteRastreio(std::chrono::steady_clock::time_point t) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             t.time_since_epoch())
+      .count();
+}
+
+inline uint64_t InstanteRastreio() {
+  return InstanteRastreio(std::chrono::steady_clock::now());
+}
+
+/// @brief Ativa o rastreio, descartando os eventos registrados antes.
+void IniciaRastreio();
+
+/// @brief Registra um trecho concluído no buffer da thread atual. O buffer
+/// só é escrito pela sua thread, sem travas; apenas o primeiro evento de cada
+/// thread a registra, com uma trava. Eventos além da capacidade do buffer
+/// são descartados e contados.
+/// @param nome O nome do trecho, que deve ser uma string estática
+/// @param categoria A categoria do trecho, também estática
+/// @param inicio O instante do início, de `InstanteRastreio`
+/// @param fim O instante do fim
+/// @param argumento Um valor associado ao trecho (por exemplo, a
+/// configuração de uma costura), ou -1 para nenhum
+void RegistraTrecho(const char *nome, const char *categoria, uint64_t inicio,
+                    uint64_t fim, long long argumento);
+
+/// @brief Dá nome à thread atual na linha do tempo.
+/// @param nome O nome, que deve ser uma string estática
+/// @param indice Um número que distingue threads de mesmo nome, ou -1
+void NomeiaThreadRastreio(const char *nome, int indice);
+
+/// @brief Desativa o rastreio e escreve os eventos de todas as threads no
+/// formato JSON de trace do Chrome, aberto pelo chrome://tracing e pelo
+/// Perfetto. Deve ser chamada depois que as threads rastreadas terminaram.
+/// @return Se o arquivo pôde ser escrito
+bool EscreveRastreio(const char *caminho);
+
+/// @brief Registra o trecho do construtor ao destrutor, se o rastreio estiver
+/// ativo na construção.
+class TrechoRastreio {
+ public:
+  explicit TrechoRastreio(const char *nome, const char *categoria,
+                          long long argumento = -1)
+      : nome_(nome), categoria_(categoria), argumento_(argumento),
+        inicio_(RastreioAtivo() ? InstanteRastreio() : 0) {}
+
+  ~TrechoRastreio() {
+    if (inicio_ != 0) {
+      RegistraTrecho(nome_, categoria_, inicio_, InstanteRastreio(),
+                     argumento_);
+    }
+  }
+
+  TrechoRastreio(const TrechoRastreio &) = delete;
+  TrechoRastreio &operator=(const TrechoRastreio &) = delete;
+
+ private:
+  const char *nome_, *categoria_;
+  long long argumento_;
+  uint64_t inicio_;
+};
+
+#endif
@@ -0,0 +1,75 @@
+#ifndef SAIDA_HPP
+#define SAIDA_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#include "cifra.hpp"
+#include "escritor.hpp"
+
+/// @brief Cabeçalho do formato binário de soluções. O arquivo é composto por
+/// este cabeçalho, seguido de `L` máscaras de linha, cada uma com
+/// `PalavrasPorLinha(C)` palavras de 64 bits, onde o bit j da linha i indica
+/// se o cristal da posição (i + 1, j + 1) faz parte da solução. Todos os
+/// campos são little-endian, e as máscaras ficam alinhadas a 8 bytes para
+/// que o arquivo possa ser mapeado com `mmap`.
+struct CabecalhoSolucao {
+  // Identifica o formato. Deve conter `kMagicaSolucao`.
+  char magica[8];
+
+  // Versão do formato. Deve ser `kVersaoSolucao`.
+  uint32_t versao;
+
+  // Dimensões da caixa.
+  int32_t L, C;
+
+  // Número de cristais usados na solução.
+  int32_t num_cristais;
+
+  // Soma dos brilhos dos cristais usados na solução.
+  int64_t soma;
+};
+
+static_assert(sizeof(CabecalhoSolucao) == 32,
+              "O cabeçalho de soluções deve ter 32 bytes");
+
+/// @brief Sequência que identifica o formato binário de soluções.
+const char kMagicaSolucao[8] = {'C', 'I', 'F', 'R', 'A', 'S', 'O', 'L'};
+
+/// @brief Versão atual do formato binário de soluções.
+const uint32_t kVersaoSolucao = 1;
+
+/// @brief Retorna o número de palavras de 64 bits da máscara de uma linha com
+/// `c` colunas.
+inline size_t PalavrasPorLinha(int c) {
+  return (static_cast<size_t>(c) + 63) / 64;
+}
+
+/// @brief Escreve a solução de uma caixa já resolvida no formato texto: o
+/// número de cristais e a soma dos brilhos, seguidos da posição de cada
+/// cristal, um por linha.
+/// @param escritor O escritor onde a solução será escrita
+/// @param cifra O problema já resolvido
+void EscreveSolucaoTexto(Escritor &escritor, Cifra &cifra);
+
+/// @brief Retorna o tamanho, em bytes, de uma solução no formato binário para
+/// uma caixa com `l` linhas e `c` colunas.
+inline size_t TamanhoSolucaoBinaria(int l, int c) {
+  return sizeof(CabecalhoSolucao) +
+         static_cast<size_t>(l) * PalavrasPorLinha(c) * sizeof(uint64_t);
+}
+
+/// @brief Monta a solução de uma caixa já resolvida no formato binário em um
+/// buffer, que deve ter `TamanhoSolucaoBinaria(L, C)` bytes e estar alinhado
+/// a 8 bytes.
+/// @param destino O buffer onde a solução será montada
+/// @param cifra O problema já resolvido
+void MontaSolucaoBinaria(char *destino, Cifra &cifra);
+
+/// @brief Escreve a solução de uma caixa já resolvida no formato binário.
+/// @param caminho O caminho do arquivo a ser escrito
+/// @param cifra O problema já resolvido
+/// @return `true` se o arquivo foi escrito, `false` caso contrário.
+bool EscreveSolucaoBinaria(const char *caminho, Cifra &cifra);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef SERVIDOR_HPP
+#define SERVIDOR_HPP
+
+#include "cache.hpp"
+#include "cifra.hpp"
+
+/// @brief Executa o solucionador como um serviço persistente, que atende
+/// requisições por um socket Unix usando o protocolo de `protocolo.hpp`. Cada
+/// um dos `num_trabalhadores` trabalhadores aceita conexões diretamente do
+/// socket e mantém a sua própria `Cifra` e os seus buffers, reaproveitados
+/// entre requisições. O serviço termina ao receber SIGINT ou SIGTERM.
+/// @param caminho O caminho do socket Unix a ser criado. Um socket abandonado
+/// por um servidor que não terminou normalmente é substituído; qualquer outro
+/// arquivo no caminho faz o servidor falhar
+/// @param parametros Os parâmetros de resolução das caixas
+/// @param cache O cache de soluções, compartilhado pelos trabalhadores, ou
+/// `nullptr`
+/// @param num_trabalhadores O número de threads que atendem conexões
+/// @return O código de saída do programa
+int ExecutaServidor(const char *caminho, const ParametrosResolucao &parametros,
+                    CacheResultados *cache, int num_trabalhadores);
+
+/// @brief Executa o solucionador como um serviço persistente para clientes na
+/// mesma máquina, que submetem caixas pela fila em memória compartilhada de
+/// `compartilhada.hpp` e recebem as soluções no formato binário. O serviço
+/// termina ao receber SIGINT ou SIGTERM, removendo o segmento.
+/// @param nome O nome do segmento de memória compartilhada a ser criado
+/// @param parametros Os parâmetros de resolução das caixas
+/// @param cache O cache de soluções, compartilhado pelos trabalhadores, ou
+/// `nullptr`
+/// @param num_trabalhadores O número de threads que resolvem as caixas
+/// @param num_vagas O número de vagas da fila
+/// @param tamanho_vaga O tamanho de cada vaga, em bytes
+/// @param substitui Remove antes um segmento de mesmo nome que tenha ficado
+/// para trás
+/// @return O código de saída do programa
+int ExecutaServidorCompartilhado(const char *nome,
+                                 const ParametrosResolucao &parametros,
+                                 CacheResultados *cache, int num_trabalhadores,
+                                 int num_vagas, size_t tamanho_vaga,
+                                 bool substitui);
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef SIMETRIA_HPP
+#define SIMETRIA_HPP
+
+#include "caixa.hpp"
+
+/// @brief Uma simetria do toro: rotação das linhas e das colunas, seguida ou
+/// não de uma reflexão em cada dimensão. A posição (i', j') da caixa
+/// transformada corresponde à posição (`LinhaOriginal(i')`,
+/// `ColunaOriginal(j')`) da caixa original. Como o toro não tem origem nem
+/// orientação privilegiadas, caixas relacionadas por uma simetria têm o mesmo
+/// ótimo, e as soluções de uma são levadas às da outra pela transformação.
+struct TransformacaoToroidal {
+  int L = 0, C = 0;
+
+  // Linha e coluna originais da posição (0, 0) da caixa transformada.
+  int deslocamento_linhas = 0, deslocamento_colunas = 0;
+
+  // Indicam se as linhas (ou colunas) são percorridas em ordem inversa.
+  bool reflete_linhas = false, reflete_colunas = false;
+
+  int LinhaOriginal(int i) const {
+    return Modulo(reflete_linhas ? deslocamento_linhas - i
+                                 : deslocamento_linhas + i,
+                  L);
+  }
+
+  int ColunaOriginal(int j) const {
+    return Modulo(reflete_colunas ? deslocamento_colunas - j
+                                  : deslocamento_colunas + j,
+                  C);
+  }
+
+  /// @brief Inversa de `LinhaOriginal`.
+  int LinhaTransformada(int i) const {
+    return Modulo(reflete_linhas ? deslocamento_linhas - i
+                                 : i - deslocamento_linhas,
+                  L);
+  }
+
+  /// @brief Inversa de `ColunaOriginal`.
+  int ColunaTransformada(int j) const {
+    return Modulo(reflete_colunas ? deslocamento_colunas - j
+                                  : j - deslocamento_colunas,
+                  C);
+  }
+
+  static int Modulo(int x, int m) { return ((x % m) + m) % m; }
+};
+
+/// @brief Escolhe a forma canônica de uma caixa entre as suas rotações e
+/// reflexões. Cada dimensão é tratada como uma sequência circular e resolvida
+/// com o algoritmo da menor rotação (dois ponteiros, tempo linear): as colunas
+/// pela sua assinatura, que não depende da ordem das linhas, e em seguida as
+/// linhas pelo seu conteúdo na ordem de colunas escolhida. Quando várias
+/// orientações das colunas empatam (colunas periódicas ou simétricas), vence a
+/// que leva à menor sequência de linhas. Caixas que diferem apenas por uma
+/// simetria recebem a mesma forma canônica, exceto em colisões entre
+/// assinaturas de colunas diferentes, que apenas deixam de coincidir.
+/// @param caixa A caixa
+/// @return A transformação que leva a caixa à sua forma canônica
+TransformacaoToroidal CalculaFormaCanonica(const Caixa &caixa);
+
+/// @brief Aplica uma transformação a uma caixa, remapeando as conexões para
+/// que continuem ligando os mesmos pares de cristais.
+/// @param origem A caixa original
+/// @param transformacao A transformação
+/// @param destino Recebe a caixa transformada, como uma caixa própria
+void AplicaTransformacao(const Caixa &origem,
+                         const TransformacaoToroidal &transformacao,
+                         Caixa &destino);
+
+#endif
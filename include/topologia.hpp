@@ -0,0 +1,205 @@
+#ifndef TOPOLOGIA_HPP
+#define TOPOLOGIA_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "caixa.hpp"
+#include "hash.hpp"
+
+using std::vector;
+
+/// @brief Estruturas de uma linha da caixa usadas pela resolução exata. Os
+/// bits de cada máscara correspondem às colunas.
+struct LinhaPlano {
+  // Posições que têm um cristal.
+  int32_t presenca;
+
+  // Posições conectadas com a posição à sua direita.
+  int32_t horizontal;
+
+  // Posições conectadas com a posição acima (na linha anterior).
+  int32_t vertical;
+
+  // Posição da primeira configuração válida da linha no arranjo de
+  // configurações válidas, e o número de configurações válidas.
+  uint32_t inicio_validas, num_validas;
+
+  uint32_t reservado;
+};
+
+/// @brief Plano de topologia de uma caixa: as estruturas por linha da
+/// resolução exata que dependem apenas da presença dos cristais e das suas
+/// conexões, e não dos brilhos. São as máscaras de presença e de conflitos de
+/// cada linha e a lista, em ordem crescente, das configurações de cada linha
+/// que não usam posições vazias nem cristais vizinhos conectados. Caixas com a
+/// mesma topologia compartilham o mesmo plano, e linhas iguais de uma caixa
+/// compartilham a mesma lista de configurações válidas.
+///
+/// Como a caixa, os arranjos do plano podem pertencer a ele ou apontar para
+/// memória externa (um arquivo de plano mapeado com `mmap`).
+class PlanoTopologia {
+ public:
+  /// @brief Número máximo de colunas de um plano, cujas configurações são
+  /// guardadas em um `int32_t` (o mesmo limite da resolução exata).
+  static const int kMaxColunas = 30;
+
+  /// @brief Calcula as máscaras de cada linha da caixa, sem as configurações
+  /// válidas. As máscaras bastam para calcular a chave da topologia.
+  /// @param caixa A caixa, com no máximo `kMaxColunas` colunas
+  void CalculaMascaras(const Caixa &caixa);
+
+  /// @brief Enumera as configurações válidas de cada linha, a partir das
+  /// máscaras já calculadas com `CalculaMascaras`.
+  void CalculaValidas();
+
+  /// @brief Faz o plano apontar para o conteúdo de um arquivo de plano, sem
+  /// copiá-lo. O arquivo é verificado por inteiro: as máscaras devem
+  /// reproduzir a chave, e as configurações de cada linha devem ser
+  /// exatamente as válidas, em ordem crescente. A verificação é linear no
+  /// tamanho do arquivo, sem enumerar as configurações.
+  /// @param dados O conteúdo do arquivo
+  /// @param tamanho O tamanho do arquivo, em bytes
+  /// @param chave A chave esperada para o plano
+  /// @return Se o arquivo é um plano válido com a chave esperada
+  bool Associa(const char *dados, size_t tamanho, const ChaveCaixa &chave);
+
+  /// @brief Escreve o plano em um arquivo, no formato lido por `Associa`.
+  /// @param arquivo O arquivo, aberto para escrita
+  /// @param chave A chave do plano
+  /// @return Se o plano foi escrito
+  bool Escreve(FILE *arquivo, const ChaveCaixa &chave) const;
+
+  /// @brief Calcula a chave da topologia: um hash das dimensões e das máscaras
+  /// de cada linha.
+  ChaveCaixa CalculaChave() const;
+
+  int GetL() const { return L_; }
+  int GetC() const { return C_; }
+
+  /// @brief Retorna o tamanho, em bytes, dos arranjos próprios do plano.
+  size_t GetBytesProprios() const {
+    return linhas_proprias_.size() * sizeof(LinhaPlano) +
+           validas_proprias_.size() * sizeof(int32_t);
+  }
+
+  /// @brief Retorna as estruturas da linha `i`.
+  const LinhaPlano &Linha(int i) const { return linhas_[i]; }
+
+  /// @brief Retorna as configurações válidas da linha `i`, em ordem
+  /// crescente (`Linha(i).num_validas` elementos).
+  const int32_t *Validas(int i) const {
+    return validas_ + linhas_[i].inicio_validas;
+  }
+
+ private:
+  int L_ = 0, C_ = 0;
+
+  /// @brief Arranjos usados quando o plano é próprio.
+  vector<LinhaPlano> linhas_proprias_;
+  vector<int32_t> validas_proprias_;
+
+  /// @brief Arranjos efetivamente lidos, próprios ou externos.
+  const LinhaPlano *linhas_ = nullptr;
+  const int32_t *validas_ = nullptr;
+};
+
+/// @brief Cabeçalho de um arquivo de plano de topologia. É seguido de `L`
+/// `LinhaPlano`s e de `num_validas` configurações válidas (`int32_t`).
+struct CabecalhoPlano {
+  // Identifica o formato. Deve conter `kMagicaPlano`.
+  char magica[8];
+
+  // Versão do formato. Deve ser `kVersaoPlano`.
+  uint32_t versao;
+
+  // Dimensões da caixa.
+  int32_t L, C;
+
+  // Tamanho do arranjo de configurações válidas, onde linhas iguais
+  // compartilham a mesma faixa.
+  uint32_t num_validas;
+
+  // Chave da topologia, que também dá nome ao arquivo.
+  ChaveCaixa chave;
+};
+
+/// @brief Sequência que identifica um arquivo de plano de topologia.
+const char kMagicaPlano[8] = {'C', 'I', 'F', 'R', 'A', 'P', 'L', 'N'};
+
+/// @brief Versão atual do formato dos arquivos de plano.
+const uint32_t kVersaoPlano = 1;
+
+/// @brief Cache de planos de topologia, endereçado pela chave da topologia. Os
+/// planos mais recentes ficam em memória, em uma lista LRU de capacidade
+/// limitada; o diretório opcional guarda cada plano em um arquivo próprio,
+/// mapeado em memória quando é usado, que persiste entre execuções e pode ser
+/// compartilhado por vários processos. Pode ser usado por várias threads ao
+/// mesmo tempo, e os planos retornados continuam válidos mesmo depois de
+/// descartados do cache.
+class CachePlanos {
+ public:
+  /// @brief Constroi um cache vazio.
+  /// @param capacidade O número máximo de planos mantidos em memória
+  explicit CachePlanos(size_t capacidade);
+
+  CachePlanos(const CachePlanos &) = delete;
+  CachePlanos &operator=(const CachePlanos &) = delete;
+
+  /// @brief Passa a guardar os planos no diretório `caminho`, criando-o se
+  /// ele não existir. Deve ser chamado antes de qualquer consulta.
+  /// @return `nullptr` se o diretório pode ser usado, ou uma mensagem de erro.
+  const char *AbreDiretorio(const char *caminho);
+
+  /// @brief Retorna o plano da topologia de uma caixa, calculando-o apenas se
+  /// ele não estiver em memória nem no diretório.
+  /// @param caixa A caixa, com no máximo `PlanoTopologia::kMaxColunas`
+  /// colunas
+  std::shared_ptr<const PlanoTopologia> Obtem(const Caixa &caixa);
+
+  /// @brief Imprime os contadores de consultas e acertos.
+  void ImprimeEstatisticas(FILE *arquivo);
+
+ private:
+  typedef std::pair<ChaveCaixa, std::shared_ptr<const PlanoTopologia>> Entrada;
+
+  /// @brief Procura o arquivo do plano no diretório e o mapeia em memória.
+  std::shared_ptr<const PlanoTopologia> CarregaArquivo(const ChaveCaixa &chave);
+
+  /// @brief Escreve o arquivo do plano no diretório. O arquivo é escrito com
+  /// um nome temporário e renomeado, para que outros processos nunca vejam um
+  /// plano incompleto.
+  void SalvaArquivo(const ChaveCaixa &chave, const PlanoTopologia &plano);
+
+  /// @brief Coloca um plano no início da lista LRU, descartando o menos
+  /// recente se a capacidade for excedida.
+  /// @return O plano inserido, ou o que outra thread já tiver inserido com a
+  /// mesma chave
+  std::shared_ptr<const PlanoTopologia> Insere(
+      const ChaveCaixa &chave, std::shared_ptr<const PlanoTopologia> plano);
+
+  /// @brief Retorna o caminho do arquivo do plano de chave `chave`.
+  std::string CaminhoArquivo(const ChaveCaixa &chave);
+
+  std::mutex trava_;
+  size_t capacidade_;
+  std::string diretorio_;
+
+  // Lista LRU, do plano mais recente para o menos recente.
+  std::list<Entrada> recentes_;
+  std::unordered_map<ChaveCaixa, std::list<Entrada>::iterator, HashChaveCaixa>
+      indice_;
+
+  // Contadores.
+  long long consultas_ = 0, acertos_memoria_ = 0, acertos_disco_ = 0;
+};
+
+#endif
@@ -0,0 +1,48 @@
+#!/bin/sh
+# COMPARAÇÃO ENTRE O SOCKET E A MEMÓRIA COMPARTILHADA
+#
+# Sobe o servidor nos dois modos e mede, com a ferramenta de carga, a vazão e
+# as latências de cada caminho para a mesma instância, convertida para o
+# formato binário. Caso a instância não seja informada, gera uma caixa
+# completa de LINHAS x 40 cristais, resolvida por feixe de largura 1.
+#
+# Uso: scripts/compara_transporte.sh [instancia] [linhas] [conexoes]
+
+INSTANCIA=${1:-}
+LINHAS=${2:-50000}
+CONEXOES=${3:-1}
+PROGRAMA=${PROGRAMA:-bin/main}
+CARGA=${CARGA:-bin/carga.out}
+REQUISICOES=${REQUISICOES:-50}
+SOCKET=/tmp/cifra_transporte.sock
+MEMORIA=/cifra_transporte
+BINARIO=/tmp/cifra_transporte.bin
+
+if [ -z "$INSTANCIA" ]; then
+  INSTANCIA=/tmp/cifra_transporte.txt
+  echo "Gerando $INSTANCIA ($LINHAS x 40)..." >&2
+  awk -v linhas="$LINHAS" 'BEGIN {
+    srand(1)
+    print linhas, 40, linhas * 40
+    for (i = 1; i <= linhas; i++)
+      for (j = 1; j <= 40; j++)
+        printf "%d %d %d %d %d %d %d\n", i, j, int(rand() * 1000),
+               rand() < 0.5, rand() < 0.5, rand() < 0.5, rand() < 0.5
+  }' > "$INSTANCIA"
+fi
+"$PROGRAMA" -b "$BINARIO" "$INSTANCIA" || exit 1
+
+"$PROGRAMA" --servidor "$SOCKET" -j "$CONEXOES" -f 1 -s 1 2> /dev/null &
+SERVIDOR_SOCKET=$!
+"$PROGRAMA" --memoria-compartilhada "$MEMORIA" -j "$CONEXOES" -f 1 -s 1 \
+  2> /dev/null &
+SERVIDOR_MEMORIA=$!
+sleep 1
+
+echo "== socket"
+"$CARGA" "$SOCKET" "$BINARIO" -c "$CONEXOES" -n "$REQUISICOES"
+echo "== memória compartilhada"
+"$CARGA" -m "$MEMORIA" "$BINARIO" -c "$CONEXOES" -n "$REQUISICOES"
+
+kill "$SERVIDOR_SOCKET" "$SERVIDOR_MEMORIA"
+wait
@@ -0,0 +1,36 @@
+#!/bin/sh
+# ESCALA DA LEITURA PARALELA
+#
+# Mede a vazão da leitura do formato texto com 1 a 32 threads. Caso o arquivo
+# de entrada não exista, gera uma caixa completa de LADO x LADO cristais, com
+# cerca de 1 GB para o lado padrão.
+#
+# Uso: scripts/escala_leitura.sh [arquivo] [lado]
+
+ARQUIVO=${1:-/tmp/cifra_escala_leitura.txt}
+LADO=${2:-7100}
+PROGRAMA=${PROGRAMA:-bin/main}
+
+if [ ! -f "$ARQUIVO" ]; then
+  echo "Gerando $ARQUIVO ($LADO x $LADO)..." >&2
+  awk -v lado="$LADO" 'BEGIN {
+    srand(1)
+    print lado, lado, lado * lado
+    for (i = 1; i <= lado; i++)
+      for (j = 1; j <= lado; j++)
+        printf "%d %d %d %d %d %d %d\n", i, j, int(rand() * 1000),
+               rand() < 0.5, rand() < 0.5, rand() < 0.5, rand() < 0.5
+  }' > "$ARQUIVO"
+fi
+
+# Aquece o cache de páginas antes das medições
+"$PROGRAMA" -l "$ARQUIVO" > /dev/null || exit 1
+
+echo "threads,segundos,MB/s"
+for THREADS in 1 2 4 8 16 32; do
+  "$PROGRAMA" -l -t "$THREADS" "$ARQUIVO" |
+    awk -v t="$THREADS" -F': ' '
+      $1 == "segundos" { s = $2 }
+      $1 == "MB/s" { m = $2 }
+      END { print t "," s "," m }'
+done
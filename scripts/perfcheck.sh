@@ -0,0 +1,79 @@
+#!/bin/sh
+# VERIFICAÇÃO DE REGRESSÕES DE DESEMPENHO
+#
+# Compila o commit BASE em um diretório separado e compara o seu programa
+# principal com o da árvore atual, já compilado, em um corpus de caixas
+# geradas para cada motor de resolução. Falha se algum caso ficar mais de
+# LIMIAR% mais lento com significância estatística, se a árvore atual falhar
+# em algum caso ou se nenhum caso puder ser comparado (veja
+# ferramentas/comparador.cpp). Tudo roda localmente; a base compilada fica em
+# cache no DIRETORIO, por commit.
+#
+# Sem BASE, a base é o ponto em que o ramo atual saiu do seu upstream, de
+# main ou de master, o primeiro que não seja o próprio HEAD, ou HEAD~1.
+#
+# Uso: scripts/perfcheck.sh [base] [limiar]
+
+BASE=$1
+LIMIAR=${2:-5}
+REPETICOES=${REPETICOES:-10}
+DIRETORIO=${DIRETORIO:-/tmp/cifra_perfcheck}
+PROGRAMA=${PROGRAMA:-bin/main}
+GERADOR=${GERADOR:-bin/gerador.out}
+COMPARADOR=${COMPARADOR:-bin/comparador.out}
+
+if [ -z "$BASE" ]; then
+  HEAD_ATUAL=$(git rev-parse HEAD) || exit 2
+  for RAMO in '@{upstream}' main origin/main master origin/master; do
+    PONTO=$(git merge-base HEAD "$RAMO" 2>/dev/null) || continue
+    if [ "$PONTO" != "$HEAD_ATUAL" ]; then
+      BASE=$PONTO
+      break
+    fi
+  done
+  BASE=${BASE:-HEAD~1}
+fi
+
+COMMIT=$(git rev-parse --verify "$BASE^{commit}") || exit 2
+ARVORE_BASE="$DIRETORIO/base-$COMMIT"
+CORPUS="$DIRETORIO/corpus"
+
+if [ ! -x "$ARVORE_BASE/bin/main" ]; then
+  echo "Compilando a base $BASE ($COMMIT)..." >&2
+  rm -rf "$ARVORE_BASE"
+  mkdir -p "$ARVORE_BASE" || exit 2
+  git archive "$COMMIT" | tar -x -C "$ARVORE_BASE" || exit 2
+  make -C "$ARVORE_BASE" bin/main > /dev/null || exit 2
+fi
+
+# Corpus: cada caixa com os motores que a resolvem em menos de um segundo.
+# As caixas dependem apenas dos parâmetros do gerador, então são geradas uma
+# vez.
+mkdir -p "$CORPUS" || exit 2
+gera() {
+  [ -f "$CORPUS/$1.txt" ] || "$GERADOR" -o "$CORPUS/$1.txt" $2 || exit 2
+}
+gera uniforme_1000x8 "-f uniforme -l 1000 -c 8 -d 0.5"
+gera uniforme_20x10 "-f uniforme -l 20 -c 10 -d 0.9"
+gera faixas_20000x8 "-f faixas -l 20000 -c 8 -d 0.9"
+gera longa_20000x4 "-f longa -l 20000 -c 4 -d 0.8"
+
+CASOS="$DIRETORIO/casos.txt"
+cat > "$CASOS" <<EOF
+memoizacao/uniforme_1000x8 $CORPUS/uniforme_1000x8.txt --motor memoizacao
+produtos/uniforme_1000x8 $CORPUS/uniforme_1000x8.txt --motor produtos
+automatico/uniforme_1000x8 $CORPUS/uniforme_1000x8.txt
+feixe/uniforme_1000x8 $CORPUS/uniforme_1000x8.txt -f 8 -s 2
+produtos/uniforme_20x10 $CORPUS/uniforme_20x10.txt --motor produtos
+automatico/uniforme_20x10 $CORPUS/uniforme_20x10.txt
+produtos/faixas_20000x8 $CORPUS/faixas_20000x8.txt --motor produtos
+automatico/faixas_20000x8 $CORPUS/faixas_20000x8.txt
+feixe/faixas_20000x8 $CORPUS/faixas_20000x8.txt -f 8 -s 2
+memoizacao/longa_20000x4 $CORPUS/longa_20000x4.txt --motor memoizacao
+automatico/longa_20000x4 $CORPUS/longa_20000x4.txt
+feixe/longa_20000x4 $CORPUS/longa_20000x4.txt -f 8 -s 2
+EOF
+
+echo "Base: $BASE ($COMMIT); atual: árvore de trabalho" >&2
+"$COMPARADOR" "$ARVORE_BASE/bin/main" "$PROGRAMA" "$CASOS" \
+  -r "$REPETICOES" -l "$LIMIAR"
@@ -0,0 +1,82 @@
+#include "binario.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+bool EhBinario(const char *dados, size_t tamanho) {
+  return tamanho >= sizeof(kMagicaBinario) &&
+         memcmp(dados, kMagicaBinario, sizeof(kMagicaBinario)) == 0;
+}
+
+const char *InterpretaBinario(const char *dados, size_t tamanho,
+                              CabecalhoBinario &cabecalho,
+                              const int32_t *&brilhos,
+                              const uint8_t *&conexoes, long long &posicao) {
+  posicao = -1;
+  if (tamanho < sizeof(CabecalhoBinario) || !EhBinario(dados, tamanho)) {
+    return "arquivo binário sem cabeçalho";
+  }
+
+  memcpy(&cabecalho, dados, sizeof(CabecalhoBinario));
+  if (cabecalho.versao != kVersaoBinario) {
+    return "versão do formato binário não suportada";
+  }
+  if (cabecalho.flags != 0 || cabecalho.reservado != 0) {
+    return "campos reservados do cabeçalho binário devem ser 0";
+  }
+
+  if (cabecalho.L < 1 || cabecalho.C < 1 || cabecalho.N < 0 ||
+      (long long)cabecalho.N > (long long)cabecalho.L * cabecalho.C) {
+    return "dimensões inválidas no cabeçalho binário";
+  }
+
+  size_t posicoes = static_cast<size_t>(cabecalho.L) * cabecalho.C;
+  size_t esperado = sizeof(CabecalhoBinario) + posicoes * sizeof(int32_t) +
+                    Caixa::TamanhoConexoes(posicoes);
+  if (tamanho < esperado) {
+    return "arquivo binário truncado";
+  }
+
+  brilhos = reinterpret_cast<const int32_t *>(dados + sizeof(CabecalhoBinario));
+  conexoes = reinterpret_cast<const uint8_t *>(brilhos + posicoes);
+
+  // Mesmas regras dos formatos texto e denso: -1 marca uma posição vazia, e
+  // o número de posições com cristal deve ser o do cabeçalho
+  long long cristais = 0;
+  for (size_t p = 0; p < posicoes; p++) {
+    if (brilhos[p] < -1) {
+      posicao = (long long)p;
+      return "o brilho do cristal não pode ser negativo";
+    }
+    cristais += brilhos[p] != -1;
+  }
+  if (cristais != cabecalho.N) {
+    return "o número de cristais é diferente de N";
+  }
+  return nullptr;
+}
+
+bool EscreveBinario(const char *caminho, const Caixa &caixa, int n) {
+  FILE *arquivo = fopen(caminho, "wb");
+  if (arquivo == nullptr) {
+    return false;
+  }
+
+  CabecalhoBinario cabecalho;
+  memset(&cabecalho, 0, sizeof(cabecalho));
+  memcpy(cabecalho.magica, kMagicaBinario, sizeof(kMagicaBinario));
+  cabecalho.versao = kVersaoBinario;
+  cabecalho.L = caixa.GetL();
+  cabecalho.C = caixa.GetC();
+  cabecalho.N = n;
+
+  size_t posicoes = caixa.NumPosicoes();
+  size_t bytes_conexoes = Caixa::TamanhoConexoes(posicoes);
+  bool ok = fwrite(&cabecalho, sizeof(cabecalho), 1, arquivo) == 1 &&
+            fwrite(caixa.GetBrilhos(), sizeof(int32_t), posicoes, arquivo) ==
+                posicoes &&
+            fwrite(caixa.GetConexoes(), 1, bytes_conexoes, arquivo) ==
+                bytes_conexoes;
+
+  return fclose(arquivo) == 0 && ok;
+}
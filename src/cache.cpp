@@ -0,0 +1,307 @@
+#include "cache.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "hash.hpp"
+#include "saida.hpp"
+
+ChaveCaixa CalculaChave(const Caixa &caixa,
+                        const ParametrosResolucao &parametros) {
+  // As sementes só afetam a busca em feixe
+  int32_t cabecalho[4] = {
+      caixa.GetL(), caixa.GetC(), parametros.largura_feixe,
+      parametros.largura_feixe > 0 ? parametros.sementes_feixe : 0};
+
+  Hash128 hash;
+  hash.Acrescenta(cabecalho, sizeof(cabecalho));
+
+  size_t posicoes = caixa.NumPosicoes();
+  hash.Acrescenta(caixa.GetBrilhos(), posicoes * sizeof(int32_t));
+
+  // Os bits que sobram no último byte das conexões não fazem parte da caixa
+  size_t bytes_conexoes = Caixa::TamanhoConexoes(posicoes);
+  if (posicoes % 4 == 0) {
+    hash.Acrescenta(caixa.GetConexoes(), bytes_conexoes);
+  } else {
+    hash.Acrescenta(caixa.GetConexoes(), bytes_conexoes - 1);
+    uint8_t ultimo = caixa.GetConexoes()[bytes_conexoes - 1] &
+                     ((1u << (2 * (posicoes % 4))) - 1);
+    hash.Acrescenta(&ultimo, 1);
+  }
+
+  return hash.Finaliza();
+}
+
+ChaveCaixa CalculaChaveCanonica(const Caixa &caixa,
+                                const ParametrosResolucao &parametros,
+                                TransformacaoToroidal &transformacao) {
+  // A busca em feixe depende da orientação da caixa, e uma solução guardada
+  // para outra orientação não seria a que ela encontraria para esta. Suas
+  // soluções ficam na chave da própria caixa, com a transformação identidade.
+  if (parametros.largura_feixe > 0) {
+    transformacao = TransformacaoToroidal();
+    transformacao.L = caixa.GetL();
+    transformacao.C = caixa.GetC();
+    return CalculaChave(caixa, parametros);
+  }
+
+  // A caixa transformada reaproveita a memória entre chamadas da mesma thread
+  thread_local Caixa canonica;
+  transformacao = CalculaFormaCanonica(caixa);
+  AplicaTransformacao(caixa, transformacao, canonica);
+  return CalculaChave(canonica, parametros);
+}
+
+/// @brief Converte as máscaras de linha de uma solução da forma canônica para
+/// as coordenadas originais.
+static void DestransformaMascaras(const uint64_t *canonicas,
+                                  const TransformacaoToroidal &transformacao,
+                                  uint64_t *originais) {
+  size_t palavras = PalavrasPorLinha(transformacao.C);
+  memset(originais, 0, transformacao.L * palavras * sizeof(uint64_t));
+  for (int i = 0; i < transformacao.L; i++) {
+    uint64_t *linha =
+        originais + transformacao.LinhaOriginal(i) * palavras;
+    for (size_t p = 0; p < palavras; p++) {
+      for (uint64_t bits = canonicas[i * palavras + p]; bits != 0;
+           bits &= bits - 1) {
+        int j = transformacao.ColunaOriginal(p * 64 + __builtin_ctzll(bits));
+        linha[j / 64] |= uint64_t(1) << (j % 64);
+      }
+    }
+  }
+}
+
+CacheResultados::CacheResultados(size_t capacidade)
+    : capacidade_(capacidade) {}
+
+CacheResultados::~CacheResultados() {
+  if (mapa_armazem_ != nullptr) {
+    munmap(mapa_armazem_, tamanho_mapa_);
+  }
+  if (fd_armazem_ >= 0) {
+    close(fd_armazem_);
+  }
+}
+
+bool CacheResultados::MapeiaArmazem(size_t tamanho) {
+  if (tamanho <= tamanho_mapa_) {
+    return true;
+  }
+
+  // O arquivo só cresce: o mapeamento é refeito com o tamanho atual
+  if (mapa_armazem_ != nullptr) {
+    munmap(mapa_armazem_, tamanho_mapa_);
+    mapa_armazem_ = nullptr;
+    tamanho_mapa_ = 0;
+  }
+
+  void *mapa = mmap(nullptr, tamanho_armazem_, PROT_READ, MAP_SHARED,
+                    fd_armazem_, 0);
+  if (mapa == MAP_FAILED) {
+    return false;
+  }
+  mapa_armazem_ = static_cast<char *>(mapa);
+  tamanho_mapa_ = tamanho_armazem_;
+  return tamanho <= tamanho_mapa_;
+}
+
+const char *CacheResultados::AbreArmazem(const char *caminho) {
+  std::lock_guard<std::mutex> guarda(trava_);
+
+  fd_armazem_ = open(caminho, O_RDWR | O_CREAT | O_APPEND, 0644);
+  struct stat informacoes;
+  if (fd_armazem_ < 0 || fstat(fd_armazem_, &informacoes) < 0) {
+    return "não foi possível abrir o armazém";
+  }
+  tamanho_armazem_ = informacoes.st_size;
+
+  if (tamanho_armazem_ == 0) {
+    CabecalhoArmazem cabecalho;
+    memset(&cabecalho, 0, sizeof(cabecalho));
+    memcpy(cabecalho.magica, kMagicaArmazem, sizeof(kMagicaArmazem));
+    cabecalho.versao = kVersaoArmazem;
+    if (write(fd_armazem_, &cabecalho, sizeof(cabecalho)) !=
+        sizeof(cabecalho)) {
+      return "não foi possível escrever o armazém";
+    }
+    tamanho_armazem_ = sizeof(cabecalho);
+    return nullptr;
+  }
+
+  if (!MapeiaArmazem(tamanho_armazem_) ||
+      tamanho_armazem_ < sizeof(CabecalhoArmazem) ||
+      memcmp(mapa_armazem_, kMagicaArmazem, sizeof(kMagicaArmazem)) != 0) {
+    return "o arquivo não é um armazém de soluções";
+  }
+
+  CabecalhoArmazem cabecalho;
+  memcpy(&cabecalho, mapa_armazem_, sizeof(cabecalho));
+  if (cabecalho.versao != kVersaoArmazem) {
+    return "versão do armazém não suportada";
+  }
+
+  // Indexa os registros completos
+  size_t posicao = sizeof(CabecalhoArmazem);
+  while (posicao + sizeof(RegistroArmazem) <= tamanho_armazem_) {
+    RegistroArmazem registro;
+    memcpy(&registro, mapa_armazem_ + posicao, sizeof(registro));
+    if (registro.L < 1 || registro.C < 1) {
+      break;
+    }
+
+    size_t num_mascaras = (size_t)registro.L * PalavrasPorLinha(registro.C);
+    size_t tamanho = sizeof(RegistroArmazem) + num_mascaras * sizeof(uint64_t);
+    if (posicao + tamanho > tamanho_armazem_) {
+      break;
+    }
+
+    indice_armazem_[registro.chave] = posicao;
+    posicao += tamanho;
+  }
+
+  // Descarta o que sobrou de uma escrita interrompida, para que os próximos
+  // registros comecem em uma posição válida
+  if (posicao < tamanho_armazem_) {
+    if (ftruncate(fd_armazem_, posicao) < 0) {
+      return "não foi possível reparar o armazém";
+    }
+    tamanho_armazem_ = posicao;
+  }
+
+  return nullptr;
+}
+
+void CacheResultados::InsereEmMemoria(Entrada &&entrada) {
+  if (capacidade_ == 0) {
+    return;
+  }
+
+  ChaveCaixa chave = entrada.chave;
+  recentes_.push_front(std::move(entrada));
+  indice_memoria_[chave] = recentes_.begin();
+
+  if (recentes_.size() > capacidade_) {
+    indice_memoria_.erase(recentes_.back().chave);
+    recentes_.pop_back();
+  }
+}
+
+bool CacheResultados::Busca(const ChaveCaixa &chave,
+                            const TransformacaoToroidal &transformacao,
+                            Cifra &cifra) {
+  std::lock_guard<std::mutex> guarda(trava_);
+  consultas_++;
+
+  size_t palavras = PalavrasPorLinha(cifra.GetCaixa().GetC());
+  vector<uint64_t> mascaras(cifra.GetCaixa().GetL() * palavras);
+  auto em_memoria = indice_memoria_.find(chave);
+  if (em_memoria != indice_memoria_.end()) {
+    acertos_memoria_++;
+    recentes_.splice(recentes_.begin(), recentes_, em_memoria->second);
+    const Entrada &entrada = *em_memoria->second;
+    DestransformaMascaras(entrada.mascaras.data(), transformacao,
+                          mascaras.data());
+    cifra.DefineSolucao(entrada.valor, entrada.limite_superior,
+                        mascaras.data(), palavras);
+    return true;
+  }
+
+  auto no_armazem = indice_armazem_.find(chave);
+  if (no_armazem == indice_armazem_.end()) {
+    return false;
+  }
+
+  RegistroArmazem registro;
+  size_t posicao = no_armazem->second;
+  if (!MapeiaArmazem(posicao + sizeof(registro))) {
+    return false;
+  }
+  memcpy(&registro, mapa_armazem_ + posicao, sizeof(registro));
+  size_t num_mascaras = (size_t)registro.L * PalavrasPorLinha(registro.C);
+  if (!MapeiaArmazem(posicao + sizeof(registro) +
+                     num_mascaras * sizeof(uint64_t))) {
+    return false;
+  }
+
+  acertos_armazem_++;
+  const uint64_t *canonicas = reinterpret_cast<const uint64_t *>(
+      mapa_armazem_ + posicao + sizeof(registro));
+  DestransformaMascaras(canonicas, transformacao, mascaras.data());
+  cifra.DefineSolucao(registro.valor, registro.limite_superior,
+                      mascaras.data(), palavras);
+  InsereEmMemoria({chave, registro.valor, registro.limite_superior,
+                   vector<uint64_t>(canonicas, canonicas + num_mascaras)});
+  return true;
+}
+
+void CacheResultados::Guarda(const ChaveCaixa &chave,
+                             const TransformacaoToroidal &transformacao,
+                             Cifra &cifra) {
+  const Caixa &caixa = cifra.GetCaixa();
+  size_t palavras = PalavrasPorLinha(caixa.GetC());
+  Entrada entrada = {chave, cifra.GetValoresSolucao().second,
+                     cifra.GetLimiteSuperior(),
+                     vector<uint64_t>(caixa.GetL() * palavras, 0)};
+  for (const pair<int, int> &cristal : cifra.GetCristaisSolucao()) {
+    size_t i = transformacao.LinhaTransformada(cristal.first - 1);
+    size_t j = transformacao.ColunaTransformada(cristal.second - 1);
+    entrada.mascaras[i * palavras + j / 64] |= uint64_t(1) << (j % 64);
+  }
+
+  std::lock_guard<std::mutex> guarda(trava_);
+  if (fd_armazem_ >= 0 &&
+      indice_armazem_.find(chave) == indice_armazem_.end()) {
+    // O registro e as máscaras são escritos de uma vez, no fim do arquivo
+    RegistroArmazem registro = {chave, caixa.GetL(), caixa.GetC(),
+                                entrada.valor, entrada.limite_superior};
+    vector<char> bytes(sizeof(registro) +
+                       entrada.mascaras.size() * sizeof(uint64_t));
+    memcpy(bytes.data(), &registro, sizeof(registro));
+    memcpy(bytes.data() + sizeof(registro), entrada.mascaras.data(),
+           entrada.mascaras.size() * sizeof(uint64_t));
+
+    if (write(fd_armazem_, bytes.data(), bytes.size()) ==
+        (ssize_t)bytes.size()) {
+      indice_armazem_[chave] = tamanho_armazem_;
+      tamanho_armazem_ += bytes.size();
+    }
+  }
+
+  if (indice_memoria_.find(chave) == indice_memoria_.end()) {
+    InsereEmMemoria(std::move(entrada));
+  }
+}
+
+void CacheResultados::ImprimeEstatisticas(FILE *arquivo) {
+  std::lock_guard<std::mutex> guarda(trava_);
+  long long acertos = acertos_memoria_ + acertos_armazem_;
+  fprintf(arquivo,
+          "cache: %lld consultas, %lld acertos em memória, %lld no armazém, "
+          "taxa de acerto %.1f%%\n",
+          consultas_, acertos_memoria_, acertos_armazem_,
+          consultas_ > 0 ? 100.0 * acertos / consultas_ : 0.0);
+}
+
+bool ResolveComCache(Cifra &cifra, const ParametrosResolucao &parametros,
+                     CacheResultados *cache) {
+  if (cache == nullptr) {
+    cifra.Resolve(parametros);
+    return false;
+  }
+
+  TransformacaoToroidal transformacao;
+  ChaveCaixa chave =
+      CalculaChaveCanonica(cifra.GetCaixa(), parametros, transformacao);
+  if (cache->Busca(chave, transformacao, cifra)) {
+    return true;
+  }
+  cifra.Resolve(parametros);
+  cache->Guarda(chave, transformacao, cifra);
+  return false;
+}
@@ -0,0 +1,364 @@
+#include "cifra.hpp"
+
+#include <cstdio>
+#include <unordered_set>
+
+Cifra::Cifra(int l, int c, int n) { Reinicia(l, c, n); }
+
+void Cifra::Reinicia(int l, int c, int n) {
+  L_ = l;
+  C_ = c;
+  N_ = n;
+  num_cristais_usados_ = 0;
+  max_valor_caixa_ = 0;
+  limite_superior_ = 0;
+  estatisticas_ = EstatisticasResolucao();
+  tempos_ = TemposFases();
+  cristais_solucao_.clear();
+  plano_ = nullptr;
+  plano_compartilhado_.reset();
+
+  // Inicializa a caixa como uma matriz vazia. A memoização da programação
+  // dinâmica só é alocada em `Resolve`, pois ocupa espaço exponencial em `C_` e
+  // não é usada pela busca em feixe.
+  caixa_.Inicializa(L_, C_);
+}
+
+void Cifra::Associa(int l, int c, int n, const int32_t *brilhos,
+                    const uint8_t *conexoes) {
+  Reinicia(0, 0, 0);
+  L_ = l;
+  C_ = c;
+  N_ = n;
+  caixa_.Associa(L_, C_, brilhos, conexoes);
+}
+
+void Cifra::DefineSolucao(int valor, int limite_superior,
+                          const uint64_t *mascaras,
+                          size_t palavras_por_linha) {
+  max_valor_caixa_ = valor;
+  limite_superior_ = limite_superior;
+
+  // Mesma ordem de `Resolve` e `ResolveFeixe`
+  num_cristais_usados_ = 0;
+  cristais_solucao_.clear();
+  for (int i = L_ - 1; i >= 0; i--) {
+    const uint64_t *mascara = mascaras + i * palavras_por_linha;
+    for (int j = C_ - 1; j >= 0; j--) {
+      if (GET_BIT64(mascara[j / 64], j % 64) == 1) {
+        num_cristais_usados_++;
+        cristais_solucao_.push_back({i + 1, j + 1});
+      }
+    }
+  }
+}
+
+const char *Cifra::ValidaParametros(const ParametrosResolucao &parametros) {
+  if (parametros.largura_feixe > 0 && C_ > kMaxColunasFeixe) {
+    return "a busca em feixe suporta no máximo 64 colunas";
+  }
+
+  if (parametros.largura_feixe == 0 && C_ > kMaxColunasExato) {
+    return "a resolução exata suporta no máximo 30 colunas";
+  }
+
+  return nullptr;
+}
+
+void Cifra::Resolve(const ParametrosResolucao &parametros) {
+  if (parametros.largura_feixe > 0) {
+    ResolveFeixe(parametros.largura_feixe, parametros.sementes_feixe);
+  } else {
+    PreparaPlano(parametros.planos);
+    Resolve(parametros.motor);
+  }
+}
+
+void Cifra::AdicionaCristal(int x, int y, int v, int d, int c, int e, int b) {
+  int conexoes = 0;
+  d == 1 ? SET_BIT(conexoes, 0) : CLEAR_BIT(conexoes, 0);
+  c == 1 ? SET_BIT(conexoes, 1) : CLEAR_BIT(conexoes, 1);
+  e == 1 ? SET_BIT(conexoes, 2) : CLEAR_BIT(conexoes, 2);
+  b == 1 ? SET_BIT(conexoes, 3) : CLEAR_BIT(conexoes, 3);
+
+  // As coordenadas passadas são baseadas em 1, então um ajuste é feito ára
+  // caber nas dimensões da matriz
+  caixa_.Define(x - 1, y - 1, {v, conexoes});
+}
+
+void Cifra::Resolve(MotorExato motor) {
+  if (plano_ == nullptr) {
+    PreparaPlano(nullptr);
+  }
+
+  // Sem um motor escolhido, caixas com sequências longas de linhas iguais
+  // são resolvidas com potências de matrizes, e as demais com a memoização
+  vector<int> classes, sequencias, confs;
+  bool produtos = false;
+  {
+    CronometroFase cronometro(tempos_, kFasePreparacao);
+    AgrupaLinhas(classes, sequencias);
+    CustoResolucao custo = CalculaCusto(sequencias);
+    if (motor == kMotorProdutos) {
+      produtos = custo.cabem_produtos;
+    } else if (motor == kMotorAutomatico) {
+      produtos = custo.cabem_produtos && custo.produtos < custo.memoizacao;
+    }
+  }
+  int valor = produtos ? ResolveProdutos(classes, sequencias, confs)
+                       : ResolveFaixa(0, 0b1 << C_, confs);
+  AplicaSolucao(valor, confs);
+}
+
+CustoResolucao Cifra::EstimaCusto() {
+  if (plano_ == nullptr) {
+    PreparaPlano(nullptr);
+  }
+
+  vector<int> classes, sequencias;
+  AgrupaLinhas(classes, sequencias);
+  return CalculaCusto(sequencias);
+}
+
+void Cifra::PreparaPlano(CachePlanos *planos) {
+  CronometroFase cronometro(tempos_, kFasePreparacao);
+  if (planos != nullptr) {
+    plano_compartilhado_ = planos->Obtem(caixa_);
+    plano_ = plano_compartilhado_.get();
+    return;
+  }
+
+  // O plano próprio reaproveita a memória de resoluções anteriores
+  plano_compartilhado_.reset();
+  plano_proprio_.CalculaMascaras(caixa_);
+  plano_proprio_.CalculaValidas();
+  plano_ = &plano_proprio_;
+  CIFRA_CONTA(estatisticas_.bytes_alocados, plano_proprio_.GetBytesProprios());
+}
+
+int Cifra::ResolveFaixa(int inicio, int fim, vector<int> &confs) {
+  if (plano_ == nullptr) {
+    PreparaPlano(nullptr);
+  }
+
+  // Inicializa a memoização da programação dinâmica para uma matriz vazia,
+  // cobrindo apenas a faixa pedida. A matriz é contígua, e o `assign`
+  // reaproveita a memória de resoluções anteriores quando ela é suficiente.
+  estatisticas_.metodo = kMetodoMemoizacao;
+  num_possibilidades_ = 0b1 << C_;
+  conf_inicial_base_ = inicio;
+  num_confs_iniciais_ = fim - inicio;
+  {
+    CronometroFase cronometro(tempos_, kFasePreparacao);
+    memo_.assign(static_cast<size_t>(L_) * num_possibilidades_ *
+                     num_confs_iniciais_,
+                 Resposta());
+    CIFRA_CONTA(estatisticas_.bytes_alocados,
+                (long long)memo_.size() * sizeof(Resposta));
+  }
+
+  // Encontra a combinação da linha inicial que retorna a maior soma.
+  // Configurações inválidas para a última linha nunca levam a uma solução.
+  int conf_inicial_maxima = -1;
+  Resposta maximo = {true, -1, 0};
+  {
+    CronometroFase cronometro(tempos_, kFaseResolucao);
+    for (int i = inicio; i < fim; i++) {
+      if (!EhInternamenteConsistente(L_ - 1, i)) {
+        CIFRA_CONTA(estatisticas_.costuras_ignoradas, 1);
+        continue;
+      }
+      CIFRA_CONTA(estatisticas_.costuras_avaliadas, 1);
+      TrechoRastreio rastreio("costura", "resolucao", i);
+      Resposta resp = f(L_ - 1, i, i);
+
+      if (resp.valor > maximo.valor) {
+        maximo = resp;
+        conf_inicial_maxima = i;
+      }
+    }
+  }
+
+  confs.assign(L_, 0);
+  if (conf_inicial_maxima == -1) {
+    return -1;
+  }
+
+  // Percorre a tabela encontrando a combinação ótima para cada linha
+  CronometroFase cronometro(tempos_, kFaseReconstrucao);
+  int conf = conf_inicial_maxima;
+  for (int i = L_ - 1; i >= 0; i--) {
+    confs[i] = conf;
+    conf = Memo(i, conf, conf_inicial_maxima).conf;
+  }
+
+  return maximo.valor;
+}
+
+void Cifra::AplicaSolucao(int valor, const vector<int> &confs) {
+  CronometroFase cronometro(tempos_, kFaseReconstrucao);
+  max_valor_caixa_ = valor;
+  limite_superior_ = valor;
+
+  num_cristais_usados_ = 0;
+  cristais_solucao_.clear();
+  for (int i = L_ - 1; i >= 0; i--) {
+    for (int j = C_ - 1; j >= 0; j--) {
+      if (GET_BIT(confs[i], j) == 1) {
+        num_cristais_usados_++;
+        cristais_solucao_.push_back({i + 1, j + 1});
+      }
+    }
+  }
+}
+
+const char *Cifra::Verifica(const Solucao &solucao, int &indice) {
+  // Posições usadas, como índices linha a linha
+  std::unordered_set<size_t> usadas;
+  usadas.reserve(solucao.cristais.size());
+  long long soma = 0;
+  for (indice = 0; indice < (int)solucao.cristais.size(); indice++) {
+    int i = solucao.cristais[indice].first - 1;
+    int j = solucao.cristais[indice].second - 1;
+    if (i < 0 || i >= L_ || j < 0 || j >= C_) {
+      return "posição fora da caixa";
+    }
+    if (caixa_.Brilho(i, j) == -1) {
+      return "não há um cristal na posição";
+    }
+    if (!usadas.insert((size_t)i * C_ + j).second) {
+      return "cristal usado mais de uma vez";
+    }
+    soma += caixa_.Brilho(i, j);
+  }
+
+  // Cada conexão é guardada na posição da esquerda (ou de baixo), e as
+  // vizinhas da última coluna e da primeira linha ficam do outro lado da
+  // caixa
+  for (indice = 0; indice < (int)solucao.cristais.size(); indice++) {
+    int i = solucao.cristais[indice].first - 1;
+    int j = solucao.cristais[indice].second - 1;
+    int conexoes = caixa_.Conexoes(i, j);
+    if (GET_BIT(conexoes, 0) == 1 &&
+        usadas.count((size_t)i * C_ + (j + 1) % C_) != 0) {
+      return "cristal conectado com o cristal usado à sua direita";
+    }
+    if (GET_BIT(conexoes, 1) == 1 &&
+        usadas.count((size_t)((i - 1 + L_) % L_) * C_ + j) != 0) {
+      return "cristal conectado com o cristal usado acima";
+    }
+  }
+
+  indice = -1;
+  if (solucao.num_cristais != (int)solucao.cristais.size()) {
+    return "o número de cristais informado não confere";
+  }
+  if (solucao.soma != soma) {
+    return "a soma dos brilhos informada não confere";
+  }
+
+  return nullptr;
+}
+
+Resposta Cifra::f(int linha, int conf, int conf_inicial) {
+  // Verifica memoiização
+  if (Memo(linha, conf, conf_inicial).calculado) {
+    CIFRA_CONTA(estatisticas_.memo_acertos, 1);
+    return Memo(linha, conf, conf_inicial);
+  }
+
+  CIFRA_CONTA(estatisticas_.memo_faltas, 1);
+  estatisticas_.estados_calculados++;
+
+  // Checa se a configuração é consistente
+  if (!EhInternamenteConsistente(linha, conf)) {
+    CIFRA_CONTA(estatisticas_.estados_invalidos, 1);
+    Memo(linha, conf, conf_inicial) = {true, -1, 0};
+    return Memo(linha, conf, conf_inicial);
+  }
+
+  // Soma o valor dos cristais da linha atual
+  int valor_linha = SomaBrilhosLinha(
+      caixa_.GetBrilhos() + static_cast<size_t>(linha) * C_, conf, C_);
+
+  // Caso base
+  if (linha == 0) {
+    // Verifica se a configuração atual e a configuração da última linha da
+    // caixa são compatíveis
+    CIFRA_CONTA(estatisticas_.verificacoes_compatibilidade, 1);
+    if (!SaoCompativeis(linha, conf, conf_inicial)) {
+      CIFRA_CONTA(estatisticas_.estados_invalidos, 1);
+      Memo(linha, conf, conf_inicial) = {true, -1, 0};
+      return Memo(linha, conf, conf_inicial);
+    }
+
+    // Dado que as linhas são compatíveis, retorna o valor da linha atual
+    Memo(linha, conf, conf_inicial) = {true, valor_linha, conf_inicial};
+    return Memo(linha, conf, conf_inicial);
+  }
+
+  // Inicia o máximo como uma resposta inválida, pois se nenhuma possibilidade
+  // para a linha acima retornou uma resposta válida, a configuração conf
+  // para a linha atual também é inválida
+  Resposta maximo = {true, -1, 0};
+
+  // Testa com as configurações válidas da linha acima, em ordem crescente.
+  // As demais levariam a um resultado inválido
+  const int32_t *validas = plano_->Validas(linha - 1);
+  const uint32_t num_validas = plano_->Linha(linha - 1).num_validas;
+  for (uint32_t k = 0; k < num_validas; k++) {
+    int poss = validas[k];
+
+    // Verifica se a linha atual e a linha acima são compatíveis
+    if (!SaoCompativeis(linha, conf, poss)) {
+      continue;
+    }
+
+    // Faz a chamada recursiva da PD
+    Resposta resp = f(linha - 1, poss, conf_inicial);
+
+    // Se utilizar a possibilidade atual gerou um resultado inválido, pule
+    if (resp.valor == -1) {
+      continue;
+    }
+
+    // Encontrou um novo resultado melhor utilizando a possibilidade atual
+    if (resp.valor + valor_linha > maximo.valor) {
+      maximo = {true, resp.valor + valor_linha, poss};
+    }
+  }
+
+  // Cada configuração válida da linha acima foi verificada uma vez
+  CIFRA_CONTA(estatisticas_.verificacoes_compatibilidade, num_validas);
+  CIFRA_CONTA(estatisticas_.estados_invalidos, maximo.valor == -1);
+
+  // Memoiza e retorna
+  Memo(linha, conf, conf_inicial) = maximo;
+  return maximo;
+}
+
+void Cifra::DumpCaixa() {
+  for (int i = 0; i < L_; i++) {
+    for (int j = 0; j < C_; j++) {
+      printf("%3d ", caixa_.Brilho(i, j));
+    }
+    printf("\n");
+  }
+}
+
+void Cifra::DumpMemo() {
+  for (int k = conf_inicial_base_;
+       k < conf_inicial_base_ + num_confs_iniciais_; k++) {
+    printf("Configuração Inicial: %d\n", k);
+
+    for (int i = 0; i < L_; i++) {
+      printf("\t");
+      for (int j = 0; j < num_possibilidades_; j++) {
+        printf("(%3d %3d %3d) ", Memo(i, j, k).calculado,
+               Memo(i, j, k).valor, Memo(i, j, k).conf);
+      }
+      printf("\n");
+    }
+    printf("\n");
+  }
+}
@@ -0,0 +1,316 @@
+#include "compartilhada.hpp"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+#include <new>
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "Os atômicos do segmento compartilhado devem ser sem travas");
+
+/// @brief Arredonda `valor` para cima, para um múltiplo de `alinhamento`.
+static size_t Alinha(size_t valor, size_t alinhamento) {
+  return (valor + alinhamento - 1) / alinhamento * alinhamento;
+}
+
+/// @brief Mensagem das vagas pendentes quando o servidor termina.
+static const char kMensagemEncerrado[] = "servidor encerrado";
+
+/// @brief Chama o futex compartilhado entre processos (sem
+/// `FUTEX_PRIVATE_FLAG`).
+/// @param espera O tempo máximo de espera de `FUTEX_WAIT`, ou `nullptr`
+static void Futex(std::atomic<uint32_t> &palavra, int operacao,
+                  uint32_t valor, const timespec *espera = nullptr) {
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(&palavra), operacao, valor,
+          espera, nullptr, 0);
+}
+
+/// @brief Espera até que `tenta` retorne `true`, dormindo no futex do sinal
+/// entre as tentativas. A sequência é lida antes da última tentativa, de modo
+/// que uma notificação feita depois dela impede que o futex durma.
+template <typename F>
+static void EsperaSinal(SinalCompartilhado &sinal, F tenta) {
+  while (!tenta()) {
+    uint32_t sequencia = sinal.sequencia.load();
+    sinal.esperando.fetch_add(1);
+    if (tenta()) {
+      sinal.esperando.fetch_sub(1);
+      return;
+    }
+    Futex(sinal.sequencia, FUTEX_WAIT, sequencia);
+    sinal.esperando.fetch_sub(1);
+  }
+}
+
+/// @brief Notifica quem espera por um sinal.
+/// @param quantos O número máximo de processos acordados
+static void NotificaSinal(SinalCompartilhado &sinal, int quantos) {
+  sinal.sequencia.fetch_add(1);
+  if (sinal.esperando.load() > 0) {
+    Futex(sinal.sequencia, FUTEX_WAKE, quantos);
+  }
+}
+
+FilaCompartilhada::~FilaCompartilhada() {
+  if (base_ != nullptr) {
+    munmap(base_, tamanho_);
+  }
+  if (nome_[0] != '\0') {
+    shm_unlink(nome_);
+  }
+}
+
+bool FilaCompartilhada::Cria(const char *nome, int num_vagas,
+                             size_t tamanho_vaga, bool substitui) {
+  if (num_vagas < 1 || strlen(nome) >= sizeof(nome_)) {
+    return false;
+  }
+
+  uint32_t capacidade = 2;
+  while (capacidade < (uint32_t)num_vagas) {
+    capacidade *= 2;
+  }
+
+  size_t pagina = sysconf(_SC_PAGESIZE);
+  size_t inicio_anel = Alinha(sizeof(CabecalhoCompartilhado), 64);
+  size_t inicio_descritores =
+      Alinha(inicio_anel + capacidade * sizeof(CelulaAnel), 64);
+  size_t inicio_vagas = Alinha(
+      inicio_descritores + num_vagas * sizeof(DescritorVaga), pagina);
+  tamanho_vaga = Alinha(tamanho_vaga, pagina);
+  size_t tamanho = inicio_vagas + num_vagas * tamanho_vaga;
+
+  // O arquivo é esparso: as páginas das vagas só ocupam memória quando usadas
+  if (substitui) {
+    shm_unlink(nome);
+  }
+  int fd = shm_open(nome, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  strcpy(nome_, nome);
+
+  void *base = MAP_FAILED;
+  if (ftruncate(fd, tamanho) == 0) {
+    base = mmap(nullptr, tamanho, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+
+  base_ = static_cast<char *>(base);
+  tamanho_ = tamanho;
+  cabecalho_ = new (base_) CabecalhoCompartilhado();
+  anel_ = reinterpret_cast<CelulaAnel *>(base_ + inicio_anel);
+  descritores_ = reinterpret_cast<DescritorVaga *>(base_ + inicio_descritores);
+
+  cabecalho_->versao = kVersaoCompartilhada;
+  cabecalho_->num_vagas = num_vagas;
+  cabecalho_->mascara_anel = capacidade - 1;
+  cabecalho_->tamanho_vaga = tamanho_vaga;
+  cabecalho_->inicio_vagas = inicio_vagas;
+  for (uint32_t i = 0; i < capacidade; i++) {
+    new (&anel_[i]) CelulaAnel();
+    anel_[i].sequencia.store(i);
+  }
+  for (int i = 0; i < num_vagas; i++) {
+    new (&descritores_[i]) DescritorVaga();
+  }
+
+  // A identificação é escrita por último, liberando o segmento aos clientes
+  std::atomic_thread_fence(std::memory_order_release);
+  memcpy(cabecalho_->magica, kMagicaCompartilhada,
+         sizeof(kMagicaCompartilhada));
+  return true;
+}
+
+bool FilaCompartilhada::Abre(const char *nome) {
+  int fd = shm_open(nome, O_RDWR, 0);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat informacoes;
+  void *base = MAP_FAILED;
+  if (fstat(fd, &informacoes) == 0 &&
+      (size_t)informacoes.st_size >= sizeof(CabecalhoCompartilhado)) {
+    base = mmap(nullptr, informacoes.st_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (base == MAP_FAILED) {
+    return false;
+  }
+
+  base_ = static_cast<char *>(base);
+  tamanho_ = informacoes.st_size;
+  cabecalho_ = reinterpret_cast<CabecalhoCompartilhado *>(base_);
+  if (memcmp(cabecalho_->magica, kMagicaCompartilhada,
+             sizeof(kMagicaCompartilhada)) != 0 ||
+      cabecalho_->versao != kVersaoCompartilhada ||
+      cabecalho_->inicio_vagas +
+              cabecalho_->num_vagas * cabecalho_->tamanho_vaga >
+          tamanho_) {
+    return false;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  size_t inicio_anel = Alinha(sizeof(CabecalhoCompartilhado), 64);
+  anel_ = reinterpret_cast<CelulaAnel *>(base_ + inicio_anel);
+  descritores_ = reinterpret_cast<DescritorVaga *>(
+      base_ + Alinha(inicio_anel + (cabecalho_->mascara_anel + 1) *
+                                       sizeof(CelulaAnel),
+                     64));
+  return true;
+}
+
+bool FilaCompartilhada::TentaReservar(int &vaga) {
+  for (uint32_t i = 0; i < cabecalho_->num_vagas; i++) {
+    uint32_t livre = kVagaLivre;
+    if (descritores_[i].estado.load(std::memory_order_relaxed) == livre &&
+        descritores_[i].estado.compare_exchange_strong(livre,
+                                                       kVagaReservada)) {
+      vaga = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+int FilaCompartilhada::ReservaVaga() {
+  int vaga = -1;
+  EsperaSinal(cabecalho_->liberacoes, [&]() {
+    return cabecalho_->encerrado.load() || TentaReservar(vaga);
+  });
+  return vaga;
+}
+
+bool FilaCompartilhada::Submete(int vaga, size_t tamanho) {
+  if (cabecalho_->encerrado.load()) {
+    return false;
+  }
+
+  DescritorVaga &descritor = descritores_[vaga];
+  descritor.tamanho_entrada = tamanho;
+  descritor.estado.store(kVagaPendente);
+
+  // Cada vaga ocupa no máximo uma posição do anel, cuja capacidade é maior
+  // que o número de vagas: a inserção nunca encontra o anel cheio
+  uint64_t posicao = cabecalho_->fim_anel.load(std::memory_order_relaxed);
+  while (true) {
+    CelulaAnel &celula = anel_[posicao & cabecalho_->mascara_anel];
+    uint64_t sequencia = celula.sequencia.load(std::memory_order_acquire);
+    if (sequencia == posicao &&
+        cabecalho_->fim_anel.compare_exchange_weak(
+            posicao, posicao + 1, std::memory_order_relaxed)) {
+      celula.vaga = vaga;
+      celula.sequencia.store(posicao + 1, std::memory_order_release);
+      break;
+    }
+    if (sequencia != posicao) {
+      posicao = cabecalho_->fim_anel.load(std::memory_order_relaxed);
+    }
+  }
+
+  NotificaSinal(cabecalho_->submissoes, 1);
+  return true;
+}
+
+bool FilaCompartilhada::Aguarda(int vaga, const char *&resultado,
+                                size_t &tamanho) {
+  DescritorVaga &descritor = descritores_[vaga];
+  descritor.aguardando.store(1);
+
+  // A espera é limitada para perceber uma submissão feita durante o
+  // encerramento, que nenhum trabalhador concluirá
+  const timespec espera = {0, 100 * 1000 * 1000};
+  uint32_t estado;
+  while ((estado = descritor.estado.load()) == kVagaPendente) {
+    if (cabecalho_->encerrado.load() == kFilaFinalizada) {
+      descritor.aguardando.store(0);
+      resultado = kMensagemEncerrado;
+      tamanho = strlen(kMensagemEncerrado);
+      descritor.estado.store(kVagaReservada);
+      return false;
+    }
+    Futex(descritor.estado, FUTEX_WAIT, kVagaPendente, &espera);
+  }
+  descritor.aguardando.store(0);
+
+  resultado = GetVaga(vaga) + descritor.inicio_resultado;
+  tamanho = descritor.tamanho_resultado;
+  descritor.estado.store(kVagaReservada);
+  return estado == kVagaPronta;
+}
+
+void FilaCompartilhada::LiberaVaga(int vaga) {
+  descritores_[vaga].estado.store(kVagaLivre);
+  NotificaSinal(cabecalho_->liberacoes, 1);
+}
+
+bool FilaCompartilhada::TentaRetirar(int &vaga) {
+  uint64_t posicao = cabecalho_->inicio_anel.load(std::memory_order_relaxed);
+  while (true) {
+    CelulaAnel &celula = anel_[posicao & cabecalho_->mascara_anel];
+    uint64_t sequencia = celula.sequencia.load(std::memory_order_acquire);
+    intptr_t diferenca = (intptr_t)sequencia - (intptr_t)(posicao + 1);
+
+    if (diferenca == 0) {
+      if (cabecalho_->inicio_anel.compare_exchange_weak(
+              posicao, posicao + 1, std::memory_order_relaxed)) {
+        vaga = celula.vaga;
+        celula.sequencia.store(posicao + cabecalho_->mascara_anel + 1,
+                               std::memory_order_release);
+        return true;
+      }
+    } else if (diferenca < 0) {
+      return false;
+    } else {
+      posicao = cabecalho_->inicio_anel.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+int FilaCompartilhada::ProximaVaga() {
+  int vaga = -1;
+  EsperaSinal(cabecalho_->submissoes, [&]() {
+    return cabecalho_->encerrado.load() || TentaRetirar(vaga);
+  });
+  return vaga;
+}
+
+void FilaCompartilhada::Conclui(int vaga, bool sucesso, size_t inicio,
+                                size_t tamanho) {
+  DescritorVaga &descritor = descritores_[vaga];
+  descritor.inicio_resultado = inicio;
+  descritor.tamanho_resultado = tamanho;
+  descritor.estado.store(sucesso ? kVagaPronta : kVagaErro);
+  if (descritor.aguardando.load()) {
+    Futex(descritor.estado, FUTEX_WAKE, INT_MAX);
+  }
+}
+
+void FilaCompartilhada::Encerra() {
+  cabecalho_->encerrado.store(kFilaEncerrando);
+  NotificaSinal(cabecalho_->submissoes, INT_MAX);
+  NotificaSinal(cabecalho_->liberacoes, INT_MAX);
+}
+
+void FilaCompartilhada::Finaliza() {
+  for (uint32_t i = 0; i < cabecalho_->num_vagas; i++) {
+    if (descritores_[i].estado.load() == kVagaPendente) {
+      memcpy(GetVaga(i), kMensagemEncerrado, strlen(kMensagemEncerrado));
+      Conclui(i, false, 0, strlen(kMensagemEncerrado));
+    }
+  }
+  cabecalho_->encerrado.store(kFilaFinalizada);
+}
@@ -0,0 +1,122 @@
+#include "contadores.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+static const char *const kNomesEventos[kNumEventos] = {
+    "ciclos", "instrucoes", "faltas_llc", "faltas_dtlb", "desvios_errados"};
+
+static ContadoresHardware *contadores_ativos = nullptr;
+
+const char *NomeEvento(EventoHardware evento) {
+  return kNomesEventos[evento];
+}
+
+/// @brief Preenche o tipo e a configuração de `perf_event_attr` de um evento.
+static void ConfiguraEvento(EventoHardware evento, perf_event_attr &atributos) {
+  const uint64_t leitura_dtlb =
+      PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+  atributos.type = PERF_TYPE_HARDWARE;
+  switch (evento) {
+    case kEventoCiclos:
+      atributos.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+    case kEventoInstrucoes:
+      atributos.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+    case kEventoFaltasLlc:
+      atributos.config = PERF_COUNT_HW_CACHE_MISSES;
+      break;
+    case kEventoFaltasDtlb:
+      atributos.type = PERF_TYPE_HW_CACHE;
+      atributos.config = leitura_dtlb;
+      break;
+    default:
+      atributos.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+  }
+}
+
+/// @brief Traduz o erro de `perf_event_open`.
+static const char *MotivoErro(int erro) {
+  switch (erro) {
+    case ENOENT:
+    case EOPNOTSUPP:
+      return "evento não suportado pelo processador ou pelo kernel";
+    case EACCES:
+    case EPERM:
+      return "sem permissão (veja /proc/sys/kernel/perf_event_paranoid)";
+    case ENOSYS:
+      return "perf_event_open não está disponível";
+    default:
+      return strerror(erro);
+  }
+}
+
+ContadoresHardware::ContadoresHardware() {
+  for (int evento = 0; evento < kNumEventos; evento++) {
+    fds_[evento] = -1;
+  }
+}
+
+ContadoresHardware::~ContadoresHardware() {
+  for (int evento = 0; evento < kNumEventos; evento++) {
+    if (fds_[evento] >= 0) {
+      close(fds_[evento]);
+    }
+  }
+}
+
+const char *ContadoresHardware::Abre() {
+  // Conta apenas o espaço de usuário, que é o permitido sem privilégios na
+  // configuração padrão do kernel. `inherit` soma os processos filhos da
+  // resolução em processos quando eles terminam.
+  bool algum = false;
+  for (int evento = 0; evento < kNumEventos; evento++) {
+    perf_event_attr atributos;
+    memset(&atributos, 0, sizeof(atributos));
+    atributos.size = sizeof(atributos);
+    ConfiguraEvento((EventoHardware)evento, atributos);
+    atributos.exclude_kernel = 1;
+    atributos.exclude_hv = 1;
+    atributos.inherit = 1;
+    atributos.read_format =
+        PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    fds_[evento] = syscall(SYS_perf_event_open, &atributos, 0, -1, -1,
+                           PERF_FLAG_FD_CLOEXEC);
+    if (fds_[evento] < 0 && motivo_ == nullptr) {
+      motivo_ = MotivoErro(errno);
+    }
+    algum = algum || fds_[evento] >= 0;
+  }
+  return algum ? nullptr : motivo_;
+}
+
+void ContadoresHardware::Le(long long valores[kNumEventos]) const {
+  for (int evento = 0; evento < kNumEventos; evento++) {
+    // Valor, tempo habilitado e tempo efetivamente contando
+    uint64_t leitura[3];
+    valores[evento] = 0;
+    if (fds_[evento] < 0 ||
+        read(fds_[evento], leitura, sizeof(leitura)) != sizeof(leitura) ||
+        leitura[2] == 0) {
+      continue;
+    }
+    valores[evento] =
+        (long long)((double)leitura[0] * leitura[1] / leitura[2]);
+  }
+}
+
+void AtivaContadoresHardware(ContadoresHardware *contadores) {
+  contadores_ativos = contadores;
+}
+
+ContadoresHardware *GetContadoresHardware() { return contadores_ativos; }
@@ -0,0 +1,349 @@
+#include "entrada.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+#include "binario.hpp"
+#include "rastreio.hpp"
+#include "saida.hpp"
+
+bool LeCabecalho(Leitor &leitor, int &L, int &C, int &N) {
+  if (!leitor.LeInteiro(L) || !leitor.LeInteiro(C) || !leitor.LeInteiro(N)) {
+    return false;
+  }
+
+  if (L < 1 || C < 1) {
+    return leitor.Falha("a caixa deve ter ao menos uma linha e uma coluna");
+  }
+
+  if (N < 0 || (long long)N > (long long)L * C) {
+    return leitor.Falha("número de cristais incompatível com a caixa");
+  }
+
+  return true;
+}
+
+FormatoEntrada DetectaFormato(Leitor &leitor) {
+  // O formato binário só é aceito quando ocupa a entrada inteira
+  if (leitor.GetPosicao() == leitor.GetDados() &&
+      EhBinario(leitor.GetDados(), leitor.GetTamanho())) {
+    return FormatoEntrada::kBinario;
+  }
+
+  if (leitor.ConsomePalavra(kPalavraDensa)) {
+    return FormatoEntrada::kDensa;
+  }
+
+  return FormatoEntrada::kTexto;
+}
+
+/// @brief Lê uma caixa no formato binário, sem copiá-la: a caixa aponta
+/// diretamente para o buffer do leitor.
+static bool LeCaixaBinaria(Leitor &leitor, Cifra &cifra) {
+  CabecalhoBinario cabecalho;
+  const int32_t *brilhos;
+  const uint8_t *conexoes;
+  long long posicao;
+  const char *erro = InterpretaBinario(leitor.GetDados(), leitor.GetTamanho(),
+                                       cabecalho, brilhos, conexoes, posicao);
+  if (erro != nullptr && posicao >= 0) {
+    return leitor.FalhaNoCristal((int)(posicao / cabecalho.C) + 1,
+                                 (int)(posicao % cabecalho.C) + 1, erro);
+  }
+  if (erro != nullptr) {
+    return leitor.FalhaGeral(erro);
+  }
+
+  cifra.Associa(cabecalho.L, cabecalho.C, cabecalho.N, brilhos, conexoes);
+  leitor.PulaParaFim();
+  return true;
+}
+
+/// @brief Lê uma caixa no formato denso, preenchendo a caixa linha a linha.
+static bool LeCaixaDensa(Leitor &leitor, Cifra &cifra) {
+  int L, C;
+  if (!leitor.LeInteiro(L) || !leitor.LeInteiro(C)) {
+    return false;
+  }
+
+  if (L < 1 || C < 1) {
+    return leitor.Falha("a caixa deve ter ao menos uma linha e uma coluna");
+  }
+
+  cifra.Reinicia(L, C, 0);
+  Caixa &caixa = cifra.EditaCaixa();
+
+  int N = 0;
+  for (int i = 0; i < L; i++) {
+    for (int j = 0; j < C; j++) {
+      int brilho = 0;
+      if (!leitor.LeInteiro(brilho)) {
+        return false;
+      }
+
+      if (brilho < -1) {
+        return leitor.Falha("o brilho do cristal não pode ser negativo");
+      }
+
+      caixa.DefineBrilho(i, j, brilho);
+      N += brilho != -1;
+    }
+  }
+
+  for (int i = 0; i < L; i++) {
+    for (int j = 0; j < C; j++) {
+      int conexoes = 0;
+      if (!leitor.LeDigito(conexoes)) {
+        return false;
+      }
+
+      if (conexoes > Caixa::kMascaraConexoes) {
+        return leitor.Falha("dígitos de conexão devem estar entre 0 e 3");
+      }
+
+      caixa.DefineConexoes(i, j, conexoes);
+    }
+  }
+
+  cifra.DefineNumCristais(N);
+  return true;
+}
+
+/// @brief Lê uma caixa no formato texto.
+static bool LeCaixaTexto(Leitor &leitor, Cifra &cifra) {
+  int L, C, N;
+  if (!LeCabecalho(leitor, L, C, N)) {
+    return false;
+  }
+
+  cifra.Reinicia(L, C, N);
+
+  CristalLido cristal;
+  for (int i = 0; i < N; i++) {
+    if (!LeCristal(leitor, L, C, cristal)) {
+      return false;
+    }
+    if (cifra.GetCaixa().Brilho(cristal.x - 1, cristal.y - 1) != -1) {
+      return leitor.Falha("já há um cristal nessa posição");
+    }
+    cifra.AdicionaCristal(cristal.x, cristal.y, cristal.v, cristal.d,
+                          cristal.c, cristal.e, cristal.b);
+  }
+
+  return true;
+}
+
+/// @brief Cristais lidos por uma thread em `LeCaixaTextoParalela`.
+struct TrechoLido {
+  vector<int> x, y, v;
+  vector<uint8_t> conexoes;
+
+  // Leitor do trecho, que guarda o erro da thread, se houver.
+  Leitor leitor;
+  bool ok = true;
+};
+
+/// @brief Lê uma caixa no formato texto com várias threads. O buffer após o
+/// cabeçalho é dividido em trechos terminados em quebras de linha; cada thread
+/// lê os cristais do seu trecho para arranjos próprios, e depois os espalha
+/// pela caixa. Como os cristais ocupam posições distintas, não há travas.
+static bool LeCaixaTextoParalela(Leitor &leitor, Cifra &cifra,
+                                 int num_threads) {
+  int L, C, N;
+  if (!LeCabecalho(leitor, L, C, N)) {
+    return false;
+  }
+
+  // Divide o restante da entrada em trechos de tamanhos próximos, avançando
+  // cada corte até o fim da linha em que ele cai
+  const char *inicio = leitor.GetPosicao();
+  const char *fim = leitor.GetDados() + leitor.GetTamanho();
+  vector<const char *> cortes(num_threads + 1, fim);
+  cortes[0] = inicio;
+  for (int k = 1; k < num_threads; k++) {
+    const char *corte = std::max(inicio + (fim - inicio) * k / num_threads,
+                                 cortes[k - 1]);
+    const char *quebra =
+        static_cast<const char *>(memchr(corte, '\n', fim - corte));
+    cortes[k] = quebra == nullptr ? fim : quebra + 1;
+  }
+
+  vector<TrechoLido> trechos(num_threads);
+  vector<std::thread> threads;
+  for (int k = 0; k < num_threads; k++) {
+    threads.emplace_back([&, k]() {
+      NomeiaThreadRastreio("leitura", k);
+      TrechoRastreio rastreio("trecho", "leitura", k);
+      TrechoLido &trecho = trechos[k];
+      trecho.leitor.AbreTrecho(cortes[k], cortes[k + 1]);
+
+      CristalLido cristal;
+      while (!trecho.leitor.Terminou()) {
+        if (!LeCristal(trecho.leitor, L, C, cristal)) {
+          trecho.ok = false;
+          return;
+        }
+
+        trecho.x.push_back(cristal.x - 1);
+        trecho.y.push_back(cristal.y - 1);
+        trecho.v.push_back(cristal.v);
+        trecho.conexoes.push_back(cristal.d | (cristal.c << 1));
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // Reporta o erro do primeiro trecho inválido, convertendo a linha relativa
+  // ao trecho em uma linha da entrada
+  long long total = 0;
+  for (int k = 0; k < num_threads; k++) {
+    if (!trechos[k].ok) {
+      int linha = leitor.GetLinha() + trechos[k].leitor.GetLinha() - 1 +
+                  std::count(inicio, cortes[k], '\n');
+      return leitor.FalhaNaLinha(linha, trechos[k].leitor.GetMensagem());
+    }
+    total += trechos[k].x.size();
+  }
+
+  if (total != N) {
+    return leitor.FalhaGeral("o número de cristais é diferente de N");
+  }
+
+  cifra.Reinicia(L, C, N);
+  Caixa &caixa = cifra.EditaCaixa();
+
+  threads.clear();
+  for (int k = 0; k < num_threads; k++) {
+    threads.emplace_back([&, k]() {
+      NomeiaThreadRastreio("leitura", k);
+      TrechoRastreio rastreio("preenchimento", "leitura", k);
+      const TrechoLido &trecho = trechos[k];
+      for (size_t r = 0; r < trecho.x.size(); r++) {
+        caixa.DefineBrilho(trecho.x[r], trecho.y[r], trecho.v[r]);
+        caixa.AcrescentaConexoesAtomico(trecho.x[r], trecho.y[r],
+                                        trecho.conexoes[r]);
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  // Cristais repetidos ocupam a mesma posição, e a caixa fica com menos de N
+  const int32_t *brilhos = caixa.GetBrilhos();
+  if (std::count(brilhos, brilhos + caixa.NumPosicoes(), -1) !=
+      (long long)caixa.NumPosicoes() - N) {
+    return leitor.FalhaGeral("há mais de um cristal na mesma posição");
+  }
+
+  leitor.PulaParaFim();
+  return true;
+}
+
+bool LeInstancia(Leitor &leitor, FormatoEntrada formato, Cifra &cifra,
+                 int num_threads) {
+  switch (formato) {
+    case FormatoEntrada::kBinario:
+      return LeCaixaBinaria(leitor, cifra);
+    case FormatoEntrada::kDensa:
+      return LeCaixaDensa(leitor, cifra);
+    case FormatoEntrada::kTexto:
+      break;
+  }
+
+  if (num_threads > 1) {
+    return LeCaixaTextoParalela(leitor, cifra, num_threads);
+  }
+
+  return LeCaixaTexto(leitor, cifra);
+}
+
+/// @brief Lê uma solução no formato binário, convertendo as máscaras de linha
+/// na lista de cristais usados.
+static bool LeSolucaoBinaria(Leitor &leitor, const Caixa &caixa,
+                             Solucao &solucao) {
+  CabecalhoSolucao cabecalho;
+  memcpy(&cabecalho, leitor.GetDados(), sizeof(cabecalho));
+  if (cabecalho.versao != kVersaoSolucao) {
+    return leitor.FalhaGeral("versão do formato binário não suportada");
+  }
+  if (cabecalho.L != caixa.GetL() || cabecalho.C != caixa.GetC()) {
+    return leitor.FalhaGeral("as dimensões da solução não são as da caixa");
+  }
+  if (leitor.GetTamanho() != TamanhoSolucaoBinaria(cabecalho.L, cabecalho.C)) {
+    return leitor.FalhaGeral("tamanho do arquivo incompatível com o "
+                             "cabeçalho");
+  }
+
+  // A cópia evita depender do alinhamento do buffer do leitor
+  size_t palavras = PalavrasPorLinha(cabecalho.C);
+  vector<uint64_t> mascaras(cabecalho.L * palavras);
+  memcpy(mascaras.data(), leitor.GetDados() + sizeof(cabecalho),
+         mascaras.size() * sizeof(uint64_t));
+
+  solucao.num_cristais = cabecalho.num_cristais;
+  solucao.soma = cabecalho.soma;
+  solucao.cristais.clear();
+  for (int i = 0; i < cabecalho.L; i++) {
+    for (size_t p = 0; p < palavras; p++) {
+      for (uint64_t bits = mascaras[i * palavras + p]; bits != 0;
+           bits &= bits - 1) {
+        solucao.cristais.push_back(
+            {i + 1, (int)(p * 64 + __builtin_ctzll(bits)) + 1});
+      }
+    }
+  }
+
+  leitor.PulaParaFim();
+  return true;
+}
+
+bool LeSolucao(Leitor &leitor, const Caixa &caixa, Solucao &solucao) {
+  if (leitor.GetTamanho() >= sizeof(CabecalhoSolucao) &&
+      memcmp(leitor.GetDados(), kMagicaSolucao, sizeof(kMagicaSolucao)) == 0) {
+    return LeSolucaoBinaria(leitor, caixa, solucao);
+  }
+
+  int num_cristais, soma;
+  if (!leitor.LeInteiro(num_cristais) || !leitor.LeInteiro(soma)) {
+    return false;
+  }
+  if (num_cristais < 0) {
+    return leitor.Falha("o número de cristais não pode ser negativo");
+  }
+
+  solucao.num_cristais = num_cristais;
+  solucao.soma = soma;
+  solucao.cristais.clear();
+  for (int k = 0; k < num_cristais; k++) {
+    int x, y;
+    if (!leitor.LeInteiro(x) || !leitor.LeInteiro(y)) {
+      return false;
+    }
+    solucao.cristais.push_back({x, y});
+  }
+
+  if (!leitor.Terminou()) {
+    return leitor.Falha("há dados além dos cristais declarados");
+  }
+
+  return true;
+}
+
+bool LeCaixa(Leitor &leitor, Cifra &cifra, int num_threads) {
+  FormatoEntrada formato = DetectaFormato(leitor);
+  if (!LeInstancia(leitor, formato, cifra, num_threads)) {
+    return false;
+  }
+
+  if (!leitor.Terminou()) {
+    return leitor.Falha(formato == FormatoEntrada::kDensa
+                            ? "há dados além das L linhas de conexões"
+                            : "há dados além dos N cristais declarados");
+  }
+
+  return true;
+}
@@ -0,0 +1,56 @@
+#include "escritor.hpp"
+
+#include <algorithm>
+#include <cerrno>
+
+void Escritor::EscreveBytes(const char *dados, size_t tamanho) {
+  if (usado_ + tamanho > buffer_.size()) {
+    AbreEspaco(tamanho);
+  }
+
+  // Blocos maiores do que o buffer são escritos diretamente
+  if (usado_ + tamanho > buffer_.size()) {
+    if (Descarrega()) {
+      Escreve(dados, tamanho);
+    }
+    return;
+  }
+
+  memcpy(buffer_.data() + usado_, dados, tamanho);
+  usado_ += tamanho;
+}
+
+bool Escritor::Descarrega() {
+  if (fd_ == kMemoria) {
+    return true;
+  }
+
+  Escreve(buffer_.data(), usado_);
+  usado_ = 0;
+  return !erro_;
+}
+
+void Escritor::Escreve(const char *dados, size_t tamanho) {
+  // Depois de um erro, o restante da saída é descartado, para não continuar
+  // escrevendo em um descritor quebrado
+  size_t escritos = 0;
+  while (!erro_ && escritos < tamanho) {
+    ssize_t resultado = write(fd_, dados + escritos, tamanho - escritos);
+    if (resultado < 0 && errno == EINTR) {
+      continue;
+    }
+    if (resultado < 0) {
+      erro_ = true;
+      return;
+    }
+    escritos += resultado;
+  }
+}
+
+void Escritor::AbreEspaco(size_t bytes) {
+  if (fd_ == kMemoria) {
+    buffer_.resize(std::max(2 * buffer_.size(), usado_ + bytes));
+  } else {
+    Descarrega();
+  }
+}
@@ -0,0 +1,155 @@
+#include "estatisticas.hpp"
+
+#include <algorithm>
+
+static const char *const kNomesMetodos[kNumMetodos] = {
+    "nenhum", "memoizacao", "produtos", "feixe"};
+
+static const char *const kNomesFases[kNumFases] = {
+    "leitura", "preparacao", "resolucao", "reconstrucao", "saida"};
+
+const char *NomeMetodo(MetodoResolucao metodo) {
+  return kNomesMetodos[metodo];
+}
+
+const char *NomeFase(FaseExecucao fase) { return kNomesFases[fase]; }
+
+void EstatisticasResolucao::Acumula(const EstatisticasResolucao &outras) {
+  metodo = std::max(metodo, outras.metodo);
+  estados_calculados += outras.estados_calculados;
+  memo_acertos += outras.memo_acertos;
+  memo_faltas += outras.memo_faltas;
+  verificacoes_compatibilidade += outras.verificacoes_compatibilidade;
+  estados_invalidos += outras.estados_invalidos;
+  costuras_avaliadas += outras.costuras_avaliadas;
+  costuras_ignoradas += outras.costuras_ignoradas;
+  bytes_alocados += outras.bytes_alocados;
+}
+
+void EstatisticasResolucao::Desconta(
+    const EstatisticasResolucao &anteriores) {
+  estados_calculados -= anteriores.estados_calculados;
+  memo_acertos -= anteriores.memo_acertos;
+  memo_faltas -= anteriores.memo_faltas;
+  verificacoes_compatibilidade -= anteriores.verificacoes_compatibilidade;
+  estados_invalidos -= anteriores.estados_invalidos;
+  costuras_avaliadas -= anteriores.costuras_avaliadas;
+  costuras_ignoradas -= anteriores.costuras_ignoradas;
+  bytes_alocados -= anteriores.bytes_alocados;
+}
+
+void TemposFases::Acumula(const TemposFases &outros) {
+  for (int fase = 0; fase < kNumFases; fase++) {
+    segundos[fase] += outros.segundos[fase];
+    for (int evento = 0; evento < kNumEventos; evento++) {
+      eventos[fase][evento] += outros.eventos[fase][evento];
+    }
+  }
+}
+
+/// @brief Escreve os eventos de hardware de cada fase, com as instruções por
+/// ciclo, e os eventos da fase de resolução por estado calculado. Eventos
+/// indisponíveis são escritos como null.
+static void EscreveEventosJson(FILE *arquivo,
+                               const EstatisticasResolucao &estatisticas,
+                               const TemposFases &tempos,
+                               const ContadoresHardware &contadores) {
+  bool disponivel = false;
+  for (int evento = 0; evento < kNumEventos; evento++) {
+    disponivel = disponivel || contadores.Disponivel((EventoHardware)evento);
+  }
+  fprintf(arquivo, ",\n \"hardware\": {\"disponivel\": %s, \"motivo\": ",
+          disponivel ? "true" : "false");
+  if (contadores.GetMotivo() != nullptr) {
+    fprintf(arquivo, "\"%s\"", contadores.GetMotivo());
+  } else {
+    fprintf(arquivo, "null");
+  }
+
+  fprintf(arquivo, ",\n  \"fases\": {");
+  const bool tem_ipc = contadores.Disponivel(kEventoCiclos) &&
+                       contadores.Disponivel(kEventoInstrucoes);
+  for (int fase = 0; fase < kNumFases; fase++) {
+    const long long *eventos = tempos.eventos[fase];
+    fprintf(arquivo, "%s\"%s\": {", fase > 0 ? ",\n   " : "",
+            NomeFase((FaseExecucao)fase));
+    for (int evento = 0; evento < kNumEventos; evento++) {
+      fprintf(arquivo, "\"%s\": ", NomeEvento((EventoHardware)evento));
+      if (contadores.Disponivel((EventoHardware)evento)) {
+        fprintf(arquivo, "%lld, ", eventos[evento]);
+      } else {
+        fprintf(arquivo, "null, ");
+      }
+    }
+    if (tem_ipc && eventos[kEventoCiclos] > 0) {
+      fprintf(arquivo, "\"ipc\": %.3f}",
+              (double)eventos[kEventoInstrucoes] / eventos[kEventoCiclos]);
+    } else {
+      fprintf(arquivo, "\"ipc\": null}");
+    }
+  }
+
+  // A fase de resolução contém os laços internos de todos os métodos
+  fprintf(arquivo, "},\n  \"por_estado\": {");
+  const long long estados = estatisticas.estados_calculados;
+  for (int evento = 0; evento < kNumEventos; evento++) {
+    fprintf(arquivo, "%s\"%s\": ", evento > 0 ? ", " : "",
+            NomeEvento((EventoHardware)evento));
+    if (contadores.Disponivel((EventoHardware)evento) && estados > 0) {
+      fprintf(arquivo, "%.3f",
+              (double)tempos.eventos[kFaseResolucao][evento] / estados);
+    } else {
+      fprintf(arquivo, "null");
+    }
+  }
+  fprintf(arquivo, "}}");
+}
+
+void EscreveEstatisticasJson(FILE *arquivo,
+                             const EstatisticasResolucao &estatisticas,
+                             const TemposFases &tempos, bool em_cache,
+                             const ContadoresHardware *hardware) {
+#ifdef CIFRA_SEM_ESTATISTICAS
+  const bool contadores = false;
+#else
+  const bool contadores = true;
+#endif
+
+  const struct {
+    const char *nome;
+    long long valor;
+  } campos[] = {
+      {"estados_calculados", estatisticas.estados_calculados},
+      {"memo_acertos", estatisticas.memo_acertos},
+      {"memo_faltas", estatisticas.memo_faltas},
+      {"verificacoes_compatibilidade",
+       estatisticas.verificacoes_compatibilidade},
+      {"estados_invalidos", estatisticas.estados_invalidos},
+      {"costuras_avaliadas", estatisticas.costuras_avaliadas},
+      {"costuras_ignoradas", estatisticas.costuras_ignoradas},
+      {"bytes_alocados", estatisticas.bytes_alocados},
+  };
+
+  fprintf(arquivo,
+          "{\"metodo\": \"%s\", \"em_cache\": %s, \"contadores\": %s,\n"
+          " \"contagens\": {",
+          NomeMetodo(estatisticas.metodo), em_cache ? "true" : "false",
+          contadores ? "true" : "false");
+  for (size_t c = 0; c < sizeof(campos) / sizeof(campos[0]); c++) {
+    fprintf(arquivo, "%s\"%s\": %lld", c > 0 ? ", " : "", campos[c].nome,
+            campos[c].valor);
+  }
+
+  fprintf(arquivo, "},\n \"segundos\": {");
+  double total = 0;
+  for (int fase = 0; fase < kNumFases; fase++) {
+    fprintf(arquivo, "\"%s\": %.6f, ", NomeFase((FaseExecucao)fase),
+            tempos.segundos[fase]);
+    total += tempos.segundos[fase];
+  }
+  fprintf(arquivo, "\"total\": %.6f}", total);
+  if (hardware != nullptr) {
+    EscreveEventosJson(arquivo, estatisticas, tempos, *hardware);
+  }
+  fprintf(arquivo, "}\n");
+}
@@ -0,0 +1,267 @@
+#include <algorithm>
+
+#include "cifra.hpp"
+
+void Cifra::ResolveFeixe(int largura, int num_sementes) {
+  estatisticas_.metodo = kMetodoFeixe;
+  num_cristais_usados_ = 0;
+  cristais_solucao_.clear();
+
+  // O limite superior é a soma, linha a linha, da melhor configuração de cada
+  // linha isolada, que nunca é menor do que o ótimo da caixa inteira
+  vector<vector<int>> sufixos;
+  {
+    CronometroFase cronometro(tempos_, kFasePreparacao);
+    CalculaSufixosOtimistas(sufixos);
+    limite_superior_ = 0;
+    for (int i = 0; i < L_; i++) {
+      limite_superior_ += sufixos[i][0];
+    }
+    CIFRA_CONTA(estatisticas_.bytes_alocados,
+                (long long)L_ * 2 * (C_ + 1) * sizeof(int));
+  }
+  CronometroFase cronometro_resolucao(tempos_, kFaseResolucao);
+
+  // A primeira passada ignora a costura vertical. As sementes são, em ordem,
+  // a linha vazia (compatível com qualquer última linha), as configurações da
+  // primeira linha dos melhores estados finais dessa passada e as melhores
+  // configurações da primeira linha considerada isoladamente.
+  vector<vector<EstadoFeixe>> historico;
+  {
+    TrechoRastreio rastreio("passada", "resolucao");
+    PassadaFeixe(largura, false, 0, sufixos, historico);
+  }
+
+  vector<int> finais(historico[L_ - 1].size());
+  for (int k = 0; k < (int)finais.size(); k++) {
+    finais[k] = k;
+  }
+  std::sort(finais.begin(), finais.end(), [&](int a, int b) {
+    return historico[L_ - 1][a].valor > historico[L_ - 1][b].valor;
+  });
+
+  vector<EstadoFeixe> primeira_linha = historico[0];
+  std::sort(primeira_linha.begin(), primeira_linha.end(),
+            [](const EstadoFeixe &a, const EstadoFeixe &b) {
+              return a.valor > b.valor;
+            });
+
+  uint64_t conexoes_acima = 0;
+  for (int j = 0; j < C_; j++) {
+    if (GET_BIT(caixa_.Conexoes(0, j), 1) == 1) {
+      conexoes_acima |= uint64_t(1) << j;
+    }
+  }
+
+  vector<uint64_t> candidatas;
+  for (int k : finais) {
+    // Volta pelo histórico até a primeira linha
+    for (int i = L_ - 1; i > 0; i--) {
+      k = historico[i][k].pai;
+    }
+    candidatas.push_back(historico[0][k].fronteira);
+  }
+  for (const EstadoFeixe &estado : primeira_linha) {
+    candidatas.push_back(estado.fronteira);
+  }
+
+  vector<uint64_t> sementes = {0};
+  for (uint64_t semente : candidatas) {
+    if ((int)sementes.size() >= num_sementes) {
+      break;
+    }
+
+    // Com uma única linha, a linha é vizinha de si mesma na vertical
+    if (L_ == 1 && (semente & conexoes_acima) != 0) {
+      CIFRA_CONTA(estatisticas_.costuras_ignoradas, 1);
+      continue;
+    }
+
+    if (std::find(sementes.begin(), sementes.end(), semente) ==
+        sementes.end()) {
+      sementes.push_back(semente);
+    }
+  }
+
+  // Resolve a caixa fixando cada semente na primeira linha, e guarda a melhor
+  vector<vector<EstadoFeixe>> melhor_historico;
+  int melhor_estado = -1;
+  max_valor_caixa_ = -1;
+  CIFRA_CONTA(estatisticas_.costuras_avaliadas, (long long)sementes.size());
+  for (size_t s = 0; s < sementes.size(); s++) {
+    TrechoRastreio rastreio("passada", "resolucao", (long long)s);
+    int estado = PassadaFeixe(largura, true, sementes[s], sufixos, historico);
+
+    if (historico[L_ - 1][estado].valor > max_valor_caixa_) {
+      max_valor_caixa_ = historico[L_ - 1][estado].valor;
+      melhor_estado = estado;
+      melhor_historico.swap(historico);
+    }
+  }
+
+  // Percorre o histórico da melhor passada recuperando a configuração de cada
+  // linha, na mesma ordem usada por `Resolve`
+  cronometro_resolucao.Para();
+  CronometroFase cronometro_reconstrucao(tempos_, kFaseReconstrucao);
+  int k = melhor_estado;
+  for (int i = L_ - 1; i >= 0; i--) {
+    uint64_t conf = melhor_historico[i][k].fronteira;
+    for (int j = C_ - 1; j >= 0; j--) {
+      if (GET_BIT64(conf, j) == 1) {
+        num_cristais_usados_++;
+        cristais_solucao_.push_back({i + 1, j + 1});
+      }
+    }
+
+    k = melhor_historico[i][k].pai;
+  }
+}
+
+int Cifra::PassadaFeixe(int largura, bool com_semente, uint64_t semente,
+                        const vector<vector<int>> &sufixos,
+                        vector<vector<EstadoFeixe>> &historico) {
+  historico.assign(L_, vector<EstadoFeixe>());
+
+  // Com uma semente, a primeira linha já está decidida
+  int linha_inicial = 0;
+  if (com_semente) {
+    int valor = 0;
+    for (int j = 0; j < C_; j++) {
+      if (GET_BIT64(semente, j) == 1) {
+        valor += caixa_.Brilho(0, j);
+      }
+    }
+
+    historico[0].push_back({semente, valor, -1});
+    linha_inicial = 1;
+  }
+
+  vector<EstadoFeixe> atual, candidatos;
+  for (int i = linha_inicial; i < L_; i++) {
+    // O feixe da linha começa com os estados do final da linha anterior
+    atual.clear();
+    if (i == 0) {
+      atual.push_back({0, 0, -1});
+    } else {
+      for (int k = 0; k < (int)historico[i - 1].size(); k++) {
+        atual.push_back(
+            {historico[i - 1][k].fronteira, historico[i - 1][k].valor, k});
+      }
+    }
+
+    for (int j = 0; j < C_; j++) {
+      const int brilho = caixa_.Brilho(i, j);
+      const int conexoes = caixa_.Conexoes(i, j);
+      const uint64_t bit = uint64_t(1) << j;
+
+      // Vizinhos que impedem a escolha do cristal atual caso estejam escolhidos
+      // e conectados a ele. O vizinho à direita só é conhecido na última
+      // coluna, quando fecha a costura horizontal com a coluna 0.
+      bool conecta_esquerda = j > 0 && GET_BIT(caixa_.Conexoes(i, j - 1), 0);
+      bool conecta_direita = j == C_ - 1 && GET_BIT(conexoes, 0);
+      bool conecta_acima = GET_BIT(conexoes, 1);
+
+      // Na última linha, o cristal também é vizinho da semente (costura
+      // vertical), que se conecta a ele pela conexão de cima da linha 0
+      bool bloqueado =
+          brilho == -1 ||
+          (com_semente && i == L_ - 1 && GET_BIT64(semente, j) == 1 &&
+           GET_BIT(caixa_.Conexoes(0, j), 1) == 1);
+
+      candidatos.clear();
+      for (const EstadoFeixe &estado : atual) {
+        const uint64_t fronteira = estado.fronteira;
+
+        // Não escolhe o cristal atual
+        candidatos.push_back({fronteira & ~bit, estado.valor, estado.pai});
+
+        if (bloqueado ||
+            (conecta_acima && GET_BIT64(fronteira, j) == 1) ||
+            (conecta_esquerda && GET_BIT64(fronteira, j - 1) == 1) ||
+            (conecta_direita && (C_ == 1 || GET_BIT64(fronteira, 0) == 1))) {
+          CIFRA_CONTA(estatisticas_.estados_invalidos, 1);
+          continue;
+        }
+
+        // Escolhe o cristal atual
+        candidatos.push_back(
+            {fronteira | bit, estado.valor + brilho, estado.pai});
+      }
+      estatisticas_.estados_calculados += candidatos.size();
+
+      // Estados com o mesmo perfil têm o mesmo futuro, então basta manter o de
+      // maior valor
+      std::sort(candidatos.begin(), candidatos.end(),
+                [](const EstadoFeixe &a, const EstadoFeixe &b) {
+                  if (a.fronteira != b.fronteira) {
+                    return a.fronteira < b.fronteira;
+                  }
+                  return a.valor > b.valor;
+                });
+      candidatos.erase(std::unique(candidatos.begin(), candidatos.end(),
+                                   [](const EstadoFeixe &a,
+                                      const EstadoFeixe &b) {
+                                     return a.fronteira == b.fronteira;
+                                   }),
+                       candidatos.end());
+
+      // Mantém os `largura` estados de maior valor somado à estimativa otimista
+      // do restante da linha. O restante da caixa contribui igualmente para
+      // todos os estados, e por isso é omitido.
+      if ((int)candidatos.size() > largura) {
+        const vector<int> &sufixo = sufixos[i];
+        auto pontuacao = [&](const EstadoFeixe &e) {
+          return e.valor + sufixo[2 * (j + 1) + GET_BIT64(e.fronteira, j)];
+        };
+        std::nth_element(candidatos.begin(), candidatos.begin() + largura,
+                         candidatos.end(),
+                         [&](const EstadoFeixe &a, const EstadoFeixe &b) {
+                           return pontuacao(a) > pontuacao(b);
+                         });
+        candidatos.resize(largura);
+      }
+
+      atual.swap(candidatos);
+    }
+
+    historico[i] = atual;
+    CIFRA_CONTA(estatisticas_.bytes_alocados,
+                (long long)atual.size() * sizeof(EstadoFeixe));
+  }
+
+  int melhor = 0;
+  for (int k = 1; k < (int)historico[L_ - 1].size(); k++) {
+    if (historico[L_ - 1][k].valor > historico[L_ - 1][melhor].valor) {
+      melhor = k;
+    }
+  }
+
+  return melhor;
+}
+
+void Cifra::CalculaSufixosOtimistas(vector<vector<int>> &sufixos) {
+  sufixos.assign(L_, vector<int>(2 * (C_ + 1), 0));
+
+  for (int i = 0; i < L_; i++) {
+    vector<int> &sufixo = sufixos[i];
+
+    for (int j = C_ - 1; j >= 0; j--) {
+      for (int anterior = 0; anterior <= 1; anterior++) {
+        // Não escolhe o cristal da coluna j
+        int maximo = sufixo[2 * (j + 1)];
+
+        // Escolhe o cristal da coluna j, se existir e não estiver conectado ao
+        // cristal escolhido na coluna anterior
+        bool bloqueado = caixa_.Brilho(i, j) == -1 ||
+                         (anterior == 1 && j > 0 &&
+                          GET_BIT(caixa_.Conexoes(i, j - 1), 0) == 1);
+        if (!bloqueado) {
+          maximo = std::max(maximo,
+                            caixa_.Brilho(i, j) + sufixo[2 * (j + 1) + 1]);
+        }
+
+        sufixo[2 * j + anterior] = maximo;
+      }
+    }
+  }
+}
@@ -0,0 +1,230 @@
+#include "gerador.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using std::vector;
+
+/// @brief Nomes das famílias, na ordem de `FamiliaGerador`.
+static const char *const kNomesFamilias[kNumFamilias] = {
+    "uniforme", "xadrez", "aglomerados", "faixas",
+    "longa",    "larga",  "adversaria"};
+
+/// @brief Dimensões padrão de cada família, na ordem de `FamiliaGerador`.
+static const int kDimensoesPadrao[kNumFamilias][2] = {
+    {100, 10}, {100, 10}, {200, 16}, {100000, 8},
+    {1000000, 4}, {8, 20}, {100, 12}};
+
+/// @brief Gerador pseudoaleatório splitmix64. Ao contrário das distribuições
+/// da biblioteca padrão, gera a mesma sequência em qualquer implementação.
+class Sorteador {
+ public:
+  explicit Sorteador(uint64_t semente) : estado_(semente) {}
+
+  uint64_t Proximo() {
+    uint64_t z = (estado_ += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+
+  /// @brief Sorteia um inteiro em [0, `limite`).
+  int Inteiro(int limite) { return (int)(Proximo() % (uint64_t)limite); }
+
+  /// @brief Retorna `true` com probabilidade `probabilidade`.
+  bool Chance(double probabilidade) {
+    return (double)(Proximo() >> 11) * 0x1.0p-53 < probabilidade;
+  }
+
+ private:
+  uint64_t estado_;
+};
+
+const char *NomeFamilia(FamiliaGerador familia) {
+  return kNomesFamilias[familia];
+}
+
+bool FamiliaPorNome(const char *nome, FamiliaGerador &familia) {
+  for (int f = 0; f < kNumFamilias; f++) {
+    if (strcmp(nome, kNomesFamilias[f]) == 0) {
+      familia = static_cast<FamiliaGerador>(f);
+      return true;
+    }
+  }
+  return false;
+}
+
+void GeraCaixa(const ParametrosGerador &parametros, Cifra &cifra) {
+  const int L = parametros.L > 0 ? parametros.L
+                                 : kDimensoesPadrao[parametros.familia][0];
+  const int C = parametros.C > 0 ? parametros.C
+                                 : kDimensoesPadrao[parametros.familia][1];
+  const double densidade = parametros.densidade;
+  Sorteador sorteador(parametros.semente);
+
+  // Brilho de cada posição (-1 se vazia) e probabilidade das suas conexões
+  // à direita e acima
+  vector<int> brilhos((size_t)L * C, -1);
+  double conexao = 0.5;
+
+  // Nas faixas, apenas uma linha de cada tipo é sorteada, e cada linha da
+  // caixa copia a linha do tipo da sua faixa
+  int tipos = 0, altura = 1;
+  switch (parametros.familia) {
+    case kFamiliaUniforme:
+    case kFamiliaLonga:
+    case kFamiliaLarga:
+      for (size_t k = 0; k < brilhos.size(); k++) {
+        if (sorteador.Chance(densidade)) {
+          brilhos[k] = sorteador.Inteiro(1000);
+        }
+      }
+      break;
+
+    case kFamiliaXadrez:
+      for (size_t k = 0; k < brilhos.size(); k++) {
+        bool preta = (k / C + k % C) % 2 == 0;
+        brilhos[k] = (preta ? 500 : 0) + sorteador.Inteiro(500);
+      }
+      conexao = densidade;
+      break;
+
+    case kFamiliaAglomerados: {
+      // Cerca de um aglomerado a cada 100 posições, com raio de 1 a 3
+      int num_aglomerados = (int)(brilhos.size() / 100) + 1;
+      for (int a = 0; a < num_aglomerados; a++) {
+        int centro_i = sorteador.Inteiro(L), centro_j = sorteador.Inteiro(C);
+        int raio = 1 + sorteador.Inteiro(3);
+        for (int di = -raio; di <= raio; di++) {
+          for (int dj = -raio; dj <= raio; dj++) {
+            int i = ((centro_i + di) % L + L) % L;
+            int j = ((centro_j + dj) % C + C) % C;
+            size_t k = (size_t)i * C + j;
+            if (di * di + dj * dj <= raio * raio && brilhos[k] == -1 &&
+                sorteador.Chance(densidade)) {
+              brilhos[k] = sorteador.Inteiro(1000);
+            }
+          }
+        }
+      }
+      break;
+    }
+
+    case kFamiliaFaixas:
+      // Os tipos se alternam em faixas que dão quatro voltas pela caixa
+      tipos = std::min(L, 2 + sorteador.Inteiro(3));
+      altura = std::max(1, L / (4 * tipos));
+      for (size_t k = 0; k < (size_t)tipos * C; k++) {
+        if (sorteador.Chance(densidade)) {
+          brilhos[k] = sorteador.Inteiro(1000);
+        }
+      }
+      break;
+
+    case kFamiliaAdversaria:
+      for (size_t k = 0; k < brilhos.size(); k++) {
+        brilhos[k] = sorteador.Inteiro(1000);
+      }
+      conexao = densidade;
+      break;
+
+    case kNumFamilias:
+      break;
+  }
+
+  // Conexões entre posições vizinhas com cristais. Uma posição nunca é
+  // conectada consigo mesma, em caixas de uma linha ou coluna.
+  vector<int> conexoes((size_t)L * C, 0);
+  for (int i = 0; i < (tipos > 0 ? tipos : L); i++) {
+    for (int j = 0; j < C; j++) {
+      size_t k = (size_t)i * C + j;
+      size_t direita = (size_t)i * C + (j + 1) % C;
+      size_t acima = (size_t)((i - 1 + L) % L) * C + j;
+      if (brilhos[k] == -1) {
+        continue;
+      }
+
+      // A linha acima de um tipo só é conhecida ao montar as faixas
+      if (tipos > 0) {
+        acima = (size_t)-1;
+      }
+      if (parametros.familia != kFamiliaAdversaria && direita != k &&
+          brilhos[direita] != -1 && sorteador.Chance(conexao)) {
+        conexoes[k] |= 1;
+      }
+      if (acima != k && (acima == (size_t)-1 || brilhos[acima] != -1) &&
+          sorteador.Chance(conexao)) {
+        conexoes[k] |= 2;
+      }
+    }
+  }
+
+  // Monta as faixas de baixo para cima, pois a linha de cada tipo fica na
+  // posição do seu índice, e desfaz as conexões verticais com posições vazias
+  if (tipos > 0) {
+    for (int i = L - 1; i >= 0; i--) {
+      int tipo = i / altura % tipos;
+      for (int j = 0; j < C; j++) {
+        brilhos[(size_t)i * C + j] = brilhos[(size_t)tipo * C + j];
+        conexoes[(size_t)i * C + j] = conexoes[(size_t)tipo * C + j];
+      }
+    }
+    for (int i = 0; i < L; i++) {
+      for (int j = 0; j < C; j++) {
+        size_t acima = (size_t)((i - 1 + L) % L) * C + j;
+        if (brilhos[acima] == -1 || acima == (size_t)i * C + j) {
+          conexoes[(size_t)i * C + j] &= ~2;
+        }
+      }
+    }
+  }
+
+  int n = 0;
+  for (int brilho : brilhos) {
+    n += brilho != -1;
+  }
+
+  cifra.Reinicia(L, C, n);
+  Caixa &caixa = cifra.EditaCaixa();
+  for (int i = 0; i < L; i++) {
+    for (int j = 0; j < C; j++) {
+      size_t k = (size_t)i * C + j;
+      if (brilhos[k] != -1) {
+        caixa.Define(i, j, {brilhos[k], conexoes[k]});
+      }
+    }
+  }
+}
+
+void EscreveCaixaTexto(Escritor &escritor, const Caixa &caixa, int n) {
+  const int L = caixa.GetL(), C = caixa.GetC();
+  escritor.EscreveInteiro(L);
+  escritor.EscreveCaractere(' ');
+  escritor.EscreveInteiro(C);
+  escritor.EscreveCaractere(' ');
+  escritor.EscreveInteiro(n);
+  escritor.EscreveCaractere('\n');
+
+  for (int i = 0; i < L; i++) {
+    for (int j = 0; j < C; j++) {
+      if (caixa.Brilho(i, j) == -1) {
+        continue;
+      }
+
+      // As conexões à esquerda e abaixo são as vistas pelos vizinhos
+      int conexoes = caixa.Conexoes(i, j);
+      int campos[7] = {i + 1,
+                       j + 1,
+                       caixa.Brilho(i, j),
+                       GET_BIT(conexoes, 0),
+                       GET_BIT(conexoes, 1),
+                       GET_BIT(caixa.Conexoes(i, (j - 1 + C) % C), 0),
+                       GET_BIT(caixa.Conexoes((i + 1) % L, j), 1)};
+      for (int campo = 0; campo < 7; campo++) {
+        escritor.EscreveInteiro(campos[campo]);
+        escritor.EscreveCaractere(campo < 6 ? ' ' : '\n');
+      }
+    }
+  }
+}
@@ -0,0 +1,110 @@
+#include "leitor.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+Leitor::~Leitor() {
+  if (mapeamento_ != nullptr) {
+    munmap(mapeamento_, fim_ - inicio_);
+  }
+}
+
+bool Leitor::Abre(const char *caminho) {
+  int fd = caminho == nullptr ? STDIN_FILENO : open(caminho, O_RDONLY);
+  if (fd < 0) {
+    snprintf(erro_, sizeof(erro_), "não foi possível abrir %s: %s", caminho,
+             strerror(errno));
+    return false;
+  }
+
+  // Arquivos regulares não vazios são mapeados diretamente em memória
+  struct stat info;
+  if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+    void *mapeamento =
+        mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapeamento != MAP_FAILED) {
+      madvise(mapeamento, info.st_size, MADV_SEQUENTIAL);
+      mapeamento_ = mapeamento;
+      inicio_ = static_cast<const char *>(mapeamento);
+      fim_ = inicio_ + info.st_size;
+    }
+  }
+
+  // Caso contrário, lê a entrada inteira em blocos para o buffer
+  if (mapeamento_ == nullptr) {
+    const size_t kBloco = 1 << 20;
+    size_t tamanho = 0;
+    while (true) {
+      buffer_.resize(tamanho + kBloco);
+      ssize_t lidos = read(fd, buffer_.data() + tamanho, kBloco);
+      if (lidos < 0 && errno == EINTR) {
+        continue;
+      }
+      if (lidos < 0) {
+        snprintf(erro_, sizeof(erro_), "erro ao ler a entrada: %s",
+                 strerror(errno));
+        if (caminho != nullptr) {
+          close(fd);
+        }
+        return false;
+      }
+      if (lidos == 0) {
+        break;
+      }
+      tamanho += lidos;
+    }
+
+    buffer_.resize(tamanho);
+    inicio_ = buffer_.data();
+    fim_ = inicio_ + tamanho;
+  }
+
+  if (caminho != nullptr) {
+    close(fd);
+  }
+
+  pos_ = inicio_;
+  linha_ = 1;
+  return true;
+}
+
+bool Leitor::Falha(const char *mensagem) {
+  return FalhaNaLinha(linha_, mensagem);
+}
+
+bool Leitor::FalhaNaLinha(int linha, const char *mensagem) {
+  mensagem_ = mensagem;
+  snprintf(erro_, sizeof(erro_), "linha %d: %s", linha, mensagem);
+  return false;
+}
+
+bool Leitor::FalhaGeral(const char *mensagem) {
+  mensagem_ = mensagem;
+  snprintf(erro_, sizeof(erro_), "%s", mensagem);
+  return false;
+}
+
+bool Leitor::FalhaNoCristal(int x, int y, const char *mensagem) {
+  mensagem_ = mensagem;
+  snprintf(erro_, sizeof(erro_), "cristal (%d, %d): %s", x, y, mensagem);
+  return false;
+}
+
+bool Leitor::ConsomePalavra(const char *palavra) {
+  PulaEspacos();
+
+  size_t tamanho = strlen(palavra);
+  if ((size_t)(fim_ - pos_) < tamanho || memcmp(pos_, palavra, tamanho) != 0 ||
+      (pos_ + tamanho != fim_ && !EhEspaco(pos_[tamanho]))) {
+    return false;
+  }
+
+  pos_ += tamanho;
+  return true;
+}
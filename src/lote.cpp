@@ -0,0 +1,264 @@
+#include "lote.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+
+#include "entrada.hpp"
+#include "fila.hpp"
+#include "metricas.hpp"
+#include "rastreio.hpp"
+#include "saida.hpp"
+
+/// @brief Registra uma instância que não pôde ser resolvida nas métricas, se
+/// houver.
+static void RegistraErro(Metricas *metricas) {
+  if (metricas != nullptr) {
+    metricas->RegistraErro();
+  }
+}
+
+bool ResolveLote(Leitor &leitor, const ParametrosResolucao &parametros,
+                 CacheResultados *cache, Escritor &escritor,
+                 vector<double> &latencias) {
+  Cifra cifra;
+  Metricas *metricas = GetMetricas();
+
+  for (int instancia = 1; !leitor.Terminou(); instancia++) {
+    auto inicio = std::chrono::steady_clock::now();
+    TrechoRastreio rastreio("instancia", "lote", instancia);
+
+    FormatoEntrada formato = DetectaFormato(leitor);
+    if (formato == FormatoEntrada::kBinario) {
+      fprintf(stderr, "O modo em lote não aceita o formato binário\n");
+      RegistraErro(metricas);
+      return false;
+    }
+
+    bool lida;
+    {
+      TrechoRastreio rastreio_leitura("leitura", "lote", instancia);
+      lida = LeInstancia(leitor, formato, cifra);
+    }
+    if (!lida) {
+      fprintf(stderr, "Instância %d inválida: %s\n", instancia,
+              leitor.GetErro());
+      RegistraErro(metricas);
+      return false;
+    }
+
+    const char *erro = cifra.ValidaParametros(parametros);
+    if (erro != nullptr) {
+      fprintf(stderr, "Instância %d: %s\n", instancia, erro);
+      RegistraErro(metricas);
+      return false;
+    }
+
+    bool em_cache = ResolveComCache(cifra, parametros, cache);
+    if (metricas != nullptr) {
+      metricas->RegistraResolucao(cifra, cache != nullptr, em_cache);
+    }
+    {
+      TrechoRastreio rastreio_saida("saida", "lote", instancia);
+      EscreveSolucaoTexto(escritor, cifra);
+    }
+
+    latencias.push_back(std::chrono::duration<double>(
+                            std::chrono::steady_clock::now() - inicio)
+                            .count());
+    if (metricas != nullptr) {
+      metricas->RegistraLatencia(latencias.back());
+    }
+  }
+
+  if (!escritor.Descarrega()) {
+    fprintf(stderr, "Erro ao escrever as soluções\n");
+    return false;
+  }
+  return true;
+}
+
+/// @brief Uma instância em trânsito pela esteira de `ResolveLoteParalelo`.
+struct Tarefa {
+  // Posição da instância na entrada (0-based).
+  long long sequencia = 0;
+
+  // Momento em que a leitura da instância começou.
+  std::chrono::steady_clock::time_point inicio;
+
+  // O problema, reaproveitado entre as instâncias que passam pela tarefa.
+  Cifra cifra;
+
+  // A solução já formatada, à espera da thread escritora.
+  Escritor saida{Escritor::kMemoria};
+
+  // Erro encontrado ao validar os parâmetros, ou `nullptr`.
+  const char *erro = nullptr;
+};
+
+bool ResolveLoteParalelo(Leitor &leitor, const ParametrosResolucao &parametros,
+                         CacheResultados *cache, int num_trabalhadores,
+                         Escritor &escritor, vector<double> &latencias) {
+  // Tarefas suficientes para manter todos os trabalhadores ocupados enquanto
+  // a escritora espera uma instância demorada
+  const int num_tarefas = 4 * num_trabalhadores + 4;
+  vector<std::unique_ptr<Tarefa>> tarefas;
+  FilaLimitada<Tarefa *> livres(num_tarefas), pendentes(num_tarefas),
+      prontas(num_tarefas);
+  for (int k = 0; k < num_tarefas; k++) {
+    tarefas.emplace_back(new Tarefa());
+    livres.Insere(tarefas.back().get());
+  }
+
+  // Número total de instâncias, conhecido apenas ao fim da leitura
+  std::atomic<long long> total(-1);
+
+  // Indica que uma instância falhou, e que as seguintes devem ser descartadas
+  std::atomic<bool> cancelado(false);
+
+  // A profundidade da fila é a das instâncias lidas à espera de um
+  // trabalhador
+  Metricas *metricas = GetMetricas();
+  if (metricas != nullptr) {
+    metricas->DefineFonteFila(
+        [&pendentes]() { return (long long)pendentes.GetTamanhoAproximado(); });
+  }
+
+  vector<std::thread> trabalhadores;
+  for (int k = 0; k < num_trabalhadores; k++) {
+    trabalhadores.emplace_back([&, k]() {
+      NomeiaThreadRastreio("trabalhador", k);
+
+      // Uma tarefa nula indica o fim da entrada
+      for (Tarefa *tarefa; (tarefa = pendentes.Remove()) != nullptr;) {
+        TrechoRastreio rastreio("instancia", "lote", tarefa->sequencia + 1);
+        tarefa->erro = tarefa->cifra.ValidaParametros(parametros);
+        if (tarefa->erro != nullptr) {
+          RegistraErro(metricas);
+        } else {
+          bool em_cache = ResolveComCache(tarefa->cifra, parametros, cache);
+          if (metricas != nullptr) {
+            metricas->RegistraResolucao(tarefa->cifra, cache != nullptr,
+                                        em_cache);
+          }
+          tarefa->saida.Limpa();
+          EscreveSolucaoTexto(tarefa->saida, tarefa->cifra);
+        }
+        prontas.Insere(tarefa);
+      }
+    });
+  }
+
+  std::thread escritora([&]() {
+    // As tarefas prontas fora de ordem esperam na janela até a vez delas
+    vector<Tarefa *> janela(num_tarefas, nullptr);
+    long long proxima = 0;
+    int tentativas = 0;
+    NomeiaThreadRastreio("escritora", -1);
+
+    while (proxima != total.load(std::memory_order_acquire)) {
+      Tarefa *tarefa;
+      if (!prontas.TentaRemover(tarefa)) {
+        Recua(tentativas);
+        continue;
+      }
+      tentativas = 0;
+
+      janela[tarefa->sequencia % num_tarefas] = tarefa;
+      while ((tarefa = janela[proxima % num_tarefas]) != nullptr) {
+        janela[proxima % num_tarefas] = nullptr;
+
+        if (tarefa->erro != nullptr && !cancelado) {
+          fprintf(stderr, "Instância %lld: %s\n", tarefa->sequencia + 1,
+                  tarefa->erro);
+          cancelado = true;
+        }
+
+        if (!cancelado) {
+          TrechoRastreio rastreio("saida", "lote", tarefa->sequencia + 1);
+          escritor.EscreveBytes(tarefa->saida.GetDados(),
+                                tarefa->saida.GetTamanho());
+          latencias.push_back(std::chrono::duration<double>(
+                                  std::chrono::steady_clock::now() -
+                                  tarefa->inicio)
+                                  .count());
+          if (metricas != nullptr) {
+            metricas->RegistraLatencia(latencias.back());
+          }
+        }
+
+        livres.Insere(tarefa);
+        proxima++;
+      }
+    }
+  });
+
+  // Estágio de leitura, na thread atual
+  bool ok = true;
+  long long sequencia = 0;
+  while (!cancelado && !leitor.Terminou()) {
+    Tarefa *tarefa = livres.Remove();
+    tarefa->inicio = std::chrono::steady_clock::now();
+    TrechoRastreio rastreio("leitura", "lote", sequencia + 1);
+
+    FormatoEntrada formato = DetectaFormato(leitor);
+    if (formato == FormatoEntrada::kBinario) {
+      fprintf(stderr, "O modo em lote não aceita o formato binário\n");
+      RegistraErro(metricas);
+      ok = false;
+      break;
+    }
+
+    if (!LeInstancia(leitor, formato, tarefa->cifra)) {
+      fprintf(stderr, "Instância %lld inválida: %s\n", sequencia + 1,
+              leitor.GetErro());
+      RegistraErro(metricas);
+      ok = false;
+      break;
+    }
+
+    tarefa->sequencia = sequencia++;
+    pendentes.Insere(tarefa);
+  }
+
+  total.store(sequencia, std::memory_order_release);
+  for (int k = 0; k < num_trabalhadores; k++) {
+    pendentes.Insere(nullptr);
+  }
+  for (std::thread &trabalhador : trabalhadores) {
+    trabalhador.join();
+  }
+  escritora.join();
+  if (metricas != nullptr) {
+    metricas->DefineFonteFila(nullptr);
+  }
+
+  if (!escritor.Descarrega()) {
+    fprintf(stderr, "Erro ao escrever as soluções\n");
+    ok = false;
+  }
+  return ok && !cancelado;
+}
+
+void ImprimeLatencias(FILE *arquivo, vector<double> &latencias) {
+  fprintf(arquivo, "instâncias: %zu\n", latencias.size());
+  if (latencias.empty()) {
+    return;
+  }
+
+  // Percentis pelo método do posto mais próximo
+  std::sort(latencias.begin(), latencias.end());
+  auto percentil = [&](double p) {
+    size_t posto = static_cast<size_t>(p / 100 * latencias.size() + 0.5);
+    return latencias[std::min(std::max<size_t>(posto, 1), latencias.size()) -
+                     1] *
+           1e6;
+  };
+
+  fprintf(arquivo,
+          "latência (us): p50 %.1f p90 %.1f p99 %.1f p99.9 %.1f máx %.1f\n",
+          percentil(50), percentil(90), percentil(99), percentil(99.9),
+          latencias.back() * 1e6);
+}
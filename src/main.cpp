@@ -1,337 +1,650 @@
-#include <cstdint>
+#include <algorithm>
+#include <chrono>
 #include <cstdio>
-#include <utility>
-#include <vector>
-
-using std::pair;
-using std::vector;
-
-/// @brief Transforma o bit `bit` do número `number` em 1
-/// @param number O número a ser modificado
-/// @param bit O índice (0-based) do bit a ser ativado
-inline void SET_BIT(int &number, int bit) { number |= (1 << bit); }
-
-/// @brief Transforma o bit `bit` do número `number` em 0
-/// @param number O número a ser modificado
-/// @param bit O índice (0-based) do bit a ser desativado
-inline void CLEAR_BIT(int &number, int bit) { number &= (~(1 << bit)); }
-
-/// @brief Retorna o valor do bit `bit` do número `number`
-/// @param number O número de onde o bit será extraído
-/// @param bit O índice (0-based) do bit a ser retornado
-/// @return O valor do bit passado (0 ou 1)
-inline int GET_BIT(int number, int bit) { return (number >> bit) & 0b1; }
-
-/// @brief Reresenta um cristal da caixa.
-struct Cristal {
-  // O brilho do cristal. Um valor de -1 indica que não existe um cristal
-  // naquela posição.
-  int brilho = -1;
-
-  // Armazena as conexões do cristal com os cristais ao seu redor. Os bits 0, 1,
-  // 2 e 3 estarão ativados se o cristal está conectado com o cristal à sua
-  // direita, acima, à sua esquerda e abaixo, respectivamente.
-  int conexoes = 0;
-};
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "binario.hpp"
+#include "cache.hpp"
+#include "cifra.hpp"
+#include "contadores.hpp"
+#include "entrada.hpp"
+#include "escritor.hpp"
+#include "leitor.hpp"
+#include "lote.hpp"
+#include "metricas.hpp"
+#include "processos.hpp"
+#include "rastreio.hpp"
+#include "saida.hpp"
+#include "servidor.hpp"
+#include "topologia.hpp"
+
+/// @brief Número de soluções mantidas em memória pelo cache quando apenas o
+/// armazém em disco é informado.
+const int kCapacidadeCachePadrao = 1024;
+
+/// @brief Número de planos de topologia mantidos em memória quando apenas o
+/// diretório de planos é informado.
+const int kCapacidadePlanosPadrao = 64;
+
+/// @brief Número de vagas da fila em memória compartilhada.
+const int kVagasCompartilhadas = 32;
+
+/// @brief Opções de linha de comando do programa.
+struct Opcoes {
+  // Parâmetros de resolução das caixas.
+  ParametrosResolucao resolucao;
+
+  // Indica que a entrada contém várias instâncias seguidas.
+  bool lote = false;
+
+  // Número de threads que resolvem as instâncias no modo em lote. Um valor de
+  // 0 indica que a leitura, a resolução e a escrita são feitas em sequência.
+  // No modo servidor, 0 indica uma thread por processador.
+  int trabalhadores = 0;
+
+  // Caminho do socket Unix onde o servidor deve ouvir. Um valor de `nullptr`
+  // indica que o programa não deve ser executado como servidor.
+  const char *socket = nullptr;
+
+  // Nome do segmento de memória compartilhada do servidor, ou `nullptr`.
+  const char *memoria_compartilhada = nullptr;
+
+  // Indica que um segmento de memória compartilhada de mesmo nome, deixado
+  // por um servidor interrompido, deve ser removido antes da criação.
+  bool substitui_memoria = false;
+
+  // Tamanho de cada vaga da memória compartilhada, em MiB.
+  int tamanho_vaga = 64;
+
+  // Caminho do arquivo onde as métricas dos modos servidor e lote são
+  // escritas no formato do Prometheus, ou `nullptr`, e o intervalo entre as
+  // escritas, em segundos.
+  const char *metricas = nullptr;
+  double intervalo_metricas = 10;
+
+  // Número de soluções mantidas em memória pelo cache de resultados. Um valor
+  // de 0 indica que o cache só é usado se o armazém for informado.
+  int cache = 0;
+
+  // Caminho do armazém em disco do cache, ou `nullptr`.
+  const char *armazem = nullptr;
+
+  // Número de planos de topologia mantidos em memória pelo cache de planos. Um
+  // valor de 0 indica que o cache só é usado se o diretório for informado.
+  int planos = 0;
+
+  // Caminho do diretório onde os planos de topologia são guardados, ou
+  // `nullptr`.
+  const char *dir_planos = nullptr;
+
+  // Número de processos entre os quais a resolução exata é dividida. Um valor
+  // de 0 indica que a caixa é resolvida no próprio processo.
+  int processos = 0;
+
+  // Indica que a entrada deve apenas ser lida, medindo a vazão da leitura.
+  bool apenas_leitura = false;
+
+  // Número de threads usadas na leitura da entrada no formato texto.
+  int threads_leitura = 1;
+
+  // Caminho de uma solução a ser verificada para a caixa, ou `nullptr`.
+  const char *verificacao = nullptr;
+
+  // Caminho do arquivo binário para onde a caixa deve ser convertida. Um valor
+  // de `nullptr` indica que a caixa deve ser resolvida.
+  const char *conversao = nullptr;
+
+  // Caminho do arquivo onde a solução deve ser escrita no formato binário. Um
+  // valor de `nullptr` indica que a solução deve ser impressa como texto.
+  const char *saida_binaria = nullptr;
+
+  // Indica que as estatísticas da resolução devem ser impressas como JSON na
+  // saída de erro.
+  bool estatisticas = false;
+
+  // Indica que as estatísticas devem incluir os eventos dos contadores de
+  // hardware do processador em cada fase.
+  bool contadores_hardware = false;
+
+  // Caminho do arquivo onde a linha do tempo da execução deve ser escrita, ou
+  // `nullptr` para não rastrear.
+  const char *rastreio = nullptr;
+
+  // Indica que a ajuda foi impressa, e que o programa deve terminar com
+  // sucesso sem fazer mais nada.
+  bool ajuda = false;
 
-/// @brief Representa uma resposta da programação dinâmica para um estado
-/// específico.
-struct Resposta {
-  // Indica se a resposta para o estado correspondente já foi calculada ou não.
-  bool calculado = false;
-
-  // Valor da maior soma de cristais que pôde ser encontrada utilizando o estado
-  // atual. Um valor de -1 indica que
-  // - a configuração da linha é inválida, ou
-  // - a utilizção desta configuração irá levar invariavelmente a um estado
-  // inválido.
-  int valor = -1;
-
-  // Indica qual configuração da linha anterior levou à maior soma encontrada
-  // (armazenada em `valor`)
-  int conf = 0;
+  // Caminho do arquivo de entrada. Um valor de `nullptr` indica a entrada
+  // padrão.
+  const char *entrada = nullptr;
 };
 
-/// @brief Representa e resolve um problema da Cifra Carmesim.
-class Cifra {
- public:
-  /// @brief Constroi um problema da Cifra Carmesim.
-  /// @param l O número de linhas da caixa
-  /// @param c O número de colunas da caixa
-  /// @param n O número de cristais da caixa
-  Cifra(int l, int c, int n)
-      : L_(l), C_(c), N_(n), num_possibilidades_(0b1 << c) {
-    // Inicializa a caixa e a memoização da programação dinâmica para matrizes
-    // vazias
-    caixa_.assign(L_, vector<Cristal>(C_, Cristal()));
-    memo_.assign(L_, vector<vector<Resposta>>(
-                         num_possibilidades_,
-                         vector<Resposta>(num_possibilidades_, Resposta())));
-  }
-
-  /// @brief Adiciona um cristal à caixa na posição (`x`, `y`)
-  /// @param x A linha onde fica o cristal (1-based)
-  /// @param y A coluna onde fica o cristal (1-based)
-  /// @param v O valor de brilho do cristal
-  /// @param d Indica se o cristal está conectado com o cristal à sua direita
-  /// @param c Indica se o cristal está conectado com o cristal acima
-  /// @param e Indica se o cristal está conectado com o cristal à sua esquerda
-  /// @param b Indica se o cristal está conectado com o cristal abaixo
-  /// @attention O par (x, y) significa linha x e coluna y, não são coordenadas
-  /// cartesianas. As coordenadas x e y são iniciadas em 1, não em 0. Os
-  /// indicadores de conexões (d, c, e, b) devem receber apenas valores de 1 (se
-  /// a conexão existe) ou 0 (caso contrário).
-  void AdicionaCristal(int x, int y, int v, int d, int c, int e, int b) {
-    int conexoes = 0;
-    d == 1 ? SET_BIT(conexoes, 0) : CLEAR_BIT(conexoes, 0);
-    c == 1 ? SET_BIT(conexoes, 1) : CLEAR_BIT(conexoes, 1);
-    e == 1 ? SET_BIT(conexoes, 2) : CLEAR_BIT(conexoes, 2);
-    b == 1 ? SET_BIT(conexoes, 3) : CLEAR_BIT(conexoes, 3);
-
-    // As coordenadas passadas são baseadas em 1, então um ajuste é feito ára
-    // caber nas dimensões da matriz
-    caixa_[x - 1][y - 1] = {v, conexoes};
-  }
-
-  /// @brief Resolve o problema da caixa representada. Deve ser chamado apenas
-  /// quando todos os cristais já tiverem sido adicionados, e antes que qualquer
-  /// informação sobre a solução seja consultada.
-  void Resolve() {
-    // Encontra a combinação da linha inicial que retorna a maior soma
-    int conf_inicial_maxima = -1;
-    Resposta maximo = {true, -1, 0};
-    for (int i = 0; i < num_possibilidades_; i++) {
-      Resposta resp = f(L_ - 1, i, i);
-
-      if (resp.valor > maximo.valor) {
-        maximo = resp;
-        conf_inicial_maxima = i;
-      }
-    }
-
-    max_valor_caixa_ = maximo.valor;
+/// @brief Imprime a mensagem de ajuda do programa.
+/// @param programa O nome com o qual o programa foi chamado
+void ImprimeAjuda(const char *programa) {
+  printf(
+      "Uso: %s [opções] [entrada]\n"
+      "\n"
+      "Lê a caixa do arquivo `entrada`, ou da entrada padrão caso ele não\n"
+      "seja informado.\n"
+      "\n"
+      "Opções:\n"
+      "  -h, --ajuda          Mostra esta mensagem\n"
+      "  -f, --feixe B        Resolve de forma aproximada com uma busca em\n"
+      "                       feixe de largura B, imprimindo um limite\n"
+      "                       superior para o ótimo na saída de erro\n"
+      "  -s, --sementes K     Número de configurações da primeira linha\n"
+      "                       testadas pela busca em feixe (padrão: 4)\n"
+      "  --motor NOME         Método da resolução exata: automatico (padrão),\n"
+      "                       memoizacao ou produtos (potências de matrizes\n"
+      "                       de transição entre linhas)\n"
+      "  -p, --processos K    Divide a resolução exata entre K processos,\n"
+      "                       cada um com uma faixa das configurações da\n"
+      "                       costura vertical\n"
+      "  -l, --apenas-leitura Apenas lê a entrada e imprime a vazão da\n"
+      "                       leitura\n"
+      "  -t, --threads-leitura T\n"
+      "                       Lê a entrada no formato texto com T threads,\n"
+      "                       exigindo um cristal por linha (padrão: 1)\n"
+      "  -b, --converte ARQ   Converte a caixa para o formato binário,\n"
+      "                       salvando-a em ARQ, sem resolvê-la\n"
+      "  --lote               Lê várias instâncias seguidas da entrada, cada\n"
+      "                       uma com o seu cabeçalho, e imprime as soluções\n"
+      "                       em ordem, seguidas dos percentis de latência\n"
+      "                       na saída de erro\n"
+      "  -j, --trabalhadores K\n"
+      "                       No modo em lote, lê, resolve (com K threads) e\n"
+      "                       escreve as instâncias em uma esteira paralela.\n"
+      "                       No modo servidor, usa K trabalhadores\n"
+      "  --servidor SOCKET    Executa como um serviço persistente, atendendo\n"
+      "                       requisições pelo socket Unix SOCKET até receber\n"
+      "                       SIGINT ou SIGTERM\n"
+      "  --memoria-compartilhada NOME\n"
+      "                       Executa como um serviço persistente para\n"
+      "                       clientes na mesma máquina, que submetem caixas\n"
+      "                       pela fila no segmento de memória compartilhada\n"
+      "                       NOME\n"
+      "  --substitui-memoria  Remove antes o segmento NOME, se ele tiver\n"
+      "                       ficado de um servidor interrompido\n"
+      "  --tamanho-vaga MIB   Tamanho de cada vaga da memória compartilhada\n"
+      "                       (padrão: 64)\n"
+      "  --metricas ARQ       Nos modos servidor e lote, escreve em ARQ, no\n"
+      "                       formato texto do Prometheus, as resoluções\n"
+      "                       por método, a latência, a fila, o cache, o\n"
+      "                       pico de memória e o tamanho das caixas\n"
+      "  --intervalo-metricas S\n"
+      "                       Reescreve as métricas a cada S segundos, além\n"
+      "                       do fim da execução (padrão: 10)\n"
+      "  --cache N            Consulta um cache de soluções, endereçado pelo\n"
+      "                       conteúdo da caixa, antes de resolvê-la,\n"
+      "                       mantendo até N soluções em memória\n"
+      "  --armazem ARQ        Guarda as soluções do cache no arquivo ARQ, que\n"
+      "                       persiste entre execuções\n"
+      "  --planos N           Compartilha os planos de topologia da resolução\n"
+      "                       exata (as estruturas que dependem apenas dos\n"
+      "                       cristais e das conexões) entre caixas com a\n"
+      "                       mesma topologia, mantendo até N em memória\n"
+      "  --dir-planos DIR     Guarda os planos de topologia no diretório DIR,\n"
+      "                       um arquivo por topologia, que persistem entre\n"
+      "                       execuções\n"
+      "  -v, --verifica ARQ   Verifica se a solução em ARQ (no formato texto\n"
+      "                       ou binário) é válida para a caixa, sem\n"
+      "                       resolvê-la\n"
+      "  -o, --saida-binaria ARQ\n"
+      "                       Escreve a solução em ARQ no formato binário\n"
+      "                       (cabeçalho e uma máscara de bits por linha)\n"
+      "  --stats              Imprime na saída de erro, em JSON, os\n"
+      "                       contadores da resolução (estados, acertos da\n"
+      "                       memoização, verificações, costuras, memória)\n"
+      "                       e o tempo de cada fase. Não vale nos modos\n"
+      "                       lote e servidor\n"
+      "  --stats-hw           Como --stats, incluindo ciclos, instruções,\n"
+      "                       faltas de LLC e de dTLB e desvios errados de\n"
+      "                       cada fase, lidos com perf_event_open, e o IPC\n"
+      "                       e os eventos por estado da resolução\n"
+      "  --trace ARQ          Escreve em ARQ a linha do tempo da execução,\n"
+      "                       por thread (fases, costuras, blocos de\n"
+      "                       linhas, instâncias do lote), no formato de\n"
+      "                       trace do Chrome, aberto pelo Perfetto\n"
+      "\n"
+      "A entrada pode estar no formato texto (L C N seguido de N linhas\n"
+      "x y v d c e b), no formato denso (DENSA L C seguido de L linhas de C\n"
+      "brilhos e L linhas de C dígitos d + 2c) ou no formato binário, lido\n"
+      "sem cópias. O formato é detectado automaticamente.\n",
+      programa);
+}
 
-    // Percorre a tabela encontrando a combinação ótima para cada linha
-    int conf = conf_inicial_maxima;
-    for (int i = L_ - 1; i >= 0; i--) {
-      for (int j = C_ - 1; j >= 0; j--) {
-        if (GET_BIT(conf, j) == 1) {
-          num_cristais_usados_++;
-          cristais_solucao_.push_back({i + 1, j + 1});
-        }
+/// @brief Lê as opções de linha de comando.
+/// @param argc O número de argumentos
+/// @param argv Os argumentos
+/// @param opcoes Recebe as opções lidas
+/// @return `true` se as opções são válidas e o programa deve continuar,
+/// `false` caso contrário. Quando a ajuda é pedida, retorna `false` com
+/// `opcoes.ajuda` marcada.
+bool LeOpcoes(int argc, char **argv, Opcoes &opcoes) {
+  for (int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    bool tem_valor = i + 1 < argc;
+
+    if (strcmp(arg, "-h") == 0 || strcmp(arg, "--ajuda") == 0) {
+      ImprimeAjuda(argv[0]);
+      opcoes.ajuda = true;
+      return false;
+    } else if ((strcmp(arg, "-f") == 0 || strcmp(arg, "--feixe") == 0) &&
+               tem_valor) {
+      opcoes.resolucao.largura_feixe = atoi(argv[++i]);
+      if (opcoes.resolucao.largura_feixe <= 0) {
+        fprintf(stderr, "A largura do feixe deve ser positiva\n");
+        return false;
       }
-
-      conf = memo_[(i + L_) % L_][conf][conf_inicial_maxima].conf;
+    } else if ((strcmp(arg, "-s") == 0 || strcmp(arg, "--sementes") == 0) &&
+               tem_valor) {
+      opcoes.resolucao.sementes_feixe = atoi(argv[++i]);
+      if (opcoes.resolucao.sementes_feixe <= 0) {
+        fprintf(stderr, "O número de sementes deve ser positivo\n");
+        return false;
+      }
+    } else if (strcmp(arg, "--motor") == 0 && tem_valor) {
+      const char *nome = argv[++i];
+      if (strcmp(nome, "automatico") == 0) {
+        opcoes.resolucao.motor = kMotorAutomatico;
+      } else if (strcmp(nome, "memoizacao") == 0) {
+        opcoes.resolucao.motor = kMotorMemoizacao;
+      } else if (strcmp(nome, "produtos") == 0) {
+        opcoes.resolucao.motor = kMotorProdutos;
+      } else {
+        fprintf(stderr, "Motor desconhecido: %s\n", nome);
+        return false;
+      }
+    } else if ((strcmp(arg, "-t") == 0 ||
+                strcmp(arg, "--threads-leitura") == 0) &&
+               tem_valor) {
+      opcoes.threads_leitura = atoi(argv[++i]);
+      if (opcoes.threads_leitura <= 0) {
+        fprintf(stderr, "O número de threads deve ser positivo\n");
+        return false;
+      }
+    } else if (strcmp(arg, "--lote") == 0) {
+      opcoes.lote = true;
+    } else if (strcmp(arg, "--servidor") == 0 && tem_valor) {
+      opcoes.socket = argv[++i];
+    } else if ((strcmp(arg, "-p") == 0 || strcmp(arg, "--processos") == 0) &&
+               tem_valor) {
+      opcoes.processos = atoi(argv[++i]);
+      if (opcoes.processos < 0) {
+        fprintf(stderr, "O número de processos não pode ser negativo\n");
+        return false;
+      }
+    } else if (strcmp(arg, "--cache") == 0 && tem_valor) {
+      opcoes.cache = atoi(argv[++i]);
+      if (opcoes.cache < 0) {
+        fprintf(stderr, "O tamanho do cache não pode ser negativo\n");
+        return false;
+      }
+    } else if (strcmp(arg, "--armazem") == 0 && tem_valor) {
+      opcoes.armazem = argv[++i];
+    } else if (strcmp(arg, "--planos") == 0 && tem_valor) {
+      opcoes.planos = atoi(argv[++i]);
+      if (opcoes.planos < 0) {
+        fprintf(stderr, "O número de planos não pode ser negativo\n");
+        return false;
+      }
+    } else if (strcmp(arg, "--dir-planos") == 0 && tem_valor) {
+      opcoes.dir_planos = argv[++i];
+    } else if (strcmp(arg, "--memoria-compartilhada") == 0 && tem_valor) {
+      opcoes.memoria_compartilhada = argv[++i];
+    } else if (strcmp(arg, "--substitui-memoria") == 0) {
+      opcoes.substitui_memoria = true;
+    } else if (strcmp(arg, "--tamanho-vaga") == 0 && tem_valor) {
+      opcoes.tamanho_vaga = atoi(argv[++i]);
+      if (opcoes.tamanho_vaga < 1) {
+        fprintf(stderr, "O tamanho da vaga deve ser positivo\n");
+        return false;
+      }
+    } else if ((strcmp(arg, "-j") == 0 ||
+                strcmp(arg, "--trabalhadores") == 0) &&
+               tem_valor) {
+      opcoes.trabalhadores = atoi(argv[++i]);
+      if (opcoes.trabalhadores < 0) {
+        fprintf(stderr, "O número de trabalhadores não pode ser negativo\n");
+        return false;
+      }
+    } else if (strcmp(arg, "-l") == 0 ||
+               strcmp(arg, "--apenas-leitura") == 0) {
+      opcoes.apenas_leitura = true;
+    } else if ((strcmp(arg, "-b") == 0 || strcmp(arg, "--converte") == 0) &&
+               tem_valor) {
+      opcoes.conversao = argv[++i];
+    } else if ((strcmp(arg, "-v") == 0 || strcmp(arg, "--verifica") == 0) &&
+               tem_valor) {
+      opcoes.verificacao = argv[++i];
+    } else if ((strcmp(arg, "-o") == 0 ||
+                strcmp(arg, "--saida-binaria") == 0) &&
+               tem_valor) {
+      opcoes.saida_binaria = argv[++i];
+    } else if (strcmp(arg, "--stats") == 0) {
+      opcoes.estatisticas = true;
+    } else if (strcmp(arg, "--stats-hw") == 0) {
+      opcoes.estatisticas = true;
+      opcoes.contadores_hardware = true;
+    } else if (strcmp(arg, "--metricas") == 0 && tem_valor) {
+      opcoes.metricas = argv[++i];
+    } else if (strcmp(arg, "--intervalo-metricas") == 0 && tem_valor) {
+      opcoes.intervalo_metricas = atof(argv[++i]);
+      if (opcoes.intervalo_metricas <= 0) {
+        fprintf(stderr, "O intervalo das métricas deve ser positivo\n");
+        return false;
+      }
+    } else if (strcmp(arg, "--trace") == 0 && tem_valor) {
+      opcoes.rastreio = argv[++i];
+    } else if (arg[0] != '-' && opcoes.entrada == nullptr) {
+      opcoes.entrada = arg;
+    } else {
+      fprintf(stderr, "Opção inválida: %s\n", arg);
+      ImprimeAjuda(argv[0]);
+      return false;
     }
   }
 
-  /// @brief Retorna o número de cristais usados na solução e a soma de seus
-  /// brilhos.
-  /// @return Um par de `int`s onde o primeiro é o número de cristais usados e o
-  /// segundo é soma dos seus brilhos
-  pair<int, int> GetValoresSolucao() {
-    return {num_cristais_usados_, max_valor_caixa_};
+  // As estatísticas descrevem a resolução de uma única caixa
+  if (opcoes.estatisticas &&
+      (opcoes.lote || opcoes.socket != nullptr ||
+       opcoes.memoria_compartilhada != nullptr)) {
+    fprintf(stderr,
+            "--stats e --stats-hw não valem nos modos lote e servidor; use "
+            "--metricas\n");
+    return false;
   }
 
-  /// @brief Retorna uma lista dos cristais usados na solução
-  /// @return Um vector de pares (x, y) representando a posição de cada cristal
-  /// utilizado
-  vector<pair<int, int>> &GetCristaisSolucao() { return cristais_solucao_; }
-
- private:
-  int L_ = 0, C_ = 0, N_ = 0;
+  return true;
+}
 
-  /// @brief Número de configurações possíveis que uma linha da caixa pode
-  /// assumir (2**C_).
-  int num_possibilidades_ = 0;
+/// @brief Lê a entrada inteira sem resolver a caixa, e imprime a vazão da
+/// leitura. Serve como referência de desempenho do leitor.
+/// @param leitor O leitor com a entrada já aberta
+/// @param opcoes As opções do programa
+/// @return O código de saída do programa
+int MedeLeitura(Leitor &leitor, const Opcoes &opcoes) {
+  // No formato binário, a leitura valida o cabeçalho, percorre os brilhos uma
+  // vez e associa a caixa ao buffer, sem copiá-lo
+  auto inicio = std::chrono::steady_clock::now();
+  Cifra cifra;
+  if (!LeCaixa(leitor, cifra, opcoes.threads_leitura)) {
+    fprintf(stderr, "Entrada inválida: %s\n", leitor.GetErro());
+    return 1;
+  }
 
-  /// @brief Número de cristais utilizados na solução
-  int num_cristais_usados_ = 0;
+  double segundos = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - inicio)
+                        .count();
+  double megabytes = leitor.GetTamanho() / 1e6;
+  printf("bytes: %zu\ncristais: %d\nthreads: %d\nsegundos: %.6f\nMB/s: %.1f\n",
+         leitor.GetTamanho(), cifra.GetNumCristais(), opcoes.threads_leitura,
+         segundos, segundos > 0 ? megabytes / segundos : 0.0);
 
-  /// @brief Valor da solução ótima da caixa.
-  int max_valor_caixa_ = 0;
+  return 0;
+}
 
-  /// @brief Lista de cristais utilizados na solução
-  vector<pair<int, int>> cristais_solucao_;
+/// @brief Verifica uma solução lida de um arquivo, imprimindo o resultado.
+/// @param cifra O problema, com a caixa já lida
+/// @param caminho O caminho da solução
+/// @return O código de saída do programa: 0 se a solução é válida
+int VerificaSolucao(Cifra &cifra, const char *caminho) {
+  Leitor leitor;
+  Solucao solucao;
+  if (!leitor.Abre(caminho) ||
+      !LeSolucao(leitor, cifra.GetCaixa(), solucao)) {
+    fprintf(stderr, "Solução inválida: %s\n", leitor.GetErro());
+    return 1;
+  }
 
-  /// @brief Matriz `L_`x`C_` dos cristais do problema
-  vector<vector<Cristal>> caixa_;
+  int indice;
+  const char *erro = cifra.Verifica(solucao, indice);
+  if (erro != nullptr && indice >= 0) {
+    fprintf(stderr, "Solução inválida: cristal (%d, %d): %s\n",
+            solucao.cristais[indice].first, solucao.cristais[indice].second,
+            erro);
+    return 1;
+  }
+  if (erro != nullptr) {
+    fprintf(stderr, "Solução inválida: %s\n", erro);
+    return 1;
+  }
 
-  /// @brief Matriz `L_`x`num_possibiliddes_`x`num_possibiliddes_` de memoização
-  /// da função de programação dinâmica
-  vector<vector<vector<Resposta>>> memo_;
+  printf("Solução válida: %d cristais, soma %lld\n", solucao.num_cristais,
+         solucao.soma);
+  return 0;
+}
 
-  /// @brief Programação dinâmica que encontra a maior soma de cristais da
-  /// caixa, dado uma configuração inicial e uma configuração de linha.
-  /// @param linha O índice da linha atual da caixa
-  /// @param conf A configuração da linha atual da caixa
-  /// @param conf_inicial A configuração utilizada na última linha da caixa
-  /// neste ramo da árvore de recursão
-  /// @return Uma `Resposta` onde `valor` é o maior valor encontrado e `conf` é
-  /// a configuração que foi utilizada na linha acima para encontrar este
-  /// máximo.
-  Resposta f(int linha, int conf, int conf_inicial) {
-    // Verifica memoiização
-    if (memo_[linha][conf][conf_inicial].calculado) {
-      return memo_[linha][conf][conf_inicial];
+/// @brief Executa o programa com as opções já lidas.
+/// @return O código de saída do programa
+int Executa(Opcoes &opcoes) {
+  int trabalhadores = opcoes.trabalhadores > 0
+                          ? opcoes.trabalhadores
+                          : std::max(1u, std::thread::hardware_concurrency());
+  std::unique_ptr<CacheResultados> cache;
+  if (opcoes.cache > 0 || opcoes.armazem != nullptr) {
+    cache.reset(new CacheResultados(
+        opcoes.cache > 0 ? opcoes.cache : kCapacidadeCachePadrao));
+    const char *erro = opcoes.armazem != nullptr
+                           ? cache->AbreArmazem(opcoes.armazem)
+                           : nullptr;
+    if (erro != nullptr) {
+      fprintf(stderr, "%s: %s\n", opcoes.armazem, erro);
+      return 1;
     }
+  }
 
-    // Checa se a configuração é consistente
-    if (!EhInternamenteConsistente(linha, conf)) {
-      memo_[linha][conf][conf_inicial] = {true, -1, 0};
-      return memo_[linha][conf][conf_inicial];
+  std::unique_ptr<CachePlanos> planos;
+  if (opcoes.planos > 0 || opcoes.dir_planos != nullptr) {
+    planos.reset(new CachePlanos(
+        opcoes.planos > 0 ? opcoes.planos : kCapacidadePlanosPadrao));
+    const char *erro = opcoes.dir_planos != nullptr
+                           ? planos->AbreDiretorio(opcoes.dir_planos)
+                           : nullptr;
+    if (erro != nullptr) {
+      fprintf(stderr, "%s: %s\n", opcoes.dir_planos, erro);
+      return 1;
     }
+    opcoes.resolucao.planos = planos.get();
+  }
 
-    // Soma o valor dos cristais da linha atual
-    int valor_linha = 0;
-    for (int j = 0; j < C_; j++) {
-      if (GET_BIT(conf, j) == 1) {
-        valor_linha += caixa_[linha][j].brilho;
-      }
+  if (opcoes.socket != nullptr || opcoes.memoria_compartilhada != nullptr) {
+    int codigo =
+        opcoes.socket != nullptr
+            ? ExecutaServidor(opcoes.socket, opcoes.resolucao, cache.get(),
+                              trabalhadores)
+            : ExecutaServidorCompartilhado(
+                  opcoes.memoria_compartilhada, opcoes.resolucao, cache.get(),
+                  trabalhadores, kVagasCompartilhadas,
+                  (size_t)opcoes.tamanho_vaga << 20,
+                  opcoes.substitui_memoria);
+    if (planos != nullptr) {
+      planos->ImprimeEstatisticas(stderr);
     }
+    return codigo;
+  }
 
-    // Caso base
-    if (linha == 0) {
-      // Verifica se a configuração atual e a configuração da última linha da
-      // caixa são compatíveis
-      if (!SaoCompativeis(linha, conf, conf_inicial)) {
-        memo_[linha][conf][conf_inicial] = {true, -1, 0};
-        return memo_[linha][conf][conf_inicial];
-      }
+  Leitor leitor;
+  if (!leitor.Abre(opcoes.entrada)) {
+    fprintf(stderr, "%s\n", leitor.GetErro());
+    return 1;
+  }
 
-      // Dado que as linhas são compatíveis, retorna o valor da linha atual
-      memo_[linha][conf][conf_inicial] = {true, valor_linha, conf_inicial};
-      return memo_[linha][conf][conf_inicial];
+  if (opcoes.apenas_leitura) {
+    return MedeLeitura(leitor, opcoes);
+  }
+
+  if (opcoes.lote) {
+    Escritor escritor;
+    vector<double> latencias;
+    bool ok = opcoes.trabalhadores > 0
+                  ? ResolveLoteParalelo(leitor, opcoes.resolucao, cache.get(),
+                                        opcoes.trabalhadores, escritor,
+                                        latencias)
+                  : ResolveLote(leitor, opcoes.resolucao, cache.get(),
+                                escritor, latencias);
+    ok = escritor.Descarrega() && ok;
+    ImprimeLatencias(stderr, latencias);
+    if (cache != nullptr) {
+      cache->ImprimeEstatisticas(stderr);
+    }
+    if (planos != nullptr) {
+      planos->ImprimeEstatisticas(stderr);
     }
+    return ok ? 0 : 1;
+  }
 
-    // Inicia o máximo como uma resposta inválida, pois se nenhuma possibilidade
-    // para a linha acima retornou uma resposta válida, a configuração conf
-    // para a linha atual também é inválida
-    Resposta maximo = {true, -1, 0};
+  // Os contadores de hardware são abertos antes da leitura, para que as
+  // threads de leitura e os processos da resolução também sejam contados.
+  // Sem contadores disponíveis, os eventos são omitidos com o motivo.
+  ContadoresHardware contadores;
+  if (opcoes.contadores_hardware) {
+    contadores.Abre();
+    AtivaContadoresHardware(&contadores);
+  }
 
-    // Testa com todas as combinações da linha acima
-    for (int poss = 0; poss < num_possibilidades_; poss++) {
-      // Verifica se a linha atual e a linha acima são compatíveis
-      if (!SaoCompativeis(linha, conf, poss)) {
-        continue;
-      }
+  // Leitura dos dados do problema. As fases de fora da resolução são medidas
+  // aqui, e as demais pela própria `Cifra`.
+  Cifra cifra;
+  TemposFases tempos;
+  bool lida;
+  {
+    CronometroFase cronometro(tempos, kFaseLeitura);
+    lida = LeCaixa(leitor, cifra, opcoes.threads_leitura);
+  }
+  if (!lida) {
+    fprintf(stderr, "Entrada inválida: %s\n", leitor.GetErro());
+    return 1;
+  }
 
-      // Faz a chamada recursiva da PD
-      Resposta resp = f(linha - 1, poss, conf_inicial);
+  if (opcoes.conversao != nullptr) {
+    if (!EscreveBinario(opcoes.conversao, cifra.GetCaixa(),
+                        cifra.GetNumCristais())) {
+      fprintf(stderr, "Não foi possível escrever %s\n", opcoes.conversao);
+      return 1;
+    }
+    return 0;
+  }
 
-      // Se utilizar a possibilidade atual gerou um resultado inválido, pule
-      if (resp.valor == -1) {
-        continue;
-      }
+  if (opcoes.verificacao != nullptr) {
+    return VerificaSolucao(cifra, opcoes.verificacao);
+  }
 
-      // Encontrou um novo resultado melhor utilizando a possibilidade atual
-      if (resp.valor + valor_linha > maximo.valor) {
-        maximo = {true, resp.valor + valor_linha, poss};
-      }
-    }
+  const char *erro = cifra.ValidaParametros(opcoes.resolucao);
+  if (erro != nullptr) {
+    fprintf(stderr, "Não é possível resolver a caixa: %s\n", erro);
+    return 1;
+  }
 
-    // Memoiza e retorna
-    memo_[linha][conf][conf_inicial] = maximo;
-    return maximo;
-  }
-
-  /// @brief Verifica se a configuração `conf` não quebra nenhuma restrição para
-  /// a linha `linha`
-  /// @param linha O índice linha da caixa a ser verificada
-  /// @param conf A configuração de cristais ativados a ser testada para a linha
-  /// dada
-  /// @return `true` se a configuração é valida, `false` caso contrário.
-  inline bool EhInternamenteConsistente(int linha, int conf) {
-    for (int j = 0; j < C_; j++) {
-      // A posição atual está ativada mas não possui um cristal
-      if (GET_BIT(conf, j) == 1 && caixa_[linha][j].brilho == -1) {
-        return false;
-      }
+  // Resolve o problema utilizando programação dinâmica, ou de forma aproximada
+  // caso a busca em feixe tenha sido pedida, a menos que a solução esteja no
+  // cache
+  ChaveCaixa chave;
+  TransformacaoToroidal transformacao;
+  bool em_cache = false;
+  if (cache != nullptr) {
+    chave = CalculaChaveCanonica(cifra.GetCaixa(), opcoes.resolucao,
+                                 transformacao);
+    em_cache = cache->Busca(chave, transformacao, cifra);
+  }
 
-      if (GET_BIT(conf, j) == 1 &&             // Posição atual está ativada
-          GET_BIT(conf, (j + 1) % C_) == 1 &&  // Posição à direita está ativada
-          GET_BIT(caixa_[linha][j].conexoes, 0) == 1  // Posições são conectadas
-      ) {
-        return false;
-      }
+  if (!em_cache && opcoes.processos > 0) {
+    erro = "a divisão em processos só vale para a resolução exata";
+    if (opcoes.resolucao.largura_feixe == 0) {
+      // Os processos herdam o plano preparado antes da divisão. A resolução
+      // é medida aqui, pois as faixas são resolvidas nos processos filhos.
+      cifra.PreparaPlano(planos.get());
+      CronometroFase cronometro(tempos, kFaseResolucao);
+      erro = ResolveEmProcessos(cifra, opcoes.processos);
     }
-
-    return true;
-  }
-
-  /// @brief Verifica se a configuração `conf_i` para a linha `linha` da caixa
-  /// não quebra nenhuma restrição se utilizada com a configuração `conf_s` para
-  /// a linha acima.
-  /// @param linha O índice da linha superior do par de linhas adjacentes a ser
-  /// verificado
-  /// @param conf_i A configuração da linha inferior do par a ser verificado
-  /// @param conf_s A configuração da linha superior do par a ser verificado
-  /// @return `true` se as configurações são compatíveis, `false` caso
-  /// contrário.
-  inline bool SaoCompativeis(int linha, int conf_i, int conf_s) {
-    for (int j = 0; j < C_; j++) {
-      if (GET_BIT(conf_i, j) == 1 &&  // Cristal da linha inferior está ativado
-          GET_BIT(conf_s, j) == 1 &&  // Cristal da linha superior está ativado
-          GET_BIT(caixa_[linha][j].conexoes, 1)  // Cristais estão conectados
-      ) {
-        return false;
-      }
+    if (erro != nullptr) {
+      fprintf(stderr, "Não foi possível resolver a caixa: %s\n", erro);
+      return 1;
     }
+  } else if (!em_cache) {
+    cifra.Resolve(opcoes.resolucao);
+  }
 
-    return true;
+  if (cache != nullptr) {
+    if (!em_cache) {
+      cache->Guarda(chave, transformacao, cifra);
+    }
+    cache->ImprimeEstatisticas(stderr);
+  }
+  if (planos != nullptr) {
+    planos->ImprimeEstatisticas(stderr);
+  }
+  if (opcoes.resolucao.largura_feixe > 0) {
+    fprintf(stderr, "Limite superior: %d\n", cifra.GetLimiteSuperior());
   }
 
-  /// @brief Função de depuração que imprime o conteúdo da caixa
-  void DumpCaixa() {
-    for (int i = 0; i < L_; i++) {
-      for (int j = 0; j < C_; j++) {
-        printf("%3d ", caixa_[i][j].brilho);
-      }
-      printf("\n");
+  // Imprime a solução do problema
+  bool escrita;
+  {
+    CronometroFase cronometro(tempos, kFaseSaida);
+    if (opcoes.saida_binaria != nullptr) {
+      escrita = EscreveSolucaoBinaria(opcoes.saida_binaria, cifra);
+    } else {
+      Escritor escritor;
+      EscreveSolucaoTexto(escritor, cifra);
+      escrita = escritor.Descarrega();
     }
   }
 
-  /// @brief Função de depuração que imprime o conteúdo da matriz de memoização.
-  void DumpMemo() {
-    for (int k = 0; k < num_possibilidades_; k++) {
-      printf("Configuração Inicial: %d\n", k);
+  if (opcoes.estatisticas) {
+    tempos.Acumula(cifra.GetTempos());
+    EscreveEstatisticasJson(stderr, cifra.GetEstatisticas(), tempos,
+                            em_cache,
+                            opcoes.contadores_hardware ? &contadores
+                                                       : nullptr);
+  }
 
-      for (int i = 0; i < L_; i++) {
-        printf("\t");
-        for (int j = 0; j < num_possibilidades_; j++) {
-          printf("(%3d %3d %3d) ", memo_[i][j][k].calculado,
-                 memo_[i][j][k].valor, memo_[i][j][k].conf);
-        }
-        printf("\n");
-      }
-      printf("\n");
-    }
+  if (!escrita && opcoes.saida_binaria != nullptr) {
+    fprintf(stderr, "Não foi possível escrever %s\n", opcoes.saida_binaria);
+    return 1;
   }
-};
+  if (!escrita) {
+    fprintf(stderr, "Erro ao escrever a solução\n");
+    return 1;
+  }
+
+  return 0;
+}
 
-int main() {
-  // Leitura dos dados do problema
-  int L, C, N;
-  scanf("%d %d %d", &L, &C, &N);
-  Cifra cifra(L, C, N);
+int main(int argc, char **argv) {
+  Opcoes opcoes;
+  if (!LeOpcoes(argc, argv, opcoes)) {
+    return opcoes.ajuda ? 0 : 1;
+  }
 
-  int x, y, v, d, c, e, b;
-  for (int i = 0; i < N; i++) {
-    scanf("%d %d %d %d %d %d %d", &x, &y, &v, &d, &c, &e, &b);
-    cifra.AdicionaCristal(x, y, v, d, c, e, b);
+  if (opcoes.rastreio != nullptr) {
+    IniciaRastreio();
+    NomeiaThreadRastreio("principal", -1);
   }
 
-  // Resolve o problema utilizando programação dinâmica
-  cifra.Resolve();
+  // As métricas são exportadas por uma thread própria, que as reescreve
+  // periodicamente enquanto o serviço ou o lote executa
+  Metricas metricas;
+  if (opcoes.metricas != nullptr) {
+    AtivaMetricas(&metricas);
+    metricas.IniciaExportacao(opcoes.metricas, opcoes.intervalo_metricas);
+  }
 
-  // Imprime a solução do problema
-  pair<int, int> valores_solucao = cifra.GetValoresSolucao();
-  printf("%d %d\n", valores_solucao.first, valores_solucao.second);
+  int codigo = Executa(opcoes);
 
-  vector<pair<int, int>> &cristais_solucao = cifra.GetCristaisSolucao();
-  for (pair<int, int> cristal : cristais_solucao) {
-    printf("%d %d\n", cristal.first, cristal.second);
+  if (opcoes.metricas != nullptr && !metricas.EncerraExportacao()) {
+    fprintf(stderr, "Não foi possível escrever %s\n", opcoes.metricas);
+    codigo = 1;
   }
 
-  return 0;
+  // As threads de todos os modos já terminaram aqui
+  if (opcoes.rastreio != nullptr && !EscreveRastreio(opcoes.rastreio)) {
+    fprintf(stderr, "Não foi possível escrever %s\n", opcoes.rastreio);
+    return 1;
+  }
+  return codigo;
 }
@@ -0,0 +1,289 @@
+#include "metricas.hpp"
+
+#include <signal.h>
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+static Metricas *metricas_ativas = nullptr;
+
+// Fatia de cada thread, distribuída em rodízio na primeira vez que a thread
+// registra uma métrica.
+static std::atomic<int> proxima_fatia(0);
+static thread_local int fatia_thread = -1;
+
+/// @brief Retorna a faixa de latência de um valor em nanossegundos.
+static int FaixaLatencia(uint64_t ns) {
+  if (ns < (uint64_t(1) << kExpoenteMinimoLatencia)) {
+    return 0;
+  }
+  int expoente = 63 - __builtin_clzll(ns);
+  if (expoente > kExpoenteMaximoLatencia) {
+    return kNumFaixasLatencia - 1;
+  }
+  int subfaixa = (ns >> (expoente - 2)) & (kSubfaixasLatencia - 1);
+  return 1 + (expoente - kExpoenteMinimoLatencia) * kSubfaixasLatencia +
+         subfaixa;
+}
+
+/// @brief Retorna o limite superior de uma faixa de latência, em segundos.
+static double LimiteFaixaLatencia(int faixa) {
+  if (faixa == 0) {
+    return (double)(uint64_t(1) << kExpoenteMinimoLatencia) / 1e9;
+  }
+  int expoente = kExpoenteMinimoLatencia + (faixa - 1) / kSubfaixasLatencia;
+  int subfaixa = (faixa - 1) % kSubfaixasLatencia;
+  double base = (double)(uint64_t(1) << expoente);
+  return (base + (subfaixa + 1) * base / kSubfaixasLatencia) / 1e9;
+}
+
+/// @brief Registra um tamanho na faixa da menor potência de 2 que não é menor
+/// que ele.
+static void RegistraTamanho(HistogramaTamanho &histograma, uint64_t valor) {
+  int faixa = 0;
+  if (valor > 1) {
+    faixa = std::min(64 - __builtin_clzll(valor - 1), kNumFaixasTamanho - 1);
+  }
+  histograma.faixas[faixa].fetch_add(1, std::memory_order_relaxed);
+  histograma.soma.fetch_add(valor, std::memory_order_relaxed);
+}
+
+FatiaMetricas &Metricas::Fatia() {
+  if (fatia_thread < 0) {
+    fatia_thread = proxima_fatia.fetch_add(1, std::memory_order_relaxed) %
+                   kNumFatiasMetricas;
+  }
+  return fatias_[fatia_thread];
+}
+
+void Metricas::RegistraResolucao(Cifra &cifra, bool com_cache,
+                                 bool em_cache) {
+  FatiaMetricas &fatia = Fatia();
+  const Caixa &caixa = cifra.GetCaixa();
+  MetodoResolucao metodo =
+      em_cache ? kMetodoNenhum : cifra.GetEstatisticas().metodo;
+  fatia.resolucoes[metodo].fetch_add(1, std::memory_order_relaxed);
+  if (com_cache) {
+    (em_cache ? fatia.acertos_cache : fatia.faltas_cache)
+        .fetch_add(1, std::memory_order_relaxed);
+  }
+  RegistraTamanho(fatia.linhas, caixa.GetL());
+  RegistraTamanho(fatia.colunas, caixa.GetC());
+  RegistraTamanho(fatia.cristais, cifra.GetNumCristais());
+}
+
+void Metricas::RegistraErro() {
+  Fatia().erros.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metricas::RegistraLatencia(double segundos) {
+  FatiaMetricas &fatia = Fatia();
+  uint64_t ns = segundos > 0 ? (uint64_t)(segundos * 1e9) : 0;
+  fatia.latencias[FaixaLatencia(ns)].fetch_add(1, std::memory_order_relaxed);
+  fatia.soma_latencias_ns.fetch_add(ns, std::memory_order_relaxed);
+}
+
+void Metricas::DefineFonteFila(std::function<long long()> fonte) {
+  std::lock_guard<std::mutex> guarda(trava_fonte_);
+  fonte_fila_ = fonte;
+}
+
+/// @brief Soma um contador de todas as fatias.
+template <typename Campo>
+static uint64_t Soma(const FatiaMetricas *fatias, Campo campo) {
+  uint64_t soma = 0;
+  for (int f = 0; f < kNumFatiasMetricas; f++) {
+    soma += campo(fatias[f]).load(std::memory_order_relaxed);
+  }
+  return soma;
+}
+
+/// @brief Imprime um histograma de tamanhos, com faixas cumulativas.
+static void ImprimeHistogramaTamanho(
+    FILE *arquivo, const char *nome, const char *ajuda,
+    const FatiaMetricas *fatias,
+    const HistogramaTamanho &(*histograma)(const FatiaMetricas &)) {
+  fprintf(arquivo, "# HELP %s %s\n# TYPE %s histogram\n", nome, ajuda, nome);
+  uint64_t acumulado = 0, soma = 0;
+  for (int f = 0; f < kNumFatiasMetricas; f++) {
+    soma += histograma(fatias[f]).soma.load(std::memory_order_relaxed);
+  }
+  for (int faixa = 0; faixa < kNumFaixasTamanho; faixa++) {
+    for (int f = 0; f < kNumFatiasMetricas; f++) {
+      acumulado +=
+          histograma(fatias[f]).faixas[faixa].load(std::memory_order_relaxed);
+    }
+    if (faixa < kNumFaixasTamanho - 1) {
+      fprintf(arquivo, "%s_bucket{le=\"%llu\"} %llu\n", nome,
+              1ULL << faixa, (unsigned long long)acumulado);
+    }
+  }
+  fprintf(arquivo, "%s_bucket{le=\"+Inf\"} %llu\n", nome,
+          (unsigned long long)acumulado);
+  fprintf(arquivo, "%s_sum %llu\n%s_count %llu\n", nome,
+          (unsigned long long)soma, nome, (unsigned long long)acumulado);
+}
+
+void Metricas::Imprime(FILE *arquivo) {
+  typedef unsigned long long ull;
+
+  fprintf(arquivo,
+          "# HELP cifra_resolucoes_total Caixas resolvidas, por método "
+          "(cache para as soluções vindas do cache).\n"
+          "# TYPE cifra_resolucoes_total counter\n");
+  for (int metodo = 0; metodo < kNumMetodos; metodo++) {
+    uint64_t total = Soma(fatias_, [&](const FatiaMetricas &fatia) -> auto & {
+      return fatia.resolucoes[metodo];
+    });
+    fprintf(arquivo, "cifra_resolucoes_total{metodo=\"%s\"} %llu\n",
+            metodo == kMetodoNenhum ? "cache"
+                                    : NomeMetodo((MetodoResolucao)metodo),
+            (ull)total);
+  }
+
+  uint64_t erros = Soma(fatias_, [](const FatiaMetricas &fatia) -> auto & {
+    return fatia.erros;
+  });
+  fprintf(arquivo,
+          "# HELP cifra_erros_total Instâncias ou requisições não "
+          "resolvidas.\n"
+          "# TYPE cifra_erros_total counter\n"
+          "cifra_erros_total %llu\n",
+          (ull)erros);
+
+  uint64_t acertos = Soma(fatias_, [](const FatiaMetricas &fatia) -> auto & {
+    return fatia.acertos_cache;
+  });
+  uint64_t faltas = Soma(fatias_, [](const FatiaMetricas &fatia) -> auto & {
+    return fatia.faltas_cache;
+  });
+  fprintf(arquivo,
+          "# HELP cifra_cache_consultas_total Resoluções, pelo resultado da "
+          "consulta ao cache.\n"
+          "# TYPE cifra_cache_consultas_total counter\n"
+          "cifra_cache_consultas_total{resultado=\"acerto\"} %llu\n"
+          "cifra_cache_consultas_total{resultado=\"falta\"} %llu\n"
+          "# HELP cifra_cache_taxa_acertos Fração das resoluções vindas do "
+          "cache.\n"
+          "# TYPE cifra_cache_taxa_acertos gauge\n"
+          "cifra_cache_taxa_acertos %.6f\n",
+          (ull)acertos, (ull)faltas,
+          acertos + faltas > 0 ? (double)acertos / (acertos + faltas) : 0.0);
+
+  fprintf(arquivo,
+          "# HELP cifra_latencia_segundos Latência das instâncias ou "
+          "requisições.\n"
+          "# TYPE cifra_latencia_segundos histogram\n");
+  uint64_t acumulado = 0;
+  for (int faixa = 0; faixa < kNumFaixasLatencia; faixa++) {
+    acumulado += Soma(fatias_, [&](const FatiaMetricas &fatia) -> auto & {
+      return fatia.latencias[faixa];
+    });
+    if (faixa < kNumFaixasLatencia - 1) {
+      fprintf(arquivo, "cifra_latencia_segundos_bucket{le=\"%.9g\"} %llu\n",
+              LimiteFaixaLatencia(faixa), (ull)acumulado);
+    }
+  }
+  uint64_t soma_ns = Soma(fatias_, [](const FatiaMetricas &fatia) -> auto & {
+    return fatia.soma_latencias_ns;
+  });
+  fprintf(arquivo,
+          "cifra_latencia_segundos_bucket{le=\"+Inf\"} %llu\n"
+          "cifra_latencia_segundos_sum %.9f\n"
+          "cifra_latencia_segundos_count %llu\n",
+          (ull)acumulado, soma_ns / 1e9, (ull)acumulado);
+
+  {
+    // Sem uma fila (no servidor por socket, cada trabalhador aceita as
+    // suas conexões), a profundidade é sempre 0
+    std::lock_guard<std::mutex> guarda(trava_fonte_);
+    fprintf(arquivo,
+            "# HELP cifra_fila_profundidade Trabalhos à espera de um "
+            "trabalhador.\n"
+            "# TYPE cifra_fila_profundidade gauge\n"
+            "cifra_fila_profundidade %lld\n",
+            fonte_fila_ ? fonte_fila_() : 0LL);
+  }
+
+  rusage uso;
+  getrusage(RUSAGE_SELF, &uso);
+  fprintf(arquivo,
+          "# HELP cifra_memoria_pico_bytes Maior memória residente do "
+          "processo.\n"
+          "# TYPE cifra_memoria_pico_bytes gauge\n"
+          "cifra_memoria_pico_bytes %lld\n",
+          (long long)uso.ru_maxrss * 1024);
+
+  ImprimeHistogramaTamanho(
+      arquivo, "cifra_caixa_linhas", "Número de linhas (L) das caixas.",
+      fatias_, [](const FatiaMetricas &fatia) -> const HistogramaTamanho & {
+        return fatia.linhas;
+      });
+  ImprimeHistogramaTamanho(
+      arquivo, "cifra_caixa_colunas", "Número de colunas (C) das caixas.",
+      fatias_, [](const FatiaMetricas &fatia) -> const HistogramaTamanho & {
+        return fatia.colunas;
+      });
+  ImprimeHistogramaTamanho(
+      arquivo, "cifra_caixa_cristais", "Número de cristais (N) das caixas.",
+      fatias_, [](const FatiaMetricas &fatia) -> const HistogramaTamanho & {
+        return fatia.cristais;
+      });
+}
+
+bool Metricas::Escreve(const char *caminho) {
+  std::string temporario = std::string(caminho) + ".tmp";
+  FILE *arquivo = fopen(temporario.c_str(), "w");
+  if (arquivo == nullptr) {
+    return false;
+  }
+  Imprime(arquivo);
+  bool ok = !ferror(arquivo);
+  ok = fclose(arquivo) == 0 && ok;
+  return ok && rename(temporario.c_str(), caminho) == 0;
+}
+
+void Metricas::IniciaExportacao(const char *caminho, double intervalo) {
+  caminho_ = caminho;
+  encerrando_ = false;
+
+  // Os sinais de término ficam com a thread principal (veja servidor.cpp). A
+  // thread herda a máscara de quem a cria, e bloqueá-los já na criação evita
+  // que um sinal seja entregue a ela antes de ela mesma bloqueá-los.
+  sigset_t sinais, anterior;
+  sigemptyset(&sinais);
+  sigaddset(&sinais, SIGINT);
+  sigaddset(&sinais, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &sinais, &anterior);
+  exportadora_ = std::thread([this, intervalo]() {
+    auto periodo = std::chrono::duration<double>(intervalo);
+    std::unique_lock<std::mutex> trava(trava_exportacao_);
+    while (!encerramento_.wait_for(trava, periodo,
+                                   [this]() { return encerrando_; })) {
+      Escreve(caminho_);
+    }
+  });
+  pthread_sigmask(SIG_SETMASK, &anterior, nullptr);
+}
+
+bool Metricas::EncerraExportacao() {
+  if (caminho_ == nullptr) {
+    return true;
+  }
+  {
+    std::lock_guard<std::mutex> guarda(trava_exportacao_);
+    encerrando_ = true;
+  }
+  encerramento_.notify_all();
+  exportadora_.join();
+
+  bool ok = Escreve(caminho_);
+  caminho_ = nullptr;
+  return ok;
+}
+
+void AtivaMetricas(Metricas *metricas) { metricas_ativas = metricas; }
+
+Metricas *GetMetricas() { return metricas_ativas; }
@@ -0,0 +1,136 @@
+#include "processos.hpp"
+
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+/// @brief Resultado de uma faixa, escrito pelo processo filho no arquivo
+/// compartilhado. É seguido da configuração de cada linha (`L` `int32_t`s).
+struct ResultadoFaixa {
+  // Valor da melhor solução da faixa, ou -1.
+  int32_t valor;
+
+  // Escrito por último, indica que o resultado está completo.
+  int32_t concluido;
+
+  // Contadores da resolução da faixa, somados aos do coordenador.
+  EstatisticasResolucao estatisticas;
+};
+
+/// @brief Cria um arquivo temporário já removido do sistema de arquivos e o
+/// mapeia em memória compartilhada, preenchido com zeros.
+/// @return O mapeamento, ou `nullptr` em caso de erro
+static char *MapeiaArquivoCompartilhado(size_t tamanho) {
+  const char *diretorio = getenv("TMPDIR");
+  char caminho[4096];
+  snprintf(caminho, sizeof(caminho), "%s/cifra-processos-XXXXXX",
+           diretorio != nullptr ? diretorio : "/tmp");
+
+  int fd = mkstemp(caminho);
+  if (fd < 0) {
+    return nullptr;
+  }
+  unlink(caminho);
+
+  void *mapa = MAP_FAILED;
+  if (ftruncate(fd, tamanho) == 0) {
+    mapa = mmap(nullptr, tamanho, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  return mapa == MAP_FAILED ? nullptr : static_cast<char *>(mapa);
+}
+
+const char *ResolveEmProcessos(Cifra &cifra, int num_processos) {
+  const Caixa &caixa = cifra.GetCaixa();
+  const int L = caixa.GetL();
+  const int num_possibilidades = 0b1 << caixa.GetC();
+  num_processos = std::max(1, std::min(num_processos, num_possibilidades));
+
+  // Cada faixa ocupa um registro alinhado a uma linha de cache, para que os
+  // filhos não disputem as mesmas linhas
+  size_t tamanho_registro =
+      (sizeof(ResultadoFaixa) + L * sizeof(int32_t) + 63) / 64 * 64;
+  size_t tamanho = tamanho_registro * num_processos;
+  char *mapa = MapeiaArquivoCompartilhado(tamanho);
+  if (mapa == nullptr) {
+    return "não foi possível criar o arquivo compartilhado";
+  }
+
+  // Evita que buffers pendentes da saída padrão sejam herdados pelos filhos
+  fflush(nullptr);
+
+  vector<pid_t> filhos;
+  for (int k = 0; k < num_processos; k++) {
+    int inicio = (long long)num_possibilidades * k / num_processos;
+    int fim = (long long)num_possibilidades * (k + 1) / num_processos;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      // O filho herda os contadores do coordenador, e devolve só os da faixa
+      EstatisticasResolucao herdadas = cifra.GetEstatisticas();
+      vector<int> confs;
+      int valor = cifra.ResolveFaixa(inicio, fim, confs);
+
+      char *registro = mapa + k * tamanho_registro;
+      ResultadoFaixa *resultado = reinterpret_cast<ResultadoFaixa *>(registro);
+      int32_t *confs_compartilhadas =
+          reinterpret_cast<int32_t *>(registro + sizeof(ResultadoFaixa));
+      std::copy(confs.begin(), confs.end(), confs_compartilhadas);
+      resultado->valor = valor;
+      resultado->estatisticas = cifra.GetEstatisticas();
+      resultado->estatisticas.Desconta(herdadas);
+      resultado->concluido = 1;
+      _exit(0);
+    }
+
+    if (pid < 0) {
+      break;
+    }
+    filhos.push_back(pid);
+  }
+
+  bool falhou = (int)filhos.size() < num_processos;
+  for (pid_t filho : filhos) {
+    int situacao;
+    while (waitpid(filho, &situacao, 0) < 0 && errno == EINTR) {
+    }
+    if (!WIFEXITED(situacao) || WEXITSTATUS(situacao) != 0) {
+      falhou = true;
+    }
+  }
+
+  // Combina as faixas em ordem, mantendo o desempate de `Cifra::Resolve`
+  int melhor = -1, valor_melhor = -1;
+  for (int k = 0; k < num_processos && !falhou; k++) {
+    ResultadoFaixa *resultado =
+        reinterpret_cast<ResultadoFaixa *>(mapa + k * tamanho_registro);
+    if (!resultado->concluido) {
+      falhou = true;
+      break;
+    }
+    cifra.AcumulaEstatisticas(resultado->estatisticas);
+    if (resultado->valor > valor_melhor) {
+      melhor = k;
+      valor_melhor = resultado->valor;
+    }
+  }
+
+  const char *erro = nullptr;
+  if (falhou || melhor == -1) {
+    erro = "um dos processos não concluiu a sua faixa";
+  } else {
+    const int32_t *confs_compartilhadas = reinterpret_cast<const int32_t *>(
+        mapa + melhor * tamanho_registro + sizeof(ResultadoFaixa));
+    vector<int> confs(confs_compartilhadas, confs_compartilhadas + L);
+    cifra.AplicaSolucao(valor_melhor, confs);
+  }
+
+  munmap(mapa, tamanho);
+  return erro;
+}
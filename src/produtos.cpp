@@ -0,0 +1,289 @@
+#include <algorithm>
+#include <unordered_map>
+
+#include "cifra.hpp"
+#include "hash.hpp"
+
+/// @brief Número máximo de elementos de uma matriz de `ResolveProdutos`.
+/// Caixas com mais configurações válidas por linha ficam com a memoização.
+static const double kMaxElementosMatriz = 1 << 24;
+
+/// @brief Matriz na álgebra max-plus, onde o produto soma os valores e a soma
+/// escolhe o máximo. A posição (a, b) de uma matriz de transição é o valor da
+/// linha de destino na configuração válida b, partindo da configuração válida
+/// a da linha de origem, ou -1 se as duas forem incompatíveis.
+struct MatrizMaxPlus {
+  int linhas = 0, colunas = 0;
+  vector<int> valores;
+
+  int *Linha(int a) { return valores.data() + (size_t)a * colunas; }
+  const int *Linha(int a) const {
+    return valores.data() + (size_t)a * colunas;
+  }
+};
+
+/// @brief Calcula o produto max-plus `a` ⊗ `b`.
+/// @param estatisticas Acumula os elementos calculados e a memória alocada
+static MatrizMaxPlus Multiplica(const MatrizMaxPlus &a, const MatrizMaxPlus &b,
+                                EstatisticasResolucao &estatisticas) {
+  MatrizMaxPlus produto;
+  produto.linhas = a.linhas;
+  produto.colunas = b.colunas;
+  produto.valores.assign((size_t)a.linhas * b.colunas, -1);
+  estatisticas.estados_calculados += produto.valores.size();
+  CIFRA_CONTA(estatisticas.bytes_alocados,
+              (long long)produto.valores.size() * sizeof(int));
+
+  for (int i = 0; i < a.linhas; i++) {
+    int *destino = produto.Linha(i);
+    for (int k = 0; k < a.colunas; k++) {
+      int valor = a.Linha(i)[k];
+      if (valor == -1) {
+        continue;
+      }
+
+      const int *origem = b.Linha(k);
+      for (int j = 0; j < b.colunas; j++) {
+        destino[j] = std::max(destino[j],
+                              origem[j] == -1 ? -1 : valor + origem[j]);
+      }
+    }
+  }
+
+  return produto;
+}
+
+/// @brief Calcula a potência max-plus `base`^`expoente` por quadrados
+/// sucessivos, com O(log `expoente`) produtos.
+static MatrizMaxPlus Potencia(MatrizMaxPlus base, int expoente,
+                              EstatisticasResolucao &estatisticas) {
+  MatrizMaxPlus resultado;
+  bool vazio = true;
+  while (true) {
+    if (expoente & 1) {
+      resultado = vazio ? base : Multiplica(resultado, base, estatisticas);
+      vazio = false;
+    }
+    expoente >>= 1;
+    if (expoente == 0) {
+      return resultado;
+    }
+    base = Multiplica(base, base, estatisticas);
+  }
+}
+
+/// @brief Retorna o número de produtos de `Potencia` para um expoente.
+static int ProdutosPotencia(int expoente) {
+  return 31 - __builtin_clz(expoente) + __builtin_popcount(expoente) - 1;
+}
+
+void Cifra::AgrupaLinhas(vector<int> &classes, vector<int> &sequencias) {
+  // Linhas com os mesmos brilhos e conexões horizontais têm os mesmos pesos e
+  // as mesmas configurações válidas
+  std::unordered_map<ChaveCaixa, int, HashChaveCaixa> distintas;
+  classes.assign(L_, 0);
+  for (int i = 0; i < L_; i++) {
+    Hash128 hash;
+    int32_t horizontal = plano_->Linha(i).horizontal;
+    hash.Acrescenta(&horizontal, sizeof(horizontal));
+    hash.Acrescenta(caixa_.GetBrilhos() + (size_t)i * C_,
+                    C_ * sizeof(int32_t));
+
+    auto igual = distintas.emplace(hash.Finaliza(), distintas.size());
+    classes[i] = igual.first->second;
+  }
+
+  // A transição para a linha i depende da classe da linha anterior, da classe
+  // da linha i e das conexões verticais da linha i
+  auto transicoes_iguais = [&](int a, int b) {
+    return classes[(a - 1 + L_) % L_] == classes[(b - 1 + L_) % L_] &&
+           classes[a] == classes[b] &&
+           plano_->Linha(a).vertical == plano_->Linha(b).vertical;
+  };
+
+  sequencias.clear();
+  for (int i = 0; i < L_; i++) {
+    if (i == 0 || !transicoes_iguais(sequencias.back(), i)) {
+      sequencias.push_back(i);
+    }
+  }
+  sequencias.push_back(L_);
+}
+
+CustoResolucao Cifra::CalculaCusto(const vector<int> &sequencias) {
+  auto validas = [&](int i) {
+    return (double)plano_->Linha((i + L_) % L_).num_validas;
+  };
+  CustoResolucao custo;
+
+  // A memoização visita cada par de linhas vizinhas para cada configuração da
+  // última linha, e inicializa uma matriz de `L_` x 2**C_ x 2**C_ estados
+  double possibilidades = (double)(1 << C_);
+  custo.bytes_memoizacao =
+      L_ * possibilidades * possibilidades * sizeof(Resposta);
+  custo.memoizacao = L_ * possibilidades * possibilidades;
+  for (int i = 1; i < L_; i++) {
+    custo.memoizacao += validas(L_ - 1) * validas(i - 1) * validas(i);
+  }
+
+  // Os produtos acumulam as transições da esquerda para a direita, e cada
+  // sequência de transições iguais vira uma potência. A solução é refeita
+  // depois com uma passada linear.
+  custo.cabem_produtos = true;
+  for (size_t s = 0; s + 1 < sequencias.size(); s++) {
+    int i = sequencias[s];
+    if (validas(i - 1) * validas(i) > kMaxElementosMatriz ||
+        validas(L_ - 1) * validas(i) > kMaxElementosMatriz) {
+      custo.cabem_produtos = false;
+    }
+    custo.produtos +=
+        ProdutosPotencia(sequencias[s + 1] - i) * validas(i) * validas(i) *
+            validas(i) +
+        validas(L_ - 1) * validas(i - 1) * validas(i);
+  }
+  for (int i = 1; i < L_; i++) {
+    custo.produtos += validas(i - 1) * validas(i);
+  }
+
+  return custo;
+}
+
+int Cifra::ResolveProdutos(const vector<int> &classes,
+                           const vector<int> &sequencias, vector<int> &confs) {
+  estatisticas_.metodo = kMetodoProdutos;
+  CronometroFase cronometro_resolucao(tempos_, kFaseResolucao);
+
+  // Pesos de cada configuração válida, uma vez por linha distinta
+  vector<vector<int>> pesos;
+  for (int i = 0; i < L_; i++) {
+    if (classes[i] < (int)pesos.size()) {
+      continue;
+    }
+
+    const int32_t *validas = plano_->Validas(i);
+    pesos.emplace_back(plano_->Linha(i).num_validas, 0);
+    CIFRA_CONTA(estatisticas_.bytes_alocados,
+                (long long)pesos.back().size() * sizeof(int));
+    for (uint32_t k = 0; k < plano_->Linha(i).num_validas; k++) {
+      for (int j = 0; j < C_; j++) {
+        if (GET_BIT(validas[k], j) == 1) {
+          pesos.back()[k] += caixa_.Brilho(i, j);
+        }
+      }
+    }
+  }
+
+  // Matriz de transição da linha anterior (a última, para a linha 0) para a
+  // linha `i`
+  auto transicao = [&](int i) {
+    int anterior = (i - 1 + L_) % L_;
+    const int32_t *origens = plano_->Validas(anterior);
+    const int32_t *destinos = plano_->Validas(i);
+    const vector<int> &peso = pesos[classes[i]];
+
+    MatrizMaxPlus matriz;
+    matriz.linhas = plano_->Linha(anterior).num_validas;
+    matriz.colunas = plano_->Linha(i).num_validas;
+    matriz.valores.resize((size_t)matriz.linhas * matriz.colunas);
+    estatisticas_.estados_calculados += matriz.valores.size();
+    long long incompativeis = 0;
+    for (int a = 0; a < matriz.linhas; a++) {
+      for (int b = 0; b < matriz.colunas; b++) {
+        bool compativeis = SaoCompativeis(i, destinos[b], origens[a]);
+        matriz.Linha(a)[b] = compativeis ? peso[b] : -1;
+        incompativeis += !compativeis;
+      }
+    }
+    CIFRA_CONTA(estatisticas_.verificacoes_compatibilidade,
+                (long long)matriz.valores.size());
+    CIFRA_CONTA(estatisticas_.estados_invalidos, incompativeis);
+    CIFRA_CONTA(estatisticas_.bytes_alocados,
+                (long long)matriz.valores.size() * sizeof(int));
+    return matriz;
+  };
+
+  // Produto das transições de todas as linhas, partindo da última linha e
+  // voltando a ela. Sequências de linhas iguais, com as mesmas conexões
+  // verticais, repetem a mesma transição e viram uma potência
+  MatrizMaxPlus produto;
+  for (size_t s = 0; s + 1 < sequencias.size(); s++) {
+    int i = sequencias[s];
+    TrechoRastreio rastreio("bloco de linhas", "resolucao",
+                          sequencias[s + 1] - i);
+    MatrizMaxPlus sequencia =
+        Potencia(transicao(i), sequencias[s + 1] - i, estatisticas_);
+    produto = i == 0 ? std::move(sequencia)
+                     : Multiplica(produto, sequencia, estatisticas_);
+  }
+
+  // A diagonal tem o valor de cada configuração da última linha. Em caso de
+  // empate vale a menor, como em `ResolveFaixa`. As configurações inválidas
+  // da última linha nem entram nas matrizes.
+  int escolhida = -1, maximo = -1;
+  for (int k = 0; k < produto.linhas; k++) {
+    if (produto.Linha(k)[k] > maximo) {
+      maximo = produto.Linha(k)[k];
+      escolhida = k;
+    }
+  }
+  CIFRA_CONTA(estatisticas_.costuras_avaliadas, produto.linhas);
+  CIFRA_CONTA(estatisticas_.costuras_ignoradas,
+              (1LL << C_) - produto.linhas);
+
+  confs.assign(L_, 0);
+  if (escolhida == -1) {
+    return -1;
+  }
+
+  // Refaz a programação dinâmica apenas para a configuração escolhida,
+  // guardando para cada configuração de cada linha a melhor configuração da
+  // linha anterior, com os mesmos desempates de `f`
+  cronometro_resolucao.Para();
+  CronometroFase cronometro_reconstrucao(tempos_, kFaseReconstrucao);
+  const int conf_inicial = plano_->Validas(L_ - 1)[escolhida];
+  vector<vector<int>> anteriores(L_);
+  vector<int> atual(plano_->Linha(0).num_validas), proxima;
+  for (uint32_t k = 0; k < atual.size(); k++) {
+    atual[k] = SaoCompativeis(0, plano_->Validas(0)[k], conf_inicial)
+                   ? pesos[classes[0]][k]
+                   : -1;
+  }
+
+  long long verificacoes = 0;
+  for (int i = 1; i < L_; i++) {
+    const int32_t *origens = plano_->Validas(i - 1);
+    const int32_t *destinos = plano_->Validas(i);
+    const vector<int> &peso = pesos[classes[i]];
+    proxima.assign(plano_->Linha(i).num_validas, -1);
+    anteriores[i].assign(proxima.size(), 0);
+    estatisticas_.estados_calculados += proxima.size();
+    CIFRA_CONTA(estatisticas_.bytes_alocados,
+                (long long)proxima.size() * sizeof(int));
+
+    for (uint32_t b = 0; b < proxima.size(); b++) {
+      int melhor = -1;
+      for (uint32_t a = 0; a < atual.size(); a++) {
+        if (atual[a] <= melhor) {
+          continue;
+        }
+        verificacoes++;
+        if (SaoCompativeis(i, destinos[b], origens[a])) {
+          melhor = atual[a];
+          anteriores[i][b] = a;
+        }
+      }
+      proxima[b] = melhor == -1 ? -1 : melhor + peso[b];
+    }
+    atual.swap(proxima);
+  }
+  CIFRA_CONTA(estatisticas_.verificacoes_compatibilidade, verificacoes);
+
+  int k = escolhida;
+  for (int i = L_ - 1; i > 0; i--) {
+    confs[i] = plano_->Validas(i)[k];
+    k = anteriores[i][k];
+  }
+  confs[0] = plano_->Validas(0)[k];
+
+  return atual[escolhida];
+}
@@ -0,0 +1,90 @@
+#include "protocolo.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+/// @brief Envia todos os bytes de um buffer, repetindo envios parciais.
+static bool EnviaTudo(int fd, const char *dados, size_t tamanho, int flags) {
+  while (tamanho > 0) {
+    ssize_t enviados = send(fd, dados, tamanho, flags | MSG_NOSIGNAL);
+    if (enviados < 0 && errno == EINTR) {
+      continue;
+    }
+    if (enviados <= 0) {
+      return false;
+    }
+    dados += enviados;
+    tamanho -= enviados;
+  }
+  return true;
+}
+
+/// @brief Recebe exatamente `tamanho` bytes, repetindo recebimentos parciais.
+static bool RecebeTudo(int fd, char *dados, size_t tamanho) {
+  while (tamanho > 0) {
+    ssize_t recebidos = recv(fd, dados, tamanho, 0);
+    if (recebidos < 0 && errno == EINTR) {
+      continue;
+    }
+    if (recebidos <= 0) {
+      return false;
+    }
+    dados += recebidos;
+    tamanho -= recebidos;
+  }
+  return true;
+}
+
+bool EnviaQuadro(int fd, uint32_t status, const char *dados, size_t tamanho) {
+  if (tamanho > kTamanhoMaximoQuadro) {
+    return false;
+  }
+
+  CabecalhoQuadro cabecalho = {status, static_cast<uint32_t>(tamanho)};
+  return EnviaTudo(fd, reinterpret_cast<const char *>(&cabecalho),
+                   sizeof(cabecalho), tamanho > 0 ? MSG_MORE : 0) &&
+         EnviaTudo(fd, dados, tamanho, 0);
+}
+
+bool RecebeQuadro(int fd, uint32_t &status, vector<char> &dados) {
+  CabecalhoQuadro cabecalho;
+  if (!RecebeTudo(fd, reinterpret_cast<char *>(&cabecalho),
+                  sizeof(cabecalho)) ||
+      cabecalho.tamanho > kTamanhoMaximoQuadro) {
+    return false;
+  }
+
+  status = cabecalho.status;
+  dados.resize(cabecalho.tamanho);
+  return RecebeTudo(fd, dados.data(), cabecalho.tamanho);
+}
+
+int ConectaServidor(const char *caminho) {
+  sockaddr_un endereco;
+  memset(&endereco, 0, sizeof(endereco));
+  endereco.sun_family = AF_UNIX;
+  if (strlen(caminho) >= sizeof(endereco.sun_path)) {
+    errno = ENAMETOOLONG;
+    return -1;
+  }
+  strcpy(endereco.sun_path, caminho);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (connect(fd, reinterpret_cast<sockaddr *>(&endereco),
+              sizeof(endereco)) < 0) {
+    int erro = errno;
+    close(fd);
+    errno = erro;
+    return -1;
+  }
+
+  return fd;
+}
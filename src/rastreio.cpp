@@ -0,0 +1,148 @@
+#include "rastreio.hpp"
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using std::vector;
+
+std::atomic<bool> rastreio_ativo(false);
+
+/// @brief Eventos por bloco do buffer de uma thread, e máximo de eventos
+/// guardados por thread, que limita a memória de um rastreio longo.
+static const size_t kEventosPorBloco = 4096;
+static const size_t kMaxEventosPorThread = size_t(1) << 20;
+
+/// @brief Um trecho concluído.
+struct EventoRastreio {
+  const char *nome, *categoria;
+  uint64_t inicio, fim;
+  long long argumento;
+};
+
+/// @brief Os eventos de uma thread, em blocos de tamanho fixo, que não mudam
+/// de lugar quando o buffer cresce.
+struct BufferRastreio {
+  int tid = 0;
+  const char *nome = nullptr;
+  int indice = -1;
+
+  vector<std::unique_ptr<EventoRastreio[]>> blocos;
+  size_t num_eventos = 0;
+  long long descartados = 0;
+};
+
+// Buffers de todas as threads que já registraram eventos, que sobrevivem às
+// suas threads até a escrita do rastreio.
+static std::mutex trava_buffers;
+static vector<std::unique_ptr<BufferRastreio>> buffers;
+static thread_local BufferRastreio *buffer_thread = nullptr;
+static uint64_t inicio_rastreio = 0;
+
+/// @brief Retorna o buffer da thread atual, registrando-o na primeira vez.
+static BufferRastreio &BufferThread() {
+  if (buffer_thread == nullptr) {
+    std::lock_guard<std::mutex> guarda(trava_buffers);
+    buffers.emplace_back(new BufferRastreio());
+    buffer_thread = buffers.back().get();
+    buffer_thread->tid = (int)buffers.size();
+  }
+  return *buffer_thread;
+}
+
+void IniciaRastreio() {
+  {
+    std::lock_guard<std::mutex> guarda(trava_buffers);
+    for (std::unique_ptr<BufferRastreio> &buffer : buffers) {
+      buffer->num_eventos = 0;
+      buffer->descartados = 0;
+    }
+  }
+  inicio_rastreio = InstanteRastreio();
+  rastreio_ativo.store(true, std::memory_order_relaxed);
+}
+
+void RegistraTrecho(const char *nome, const char *categoria, uint64_t inicio,
+                    uint64_t fim, long long argumento) {
+  BufferRastreio &buffer = BufferThread();
+  if (buffer.num_eventos >= kMaxEventosPorThread) {
+    buffer.descartados++;
+    return;
+  }
+
+  size_t bloco = buffer.num_eventos / kEventosPorBloco;
+  if (bloco == buffer.blocos.size()) {
+    buffer.blocos.emplace_back(new EventoRastreio[kEventosPorBloco]);
+  }
+  buffer.blocos[bloco][buffer.num_eventos % kEventosPorBloco] = {
+      nome, categoria, inicio, fim, argumento};
+  buffer.num_eventos++;
+}
+
+void NomeiaThreadRastreio(const char *nome, int indice) {
+  if (!RastreioAtivo()) {
+    return;
+  }
+  BufferRastreio &buffer = BufferThread();
+  buffer.nome = nome;
+  buffer.indice = indice;
+}
+
+bool EscreveRastreio(const char *caminho) {
+  rastreio_ativo.store(false, std::memory_order_relaxed);
+  FILE *arquivo = fopen(caminho, "w");
+  if (arquivo == nullptr) {
+    return false;
+  }
+
+  // Eventos completos ("X"), com início e duração em microssegundos desde o
+  // início do rastreio, e os nomes das threads como metadados
+  const int pid = getpid();
+  std::lock_guard<std::mutex> guarda(trava_buffers);
+  long long descartados = 0;
+  fprintf(arquivo,
+          "{\"traceEvents\": [\n"
+          "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, "
+          "\"args\": {\"name\": \"cifra\"}}",
+          pid);
+  for (const std::unique_ptr<BufferRastreio> &buffer : buffers) {
+    descartados += buffer->descartados;
+    if (buffer->nome != nullptr) {
+      char nome[64];
+      if (buffer->indice >= 0) {
+        snprintf(nome, sizeof(nome), "%s %d", buffer->nome, buffer->indice);
+      } else {
+        snprintf(nome, sizeof(nome), "%s", buffer->nome);
+      }
+      fprintf(arquivo,
+              ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %d, "
+              "\"tid\": %d, \"args\": {\"name\": \"%s\"}}",
+              pid, buffer->tid, nome);
+    }
+
+    for (size_t e = 0; e < buffer->num_eventos; e++) {
+      const EventoRastreio &evento =
+          buffer->blocos[e / kEventosPorBloco][e % kEventosPorBloco];
+      fprintf(arquivo,
+              ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+              "\"ts\": %.3f, \"dur\": %.3f, \"pid\": %d, \"tid\": %d",
+              evento.nome, evento.categoria,
+              (double)(int64_t)(evento.inicio - inicio_rastreio) / 1000,
+              (double)(evento.fim - evento.inicio) / 1000, pid, buffer->tid);
+      if (evento.argumento >= 0) {
+        fprintf(arquivo, ", \"args\": {\"valor\": %lld}", evento.argumento);
+      }
+      fprintf(arquivo, "}");
+    }
+  }
+  fprintf(arquivo,
+          "\n],\n\"displayTimeUnit\": \"ms\",\n"
+          "\"otherData\": {\"eventos_descartados\": %lld}}\n",
+          descartados);
+
+  bool ok = !ferror(arquivo);
+  return fclose(arquivo) == 0 && ok;
+}
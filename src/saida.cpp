@@ -0,0 +1,60 @@
+#include "saida.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+void EscreveSolucaoTexto(Escritor &escritor, Cifra &cifra) {
+  pair<int, int> valores_solucao = cifra.GetValoresSolucao();
+  escritor.EscreveInteiro(valores_solucao.first);
+  escritor.EscreveCaractere(' ');
+  escritor.EscreveInteiro(valores_solucao.second);
+  escritor.EscreveCaractere('\n');
+
+  for (const pair<int, int> &cristal : cifra.GetCristaisSolucao()) {
+    escritor.EscreveInteiro(cristal.first);
+    escritor.EscreveCaractere(' ');
+    escritor.EscreveInteiro(cristal.second);
+    escritor.EscreveCaractere('\n');
+  }
+}
+
+void MontaSolucaoBinaria(char *destino, Cifra &cifra) {
+  const Caixa &caixa = cifra.GetCaixa();
+  pair<int, int> valores_solucao = cifra.GetValoresSolucao();
+
+  CabecalhoSolucao cabecalho;
+  memset(&cabecalho, 0, sizeof(cabecalho));
+  memcpy(cabecalho.magica, kMagicaSolucao, sizeof(kMagicaSolucao));
+  cabecalho.versao = kVersaoSolucao;
+  cabecalho.L = caixa.GetL();
+  cabecalho.C = caixa.GetC();
+  cabecalho.num_cristais = valores_solucao.first;
+  cabecalho.soma = valores_solucao.second;
+  memcpy(destino, &cabecalho, sizeof(cabecalho));
+
+  size_t palavras = PalavrasPorLinha(caixa.GetC());
+  uint64_t *mascaras =
+      reinterpret_cast<uint64_t *>(destino + sizeof(CabecalhoSolucao));
+  memset(mascaras, 0, caixa.GetL() * palavras * sizeof(uint64_t));
+  for (const pair<int, int> &cristal : cifra.GetCristaisSolucao()) {
+    size_t i = cristal.first - 1, j = cristal.second - 1;
+    mascaras[i * palavras + j / 64] |= uint64_t(1) << (j % 64);
+  }
+}
+
+bool EscreveSolucaoBinaria(const char *caminho, Cifra &cifra) {
+  const Caixa &caixa = cifra.GetCaixa();
+  vector<uint64_t> solucao(
+      TamanhoSolucaoBinaria(caixa.GetL(), caixa.GetC()) / sizeof(uint64_t));
+  MontaSolucaoBinaria(reinterpret_cast<char *>(solucao.data()), cifra);
+
+  FILE *arquivo = fopen(caminho, "wb");
+  if (arquivo == nullptr) {
+    return false;
+  }
+
+  bool ok = fwrite(solucao.data(), sizeof(uint64_t), solucao.size(),
+                   arquivo) == solucao.size();
+
+  return fclose(arquivo) == 0 && ok;
+}
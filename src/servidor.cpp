@@ -0,0 +1,365 @@
+#include "servidor.hpp"
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include "compartilhada.hpp"
+#include "entrada.hpp"
+#include "escritor.hpp"
+#include "leitor.hpp"
+#include "metricas.hpp"
+#include "protocolo.hpp"
+#include "rastreio.hpp"
+#include "saida.hpp"
+
+/// @brief Estado de um trabalhador do servidor, reaproveitado entre
+/// requisições.
+struct Trabalhador {
+  Cifra cifra;
+  Leitor leitor;
+  Escritor saida{Escritor::kMemoria};
+  vector<char> requisicao;
+
+  // Cache de soluções compartilhado entre os trabalhadores, ou `nullptr`.
+  CacheResultados *cache = nullptr;
+
+  // Conexão sendo atendida, ou -1. Usada para interromper o atendimento
+  // quando o servidor é encerrado.
+  std::atomic<int> conexao{-1};
+
+  // Número de requisições atendidas.
+  long long atendidas = 0;
+};
+
+/// @brief Lê e resolve uma caixa. A caixa é lida diretamente do buffer, sem
+/// cópias no formato binário.
+/// @param em_cache Recebe se a solução veio do cache
+/// @return `nullptr` se a caixa foi resolvida, ou a mensagem de erro.
+static const char *LeEResolve(Trabalhador &trabalhador, const char *dados,
+                              size_t tamanho,
+                              const ParametrosResolucao &parametros,
+                              bool &em_cache) {
+  Leitor &leitor = trabalhador.leitor;
+  leitor.AbreTrecho(dados, dados + tamanho);
+  if (!LeCaixa(leitor, trabalhador.cifra)) {
+    return leitor.GetErro();
+  }
+
+  const char *erro = trabalhador.cifra.ValidaParametros(parametros);
+  if (erro != nullptr) {
+    return erro;
+  }
+
+  em_cache = ResolveComCache(trabalhador.cifra, parametros, trabalhador.cache);
+  return nullptr;
+}
+
+/// @brief Atende uma requisição com `LeEResolve`, registrando o resultado e a
+/// latência nas métricas ativas, se houver.
+/// @return `nullptr` se a caixa foi resolvida, ou a mensagem de erro.
+static const char *ResolveRequisicao(Trabalhador &trabalhador,
+                                     const char *dados, size_t tamanho,
+                                     const ParametrosResolucao &parametros) {
+  trabalhador.atendidas++;
+
+  auto inicio = std::chrono::steady_clock::now();
+  bool em_cache = false;
+  const char *erro =
+      LeEResolve(trabalhador, dados, tamanho, parametros, em_cache);
+
+  Metricas *metricas = GetMetricas();
+  if (metricas != nullptr && erro != nullptr) {
+    metricas->RegistraErro();
+  } else if (metricas != nullptr) {
+    metricas->RegistraResolucao(trabalhador.cifra,
+                                trabalhador.cache != nullptr, em_cache);
+    metricas->RegistraLatencia(std::chrono::duration<double>(
+                                   std::chrono::steady_clock::now() - inicio)
+                                   .count());
+  }
+  return erro;
+}
+
+/// @brief Bloqueia SIGINT e SIGTERM na thread atual (e nas que ela criar),
+/// para que sejam tratados apenas com `sigwait`.
+/// @return O conjunto dos sinais bloqueados
+static sigset_t BloqueiaSinaisDeTermino() {
+  sigset_t sinais;
+  sigemptyset(&sinais);
+  sigaddset(&sinais, SIGINT);
+  sigaddset(&sinais, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &sinais, nullptr);
+  return sinais;
+}
+
+/// @brief Soma e imprime o número de requisições atendidas e, se houver, as
+/// estatísticas do cache.
+static void ImprimeAtendidas(
+    const vector<std::unique_ptr<Trabalhador>> &trabalhadores,
+    CacheResultados *cache) {
+  long long atendidas = 0;
+  for (const std::unique_ptr<Trabalhador> &trabalhador : trabalhadores) {
+    atendidas += trabalhador->atendidas;
+  }
+  fprintf(stderr, "Servidor encerrado após %lld requisições\n", atendidas);
+  if (cache != nullptr) {
+    cache->ImprimeEstatisticas(stderr);
+  }
+}
+
+/// @brief Atende as requisições de uma conexão até que ela seja encerrada.
+static void AtendeConexao(int fd, Trabalhador &trabalhador,
+                          const ParametrosResolucao &parametros) {
+  uint32_t status;
+  while (RecebeQuadro(fd, status, trabalhador.requisicao)) {
+    const char *erro = ResolveRequisicao(
+        trabalhador, trabalhador.requisicao.data(),
+        trabalhador.requisicao.size(), parametros);
+
+    bool enviado;
+    if (erro != nullptr) {
+      enviado = EnviaQuadro(fd, kQuadroErro, erro, strlen(erro));
+    } else {
+      trabalhador.saida.Limpa();
+      EscreveSolucaoTexto(trabalhador.saida, trabalhador.cifra);
+      enviado = EnviaQuadro(fd, kQuadroOk, trabalhador.saida.GetDados(),
+                            trabalhador.saida.GetTamanho());
+    }
+
+    if (!enviado) {
+      return;
+    }
+  }
+}
+
+/// @brief Remove o socket deixado em `endereco` por um servidor que não
+/// terminou normalmente. O caminho só é removido se for um socket em que
+/// ninguém ouve (a conexão é recusada); um arquivo comum ou o socket de um
+/// servidor ativo é mantido.
+/// @return `nullptr` se o caminho está livre para o `bind`, ou uma mensagem
+/// de erro caso contrário.
+static const char *RemoveSocketAbandonado(const sockaddr_un &endereco) {
+  struct stat info;
+  if (lstat(endereco.sun_path, &info) < 0) {
+    return errno == ENOENT ? nullptr : strerror(errno);
+  }
+  if (!S_ISSOCK(info.st_mode)) {
+    return "o caminho já existe e não é um socket";
+  }
+
+  int sonda = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (sonda < 0) {
+    return strerror(errno);
+  }
+  bool abandonado =
+      connect(sonda, reinterpret_cast<const sockaddr *>(&endereco),
+              sizeof(endereco)) < 0 &&
+      errno == ECONNREFUSED;
+  close(sonda);
+  if (!abandonado) {
+    return strerror(EADDRINUSE);
+  }
+  if (unlink(endereco.sun_path) < 0 && errno != ENOENT) {
+    return strerror(errno);
+  }
+  return nullptr;
+}
+
+int ExecutaServidor(const char *caminho, const ParametrosResolucao &parametros,
+                    CacheResultados *cache, int num_trabalhadores) {
+  sockaddr_un endereco;
+  memset(&endereco, 0, sizeof(endereco));
+  endereco.sun_family = AF_UNIX;
+  if (strlen(caminho) >= sizeof(endereco.sun_path)) {
+    fprintf(stderr, "Caminho do socket longo demais: %s\n", caminho);
+    return 1;
+  }
+  strcpy(endereco.sun_path, caminho);
+
+  const char *erro = RemoveSocketAbandonado(endereco);
+  if (erro != nullptr) {
+    fprintf(stderr, "Não foi possível ouvir em %s: %s\n", caminho, erro);
+    return 1;
+  }
+
+  int ouvinte = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (ouvinte < 0 ||
+      bind(ouvinte, reinterpret_cast<sockaddr *>(&endereco),
+           sizeof(endereco)) < 0 ||
+      listen(ouvinte, SOMAXCONN) < 0) {
+    fprintf(stderr, "Não foi possível ouvir em %s: %s\n", caminho,
+            strerror(errno));
+    return 1;
+  }
+
+  // Os sinais de término são bloqueados em todas as threads e tratados apenas
+  // pela thread principal, com `sigwait`
+  sigset_t sinais = BloqueiaSinaisDeTermino();
+
+  std::atomic<bool> encerrando(false);
+  vector<std::unique_ptr<Trabalhador>> trabalhadores;
+  vector<std::thread> threads;
+  for (int k = 0; k < num_trabalhadores; k++) {
+    trabalhadores.emplace_back(new Trabalhador());
+    Trabalhador &trabalhador = *trabalhadores.back();
+    trabalhador.cache = cache;
+
+    threads.emplace_back([&, ouvinte, k]() {
+      NomeiaThreadRastreio("trabalhador", k);
+      while (true) {
+        int fd = accept(ouvinte, nullptr, nullptr);
+        if (fd < 0 && (errno == EINTR || errno == ECONNABORTED)) {
+          continue;
+        }
+        if (fd < 0) {
+          return;
+        }
+
+        trabalhador.conexao = fd;
+        if (!encerrando) {
+          TrechoRastreio rastreio("conexao", "servidor");
+          AtendeConexao(fd, trabalhador, parametros);
+        }
+        trabalhador.conexao = -1;
+        close(fd);
+      }
+    });
+  }
+
+  fprintf(stderr, "Servidor ouvindo em %s com %d trabalhadores\n", caminho,
+          num_trabalhadores);
+
+  int sinal;
+  sigwait(&sinais, &sinal);
+
+  // Interrompe as chamadas de `accept` e as conexões em atendimento
+  encerrando = true;
+  shutdown(ouvinte, SHUT_RDWR);
+  for (std::unique_ptr<Trabalhador> &trabalhador : trabalhadores) {
+    int fd = trabalhador->conexao;
+    if (fd >= 0) {
+      shutdown(fd, SHUT_RDWR);
+    }
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+
+  close(ouvinte);
+  unlink(caminho);
+
+  ImprimeAtendidas(trabalhadores, cache);
+  return 0;
+}
+
+/// @brief Atende uma vaga da fila compartilhada, escrevendo a solução no
+/// formato binário logo após a caixa, ou a mensagem de erro no início da vaga.
+static void AtendeVaga(FilaCompartilhada &fila, int vaga,
+                       Trabalhador &trabalhador,
+                       const ParametrosResolucao &parametros) {
+  char *dados = fila.GetVaga(vaga);
+  size_t tamanho_entrada = fila.GetTamanhoEntrada(vaga);
+  const char *erro = nullptr;
+  if (tamanho_entrada > fila.GetTamanhoVaga()) {
+    erro = "caixa maior que a vaga";
+  } else {
+    erro = ResolveRequisicao(trabalhador, dados, tamanho_entrada, parametros);
+  }
+
+  // A solução fica alinhada a uma linha de cache após a caixa
+  size_t inicio = (tamanho_entrada + 63) / 64 * 64, tamanho = 0;
+  if (erro == nullptr) {
+    const Caixa &caixa = trabalhador.cifra.GetCaixa();
+    tamanho = TamanhoSolucaoBinaria(caixa.GetL(), caixa.GetC());
+    if (inicio + tamanho > fila.GetTamanhoVaga()) {
+      erro = "a solução não cabe na vaga";
+    } else {
+      MontaSolucaoBinaria(dados + inicio, trabalhador.cifra);
+    }
+  }
+
+  if (erro != nullptr) {
+    // A caixa não é mais necessária, então a mensagem a sobrescreve
+    inicio = 0;
+    tamanho = std::min(strlen(erro), fila.GetTamanhoVaga());
+    memcpy(dados, erro, tamanho);
+  }
+
+  fila.Conclui(vaga, erro == nullptr, inicio, tamanho);
+}
+
+int ExecutaServidorCompartilhado(const char *nome,
+                                 const ParametrosResolucao &parametros,
+                                 CacheResultados *cache, int num_trabalhadores,
+                                 int num_vagas, size_t tamanho_vaga,
+                                 bool substitui) {
+  FilaCompartilhada fila;
+  if (!fila.Cria(nome, num_vagas, tamanho_vaga, substitui)) {
+    if (errno == EEXIST) {
+      fprintf(stderr,
+              "A memória compartilhada %s já existe: outro servidor pode "
+              "estar usando-a. Se ela ficou de uma execução interrompida, "
+              "use --substitui-memoria\n",
+              nome);
+    } else {
+      fprintf(stderr,
+              "Não foi possível criar a memória compartilhada %s: %s\n",
+              nome, strerror(errno));
+    }
+    return 1;
+  }
+
+  sigset_t sinais = BloqueiaSinaisDeTermino();
+  if (GetMetricas() != nullptr) {
+    GetMetricas()->DefineFonteFila(
+        [&fila]() { return (long long)fila.GetPendentesAproximado(); });
+  }
+
+  vector<std::unique_ptr<Trabalhador>> trabalhadores;
+  vector<std::thread> threads;
+  for (int k = 0; k < num_trabalhadores; k++) {
+    trabalhadores.emplace_back(new Trabalhador());
+    Trabalhador &trabalhador = *trabalhadores.back();
+    trabalhador.cache = cache;
+
+    threads.emplace_back([&, k]() {
+      NomeiaThreadRastreio("trabalhador", k);
+      int vaga;
+      while ((vaga = fila.ProximaVaga()) >= 0) {
+        TrechoRastreio rastreio("vaga", "servidor", vaga);
+        AtendeVaga(fila, vaga, trabalhador, parametros);
+      }
+    });
+  }
+
+  fprintf(stderr,
+          "Servidor em %s com %d vagas de %zu bytes e %d trabalhadores\n",
+          nome, fila.GetNumVagas(), fila.GetTamanhoVaga(), num_trabalhadores);
+
+  int sinal;
+  sigwait(&sinais, &sinal);
+
+  fila.Encerra();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  if (GetMetricas() != nullptr) {
+    GetMetricas()->DefineFonteFila(nullptr);
+  }
+  fila.Finaliza();
+
+  ImprimeAtendidas(trabalhadores, cache);
+  return 0;
+}
@@ -0,0 +1,243 @@
+#include "simetria.hpp"
+
+#include <algorithm>
+
+#include "hash.hpp"
+
+/// @brief Encontra o início da menor rotação lexicográfica de uma sequência
+/// circular, com o algoritmo de dois ponteiros: os candidatos `i` e `j` são
+/// comparados por `k` posições, e o perdedor avança para depois do trecho
+/// comparado, o que limita o total de comparações a 3n.
+static int MenorRotacao(const vector<uint64_t> &sequencia) {
+  int n = sequencia.size();
+  int i = 0, j = 1, k = 0;
+  while (i < n && j < n && k < n) {
+    uint64_t a = sequencia[(i + k) % n], b = sequencia[(j + k) % n];
+    if (a == b) {
+      k++;
+      continue;
+    }
+
+    if (a > b) {
+      i += k + 1;
+    } else {
+      j += k + 1;
+    }
+    if (i == j) {
+      j++;
+    }
+    k = 0;
+  }
+  return std::min(i, j);
+}
+
+/// @brief Compara duas rotações de sequências de mesmo tamanho.
+/// @return Se a rotação de `a` que começa em `inicio_a` é menor que a de `b`
+/// que começa em `inicio_b`
+static bool RotacaoMenor(const vector<uint64_t> &a, int inicio_a,
+                         const vector<uint64_t> &b, int inicio_b) {
+  int n = a.size();
+  for (int k = 0; k < n; k++) {
+    uint64_t x = a[(inicio_a + k) % n], y = b[(inicio_b + k) % n];
+    if (x != y) {
+      return x < y;
+    }
+  }
+  return false;
+}
+
+/// @brief Retorna o menor período de uma sequência circular, a partir da
+/// função de falha do KMP.
+static int Periodo(const vector<uint64_t> &sequencia, int inicio) {
+  int n = sequencia.size();
+  vector<int> falha(n, 0);
+  for (int q = 1, k = 0; q < n; q++) {
+    uint64_t atual = sequencia[(inicio + q) % n];
+    while (k > 0 && sequencia[(inicio + k) % n] != atual) {
+      k = falha[k - 1];
+    }
+    if (sequencia[(inicio + k) % n] == atual) {
+      k++;
+    }
+    falha[q] = k;
+  }
+
+  int periodo = n - falha[n - 1];
+  return n % periodo == 0 ? periodo : n;
+}
+
+/// @brief Uma escolha de deslocamento e reflexão para uma dimensão.
+struct Orientacao {
+  int deslocamento;
+  bool reflete;
+};
+
+/// @brief Encontra as orientações de uma dimensão que levam à menor rotação.
+/// Há mais de uma quando a sequência é periódica ou simétrica.
+/// @param direta A sequência na ordem original
+/// @param refletida A sequência na ordem inversa: a posição k corresponde à
+/// posição (n - k) % n da original, já com o conteúdo visto após a reflexão
+/// @param maximo O número máximo de orientações retornadas
+static vector<Orientacao> MenoresOrientacoes(const vector<uint64_t> &direta,
+                                             const vector<uint64_t> &refletida,
+                                             size_t maximo) {
+  int n = direta.size();
+  int inicio_direta = MenorRotacao(direta);
+  int inicio_refletida = MenorRotacao(refletida);
+
+  vector<Orientacao> orientacoes;
+  for (bool reflete : {false, true}) {
+    const vector<uint64_t> &sequencia = reflete ? refletida : direta;
+    int inicio = reflete ? inicio_refletida : inicio_direta;
+    if (reflete ? RotacaoMenor(direta, inicio_direta, refletida, inicio)
+                : RotacaoMenor(refletida, inicio_refletida, direta, inicio)) {
+      continue;
+    }
+
+    int periodo = Periodo(sequencia, inicio);
+    for (int k = inicio; k < inicio + n && orientacoes.size() < maximo;
+         k += periodo) {
+      orientacoes.push_back({reflete ? (n - k % n) % n : k % n, reflete});
+    }
+  }
+  return orientacoes;
+}
+
+/// @brief Número máximo de orientações das colunas que são desempatadas pelo
+/// conteúdo das linhas.
+static const size_t kMaxOrientacoesColunas = 16;
+
+/// @brief Retorna as conexões à direita e acima de uma posição da caixa
+/// transformada, que está na posição (`linha`, `coluna`) da original e cujas
+/// vizinhas à direita e acima estão na coluna `coluna_direita` e na linha
+/// `linha_acima`. A conexão entre duas posições vizinhas é guardada na posição
+/// da esquerda (ou de baixo) na caixa original, que após uma reflexão pode ser
+/// a vizinha.
+///
+/// Com 2 linhas (ou 2 colunas), as duas posições de uma coluna (ou linha) são
+/// vizinhas pelos dois lados, e uma reflexão troca a posição que guarda a
+/// conexão. Nesse caso as duas conexões são unidas em ambas as posições, o que
+/// não muda o problema.
+static int ConexoesTransformadas(const Caixa &caixa, int linha, int coluna,
+                                 int linha_acima, int coluna_direita) {
+  const int L = caixa.GetL(), C = caixa.GetC();
+  int direita = C == 2 ? (caixa.Conexoes(linha, 0) | caixa.Conexoes(linha, 1))
+                    : coluna_direita == (coluna + 1) % C
+                        ? caixa.Conexoes(linha, coluna)
+                        : caixa.Conexoes(linha, coluna_direita);
+  int acima = L == 2 ? (caixa.Conexoes(0, coluna) | caixa.Conexoes(1, coluna))
+                : linha_acima == (linha - 1 + L) % L
+                    ? caixa.Conexoes(linha, coluna)
+                    : caixa.Conexoes(linha_acima, coluna);
+  return (direita & 1) | (acima & 2);
+}
+
+/// @brief Resume cada linha da caixa pelo seu conteúdo na ordem de colunas de
+/// uma transformação. Na reflexão das linhas, a vizinha acima de uma posição
+/// passa a ser a de baixo, o que muda as conexões vistas.
+/// @param linhas Recebe o resumo de cada linha sem reflexão
+/// @param refletidas Recebe o resumo de cada linha com reflexão, na ordem
+/// inversa
+static void ResumeLinhas(const Caixa &caixa,
+                         const TransformacaoToroidal &transformacao,
+                         vector<uint64_t> &linhas,
+                         vector<uint64_t> &refletidas) {
+  const int L = caixa.GetL(), C = caixa.GetC();
+  linhas.assign(L, 0);
+  refletidas.assign(L, 0);
+  for (int i = 0; i < L; i++) {
+    uint64_t direta = 0, refletida = 0;
+    for (int j = 0; j < C; j++) {
+      int coluna = transformacao.ColunaOriginal(j);
+      int coluna_direita = transformacao.ColunaOriginal(j + 1);
+      uint64_t brilho = static_cast<uint32_t>(caixa.Brilho(i, coluna));
+
+      direta = Mistura(direta ^ brilho ^
+                       (uint64_t)ConexoesTransformadas(caixa, i, coluna,
+                                                       (i - 1 + L) % L,
+                                                       coluna_direita)
+                           << 32);
+      refletida = Mistura(refletida ^ brilho ^
+                          (uint64_t)ConexoesTransformadas(caixa, i, coluna,
+                                                          (i + 1) % L,
+                                                          coluna_direita)
+                              << 32);
+    }
+    linhas[i] = direta;
+    refletidas[(L - i) % L] = refletida;
+  }
+}
+
+TransformacaoToroidal CalculaFormaCanonica(const Caixa &caixa) {
+  TransformacaoToroidal transformacao;
+  const int L = caixa.GetL(), C = caixa.GetC();
+  transformacao.L = L;
+  transformacao.C = C;
+
+  // A assinatura de uma coluna soma os brilhos (misturados) e conta as
+  // conexões verticais, que não dependem da rotação nem da reflexão das linhas
+  // ou das colunas
+  vector<uint64_t> colunas(C, 0);
+  for (int i = 0; i < L; i++) {
+    for (int j = 0; j < C; j++) {
+      colunas[j] += Mistura(static_cast<uint32_t>(caixa.Brilho(i, j)));
+      colunas[j] += (caixa.Conexoes(i, j) >> 1) * 0x9e3779b97f4a7c15ull;
+    }
+  }
+
+  vector<uint64_t> colunas_refletidas(C);
+  for (int k = 0; k < C; k++) {
+    colunas_refletidas[k] = colunas[(C - k) % C];
+  }
+
+  // Para cada orientação empatada das colunas, as linhas escolhem a sua menor
+  // orientação, e vence a que leva à menor sequência de linhas. Empates entre
+  // as linhas não importam, pois levam à mesma caixa
+  vector<uint64_t> linhas, linhas_refletidas, melhor;
+  for (const Orientacao &colunas_escolhidas : MenoresOrientacoes(
+           colunas, colunas_refletidas, kMaxOrientacoesColunas)) {
+    TransformacaoToroidal candidata = transformacao;
+    candidata.deslocamento_colunas = colunas_escolhidas.deslocamento;
+    candidata.reflete_colunas = colunas_escolhidas.reflete;
+    ResumeLinhas(caixa, candidata, linhas, linhas_refletidas);
+
+    Orientacao linhas_escolhidas =
+        MenoresOrientacoes(linhas, linhas_refletidas, 1)[0];
+    candidata.deslocamento_linhas = linhas_escolhidas.deslocamento;
+    candidata.reflete_linhas = linhas_escolhidas.reflete;
+
+    vector<uint64_t> sequencia(L);
+    for (int i = 0; i < L; i++) {
+      int original = candidata.LinhaOriginal(i);
+      sequencia[i] = linhas_escolhidas.reflete
+                         ? linhas_refletidas[(L - original) % L]
+                         : linhas[original];
+    }
+    if (melhor.empty() || sequencia < melhor) {
+      melhor = sequencia;
+      transformacao = candidata;
+    }
+  }
+
+  return transformacao;
+}
+
+void AplicaTransformacao(const Caixa &origem,
+                         const TransformacaoToroidal &transformacao,
+                         Caixa &destino) {
+  const int L = origem.GetL(), C = origem.GetC();
+  destino.Inicializa(L, C);
+
+  for (int i = 0; i < L; i++) {
+    int linha = transformacao.LinhaOriginal(i);
+    int linha_acima = transformacao.LinhaOriginal(i - 1);
+    for (int j = 0; j < C; j++) {
+      int coluna = transformacao.ColunaOriginal(j);
+      destino.Define(
+          i, j,
+          {origem.Brilho(linha, coluna),
+           ConexoesTransformadas(origem, linha, coluna, linha_acima,
+                                 transformacao.ColunaOriginal(j + 1))});
+    }
+  }
+}
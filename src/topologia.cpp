@@ -0,0 +1,368 @@
+#include "topologia.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+void PlanoTopologia::CalculaMascaras(const Caixa &caixa) {
+  L_ = caixa.GetL();
+  C_ = caixa.GetC();
+  linhas_proprias_.assign(L_, LinhaPlano());
+  validas_proprias_.clear();
+
+  for (int i = 0; i < L_; i++) {
+    LinhaPlano &linha = linhas_proprias_[i];
+    for (int j = 0; j < C_; j++) {
+      int conexoes = caixa.Conexoes(i, j);
+      linha.presenca |= (caixa.Brilho(i, j) != -1) << j;
+      linha.horizontal |= (conexoes & 1) << j;
+      linha.vertical |= (conexoes >> 1 & 1) << j;
+    }
+  }
+
+  linhas_ = linhas_proprias_.data();
+  validas_ = nullptr;
+}
+
+void PlanoTopologia::CalculaValidas() {
+  validas_proprias_.clear();
+
+  // Linhas com as mesmas posições e conexões horizontais têm as mesmas
+  // configurações válidas, que são guardadas uma única vez
+  std::unordered_map<uint64_t, int> distintas;
+  for (int i = 0; i < L_; i++) {
+    LinhaPlano &linha = linhas_proprias_[i];
+    uint64_t mascaras = (uint64_t)(uint32_t)linha.presenca << 32 |
+                        (uint32_t)linha.horizontal;
+    auto igual = distintas.find(mascaras);
+    if (igual != distintas.end()) {
+      linha.inicio_validas = linhas_proprias_[igual->second].inicio_validas;
+      linha.num_validas = linhas_proprias_[igual->second].num_validas;
+      continue;
+    }
+    distintas[mascaras] = i;
+    linha.inicio_validas = validas_proprias_.size();
+
+    // Percorre os subconjuntos das posições com cristal em ordem crescente,
+    // descartando os que ativam duas posições vizinhas conectadas. A posição à
+    // direita da última coluna é a primeira.
+    for (int32_t conf = 0;; conf = (conf - linha.presenca) & linha.presenca) {
+      int32_t direita = (conf >> 1) | ((conf & 1) << (C_ - 1));
+      if ((conf & direita & linha.horizontal) == 0) {
+        validas_proprias_.push_back(conf);
+      }
+      if (conf == linha.presenca) {
+        break;
+      }
+    }
+
+    linha.num_validas = validas_proprias_.size() - linha.inicio_validas;
+  }
+
+  validas_ = validas_proprias_.data();
+}
+
+ChaveCaixa PlanoTopologia::CalculaChave() const {
+  int32_t dimensoes[2] = {L_, C_};
+  Hash128 hash;
+  hash.Acrescenta(dimensoes, sizeof(dimensoes));
+  for (int i = 0; i < L_; i++) {
+    int32_t mascaras[3] = {linhas_[i].presenca, linhas_[i].horizontal,
+                           linhas_[i].vertical};
+    hash.Acrescenta(mascaras, sizeof(mascaras));
+  }
+  return hash.Finaliza();
+}
+
+/// @brief Conta as configurações válidas de uma linha sem enumerá-las, como
+/// os conjuntos independentes de um ciclo: fixado o uso da primeira coluna,
+/// percorre as colunas contando as configurações que terminam com a coluna
+/// atual livre ou usada, e descarta no fim as que usam a primeira e a última
+/// colunas conectadas.
+static uint64_t ContaValidas(int32_t presenca, int32_t horizontal, int C) {
+  uint64_t total = 0;
+  for (int primeira = 0; primeira < 2; primeira++) {
+    if (primeira && !(presenca & 1)) {
+      continue;
+    }
+    // Configurações até a coluna j, com a coluna j livre ou usada
+    uint64_t livre = !primeira, usada = primeira;
+    for (int j = 1; j < C; j++) {
+      uint64_t anteriores = livre + usada;
+      uint64_t usando = (presenca >> j & 1)
+                            ? (horizontal >> (j - 1) & 1 ? livre : anteriores)
+                            : 0;
+      livre = anteriores;
+      usada = usando;
+    }
+    bool conectadas = horizontal >> (C - 1) & 1;
+    total += livre + (primeira && conectadas ? 0 : usada);
+  }
+  return total;
+}
+
+/// @brief Verifica as configurações válidas de uma linha: devem ser
+/// crescentes, usar apenas posições com cristal, não ativar duas posições
+/// conectadas e ser tantas quanto as da linha, para que sejam exatamente as
+/// que `CalculaValidas` enumera.
+static bool VerificaValidas(const LinhaPlano &linha, const int32_t *validas,
+                            int C) {
+  if (linha.num_validas != ContaValidas(linha.presenca, linha.horizontal, C)) {
+    return false;
+  }
+  for (uint32_t k = 0; k < linha.num_validas; k++) {
+    int32_t conf = validas[k];
+    int32_t direita = (conf >> 1) | ((conf & 1) << (C - 1));
+    if ((conf & ~linha.presenca) != 0 ||
+        (conf & direita & linha.horizontal) != 0 ||
+        (k > 0 && conf <= validas[k - 1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PlanoTopologia::Associa(const char *dados, size_t tamanho,
+                             const ChaveCaixa &chave) {
+  CabecalhoPlano cabecalho;
+  if (tamanho < sizeof(cabecalho)) {
+    return false;
+  }
+  memcpy(&cabecalho, dados, sizeof(cabecalho));
+  if (memcmp(cabecalho.magica, kMagicaPlano, sizeof(kMagicaPlano)) != 0 ||
+      cabecalho.versao != kVersaoPlano || !(cabecalho.chave == chave) ||
+      cabecalho.L < 1 || cabecalho.C < 1 || cabecalho.C > kMaxColunas) {
+    return false;
+  }
+
+  size_t esperado = sizeof(cabecalho) + cabecalho.L * sizeof(LinhaPlano) +
+                    cabecalho.num_validas * sizeof(int32_t);
+  if (tamanho != esperado) {
+    return false;
+  }
+
+  // As máscaras cabem nas colunas, e as faixas de configurações cabem no
+  // arranjo e contêm exatamente as configurações válidas da linha. Linhas
+  // que compartilham a faixa e as máscaras são verificadas uma única vez.
+  const LinhaPlano *linhas =
+      reinterpret_cast<const LinhaPlano *>(dados + sizeof(cabecalho));
+  const int32_t *validas = reinterpret_cast<const int32_t *>(
+      dados + sizeof(cabecalho) + cabecalho.L * sizeof(LinhaPlano));
+  const uint32_t fora = ~((uint32_t(1) << cabecalho.C) - 1);
+  std::unordered_map<uint64_t, uint32_t> verificadas;
+  for (int i = 0; i < cabecalho.L; i++) {
+    const LinhaPlano &linha = linhas[i];
+    if (((uint32_t)(linha.presenca | linha.horizontal | linha.vertical) &
+         fora) != 0 ||
+        linha.inicio_validas > cabecalho.num_validas ||
+        linha.num_validas > cabecalho.num_validas - linha.inicio_validas) {
+      return false;
+    }
+
+    uint64_t mascaras =
+        (uint64_t)(uint32_t)linha.presenca << 32 | (uint32_t)linha.horizontal;
+    auto verificada = verificadas.find(mascaras);
+    if (verificada != verificadas.end() &&
+        verificada->second == linha.inicio_validas) {
+      continue;
+    }
+    if (!VerificaValidas(linha, validas + linha.inicio_validas,
+                         cabecalho.C)) {
+      return false;
+    }
+    verificadas[mascaras] = linha.inicio_validas;
+  }
+
+  L_ = cabecalho.L;
+  C_ = cabecalho.C;
+  linhas_proprias_.clear();
+  validas_proprias_.clear();
+  linhas_ = linhas;
+  validas_ = validas;
+
+  // A chave é recalculada das máscaras, que a resolução usa diretamente
+  if (!(CalculaChave() == chave)) {
+    L_ = C_ = 0;
+    linhas_ = nullptr;
+    validas_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool PlanoTopologia::Escreve(FILE *arquivo, const ChaveCaixa &chave) const {
+  // Linhas iguais compartilham as configurações válidas, então o arranjo
+  // termina no fim da faixa mais distante
+  uint32_t num_validas = 0;
+  for (int i = 0; i < L_; i++) {
+    num_validas = std::max(num_validas, linhas_[i].inicio_validas +
+                                            linhas_[i].num_validas);
+  }
+
+  CabecalhoPlano cabecalho;
+  memset(&cabecalho, 0, sizeof(cabecalho));
+  memcpy(cabecalho.magica, kMagicaPlano, sizeof(kMagicaPlano));
+  cabecalho.versao = kVersaoPlano;
+  cabecalho.L = L_;
+  cabecalho.C = C_;
+  cabecalho.num_validas = num_validas;
+  cabecalho.chave = chave;
+
+  return fwrite(&cabecalho, sizeof(cabecalho), 1, arquivo) == 1 &&
+         fwrite(linhas_, sizeof(LinhaPlano), L_, arquivo) == (size_t)L_ &&
+         fwrite(validas_, sizeof(int32_t), num_validas, arquivo) ==
+             num_validas;
+}
+
+CachePlanos::CachePlanos(size_t capacidade) : capacidade_(capacidade) {}
+
+const char *CachePlanos::AbreDiretorio(const char *caminho) {
+  struct stat informacoes;
+  if (mkdir(caminho, 0755) < 0 && errno != EEXIST) {
+    return "não foi possível criar o diretório de planos";
+  }
+  if (stat(caminho, &informacoes) < 0 || !S_ISDIR(informacoes.st_mode)) {
+    return "o caminho não é um diretório";
+  }
+
+  diretorio_ = caminho;
+  return nullptr;
+}
+
+std::string CachePlanos::CaminhoArquivo(const ChaveCaixa &chave) {
+  char nome[48];
+  snprintf(nome, sizeof(nome), "/%016llx%016llx.plano",
+           (unsigned long long)chave.partes[0],
+           (unsigned long long)chave.partes[1]);
+  return diretorio_ + nome;
+}
+
+std::shared_ptr<const PlanoTopologia> CachePlanos::CarregaArquivo(
+    const ChaveCaixa &chave) {
+  int fd = open(CaminhoArquivo(chave).c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  struct stat informacoes;
+  void *mapa = MAP_FAILED;
+  size_t tamanho = 0;
+  if (fstat(fd, &informacoes) == 0 && informacoes.st_size > 0) {
+    tamanho = informacoes.st_size;
+    mapa = mmap(nullptr, tamanho, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapa == MAP_FAILED) {
+    return nullptr;
+  }
+
+  // O mapeamento é desfeito quando o último usuário do plano o libera
+  PlanoTopologia *plano = new PlanoTopologia();
+  if (!plano->Associa(static_cast<const char *>(mapa), tamanho, chave)) {
+    delete plano;
+    munmap(mapa, tamanho);
+    return nullptr;
+  }
+  return std::shared_ptr<const PlanoTopologia>(
+      plano, [mapa, tamanho](const PlanoTopologia *liberado) {
+        delete liberado;
+        munmap(mapa, tamanho);
+      });
+}
+
+void CachePlanos::SalvaArquivo(const ChaveCaixa &chave,
+                               const PlanoTopologia &plano) {
+  std::string caminho = CaminhoArquivo(chave);
+  std::string temporario = caminho + ".XXXXXX";
+  int fd = mkstemp(&temporario[0]);
+  if (fd < 0) {
+    return;
+  }
+  fchmod(fd, 0644);
+
+  FILE *arquivo = fdopen(fd, "wb");
+  if (arquivo == nullptr) {
+    close(fd);
+    unlink(temporario.c_str());
+    return;
+  }
+
+  bool escrito = plano.Escreve(arquivo, chave);
+  escrito = fclose(arquivo) == 0 && escrito;
+  if (!escrito || rename(temporario.c_str(), caminho.c_str()) < 0) {
+    unlink(temporario.c_str());
+  }
+}
+
+std::shared_ptr<const PlanoTopologia> CachePlanos::Insere(
+    const ChaveCaixa &chave, std::shared_ptr<const PlanoTopologia> plano) {
+  std::lock_guard<std::mutex> guarda(trava_);
+  auto existente = indice_.find(chave);
+  if (existente != indice_.end()) {
+    return existente->second->second;
+  }
+  if (capacidade_ == 0) {
+    return plano;
+  }
+
+  recentes_.push_front({chave, plano});
+  indice_[chave] = recentes_.begin();
+  if (recentes_.size() > capacidade_) {
+    indice_.erase(recentes_.back().first);
+    recentes_.pop_back();
+  }
+  return plano;
+}
+
+std::shared_ptr<const PlanoTopologia> CachePlanos::Obtem(const Caixa &caixa) {
+  // As máscaras são baratas e bastam para a chave; apenas a enumeração das
+  // configurações válidas é evitada por um acerto
+  std::unique_ptr<PlanoTopologia> novo(new PlanoTopologia());
+  novo->CalculaMascaras(caixa);
+  ChaveCaixa chave = novo->CalculaChave();
+
+  {
+    std::lock_guard<std::mutex> guarda(trava_);
+    consultas_++;
+    auto em_memoria = indice_.find(chave);
+    if (em_memoria != indice_.end()) {
+      acertos_memoria_++;
+      recentes_.splice(recentes_.begin(), recentes_, em_memoria->second);
+      return em_memoria->second->second;
+    }
+  }
+
+  if (!diretorio_.empty()) {
+    std::shared_ptr<const PlanoTopologia> carregado = CarregaArquivo(chave);
+    if (carregado != nullptr) {
+      {
+        std::lock_guard<std::mutex> guarda(trava_);
+        acertos_disco_++;
+      }
+      return Insere(chave, std::move(carregado));
+    }
+  }
+
+  // O plano é calculado fora da trava; se outra thread calcular o mesmo plano
+  // ao mesmo tempo, fica valendo o primeiro inserido
+  novo->CalculaValidas();
+  if (!diretorio_.empty()) {
+    SalvaArquivo(chave, *novo);
+  }
+  return Insere(chave, std::shared_ptr<const PlanoTopologia>(novo.release()));
+}
+
+void CachePlanos::ImprimeEstatisticas(FILE *arquivo) {
+  std::lock_guard<std::mutex> guarda(trava_);
+  long long acertos = acertos_memoria_ + acertos_disco_;
+  fprintf(arquivo,
+          "planos: %lld consultas, %lld acertos em memória, %lld em disco, "
+          "taxa de acerto %.1f%%\n",
+          consultas_, acertos_memoria_, acertos_disco_,
+          consultas_ > 0 ? 100.0 * acertos / consultas_ : 0.0);
+}